@@ -0,0 +1,27 @@
+#pragma once
+
+// Minimal assertions for the host tests: a failed CHECK is reported and counted, the test
+// keeps going, and HOST_TEST_RESULT() turns the count into the exit status for ctest.
+
+#include <stdio.h>
+
+static int host_test_failures;
+
+#define CHECK(cond) do {                                                     \
+        if (!(cond)) {                                                       \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            host_test_failures++;                                            \
+        }                                                                    \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) do {                                      \
+        long long a_ = (long long)(actual), e_ = (long long)(expected);      \
+        if (a_ != e_) {                                                      \
+            fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %lld, expected %lld\n", \
+                    __FILE__, __LINE__, #actual, a_, e_);                    \
+            host_test_failures++;                                            \
+        }                                                                    \
+    } while (0)
+
+#define HOST_TEST_RESULT() \
+    (printf("%s\n", host_test_failures ? "FAILED" : "OK"), host_test_failures != 0)
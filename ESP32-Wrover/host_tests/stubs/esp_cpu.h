@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdint.h>
+
+// On the host one "cycle" is one nanosecond of the monotonic clock
+typedef uint32_t esp_cpu_cycle_count_t;
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT  (1 << 12)
+
+// With CONFIG_HEAP_USE_HOOKS the allocator calls this after every allocation.
+// On the host, tests that define it get it called by the malloc() shim in the test.
+void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps);
+
+// A 320 KB heap (the ESP32's internal RAM) minus what glibc has handed out
+size_t heap_caps_get_free_size(uint32_t caps);
+
+typedef struct {
+    size_t total_free_bytes;
+    size_t total_allocated_bytes;
+    size_t largest_free_block;
+    size_t minimum_free_bytes;
+    size_t allocated_blocks;
+    size_t free_blocks;
+    size_t total_blocks;
+} multi_heap_info_t;
+
+// From glibc's mallinfo2(), on the same 320 KB heap
+void heap_caps_get_info(multi_heap_info_t *info, uint32_t caps);
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "esp_err.h"
+
+// Requests are built by the test (host_http_request()) and the response is captured in the
+// request, so a handler can be called directly without a socket.
+
+typedef void *httpd_handle_t;
+
+typedef enum {
+    HTTP_GET = 1,
+    HTTP_POST = 3,
+} httpd_method_t;
+
+// The values are the HTTP status codes, so tests can compare with req->host_status
+typedef enum {
+    HTTPD_400_BAD_REQUEST = 400,
+    HTTPD_401_UNAUTHORIZED = 401,
+    HTTPD_403_FORBIDDEN = 403,
+    HTTPD_404_NOT_FOUND = 404,
+    HTTPD_408_REQ_TIMEOUT = 408,
+    HTTPD_500_INTERNAL_SERVER_ERROR = 500,
+} httpd_err_code_t;
+
+#define HTTPD_SOCK_ERR_FAIL     -1
+#define HTTPD_SOCK_ERR_INVALID  -2
+#define HTTPD_SOCK_ERR_TIMEOUT  -3
+#define HTTPD_RESP_USE_STRLEN   -1
+
+#define ESP_ERR_HTTPD_BASE          0xb000
+#define ESP_ERR_HTTPD_RESULT_TRUNC  (ESP_ERR_HTTPD_BASE + 6)
+
+#define HOST_HTTP_MAX_HEADERS 8
+#define HOST_HTTP_REPLY_MAX   1024
+
+typedef struct httpd_req {
+    httpd_handle_t handle;
+    int method;
+    char uri[64];
+    size_t content_len;
+    void *user_ctx;
+
+    // Host emulation
+    const char *host_body;
+    size_t host_body_pos;
+    size_t host_chunk;              // Most bytes one httpd_req_recv() returns (0: no limit)
+    int host_timeout_every;         // Every n-th httpd_req_recv() times out (0: never)
+    int host_recv_calls;
+    const char *host_headers[HOST_HTTP_MAX_HEADERS][2];
+    int host_status;                // 200 unless the handler set another status
+    char host_reply[HOST_HTTP_REPLY_MAX];
+    size_t host_reply_len;
+} httpd_req_t;
+
+typedef struct httpd_uri {
+    const char *uri;
+    httpd_method_t method;
+    esp_err_t (*handler)(httpd_req_t *req);
+    void *user_ctx;
+} httpd_uri_t;
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler);
+int httpd_req_recv(httpd_req_t *req, char *buf, size_t buf_len);
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *req, const char *field, char *val, size_t val_size);
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, size_t val_size);
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type);
+esp_err_t httpd_resp_set_status(httpd_req_t *req, const char *status);
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field, const char *value);
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t buf_len);
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t buf_len);
+esp_err_t httpd_resp_sendstr(httpd_req_t *req, const char *str);
+esp_err_t httpd_resp_sendstr_chunk(httpd_req_t *req, const char *str);
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *msg);
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "esp_attr.h"
+
+// Set HOST_LOG=0 in the environment to silence the firmware's own logging
+int host_log_enabled(void);
+
+#define HOST_LOG_(level, tag, format, ...) do {                              \
+        if (host_log_enabled()) {                                            \
+            printf(level " (%s) " format "\n", tag, ##__VA_ARGS__);          \
+        }                                                                    \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG_("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG_("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_LOG_("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) do { } while (0)
+#define ESP_LOGV(tag, format, ...) do { } while (0)
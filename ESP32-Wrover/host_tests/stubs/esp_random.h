@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Repeatable pseudo-random numbers (xorshift), not the hardware RNG
+uint32_t esp_random(void);
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define esp_rom_printf printf
+
+// 1000 on the host (cycles are nanoseconds), or the rate set with host_cpu_set_fake_cycles()
+uint32_t esp_rom_get_cpu_ticks_per_us(void);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "esp_err.h"
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+    ESP_SLEEP_WAKEUP_TOUCHPAD,
+    ESP_SLEEP_WAKEUP_ULP,
+} esp_sleep_wakeup_cause_t;
+
+// Always a cold boot on the host
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void);
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us);
+esp_err_t esp_sleep_enable_ulp_wakeup(void);
+
+// Advances the fake clock by the timer wakeup time
+esp_err_t esp_light_sleep_start(void);
+
+// There is no reboot on the host: the test program ends here
+void esp_deep_sleep_start(void) __attribute__((noreturn));
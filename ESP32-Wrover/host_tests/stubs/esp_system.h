@@ -0,0 +1,6 @@
+#pragma once
+
+#include "esp_err.h"
+
+// Returns on the host; host_restart_count() tells the test it was called
+void esp_restart(void);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_attr.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint8_t StackType_t;
+
+typedef struct { void *pad[16]; } StaticTask_t;
+typedef struct { void *pad[16]; } StaticQueue_t;
+typedef StaticQueue_t StaticSemaphore_t;
+
+#define configTICK_RATE_HZ   1000
+#define configRUN_TIME_COUNTER_TYPE uint32_t
+#define portNUM_PROCESSORS   2
+#define portTICK_PERIOD_MS   (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)    ((TickType_t)(ms) * configTICK_RATE_HZ / 1000)
+#define portMAX_DELAY        ((TickType_t)0xffffffffUL)
+#define pdTRUE               1
+#define pdFALSE              0
+#define pdPASS               pdTRUE
+#define pdFAIL               pdFALSE
+
+// The tests are single threaded, so critical sections are no-ops
+typedef struct { int owner; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portENTER_CRITICAL(mux)       (void)(mux)
+#define portEXIT_CRITICAL(mux)        (void)(mux)
+#define portENTER_CRITICAL_ISR(mux)   (void)(mux)
+#define portEXIT_CRITICAL_ISR(mux)    (void)(mux)
+#define portENTER_CRITICAL_SAFE(mux)  (void)(mux)
+#define portEXIT_CRITICAL_SAFE(mux)   (void)(mux)
+#define portDISABLE_INTERRUPTS()      do { } while (0)
+#define portENABLE_INTERRUPTS()       do { } while (0)
+#define portYIELD_FROM_ISR(x)         (void)(x)
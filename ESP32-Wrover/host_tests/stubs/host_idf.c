@@ -0,0 +1,1960 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "dht.h"
+#include "driver/adc.h"
+#include "driver/gpio.h"
+#include "driver/gptimer.h"
+#include "driver/ledc.h"
+#include "driver/uart.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_random.h"
+#include "esp_rom_crc.h"
+#include "esp_rom_sys.h"
+#include "esp_sleep.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "mbedtls/md.h"
+#include "mbedtls/sha256.h"
+#include "nvs_flash.h"
+#include "soc/gpio_periph.h"
+
+#include "host_idf.h"
+
+// ---- Errors and logging ----
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:                  return "ESP_OK";
+    case ESP_FAIL:                return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:          return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:     return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:   return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:    return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:       return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:   return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:         return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC:     return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_INVALID_VERSION: return "ESP_ERR_INVALID_VERSION";
+    case ESP_ERR_OTA_PARTITION_CONFLICT: return "ESP_ERR_OTA_PARTITION_CONFLICT";
+    case ESP_ERR_OTA_VALIDATE_FAILED: return "ESP_ERR_OTA_VALIDATE_FAILED";
+    case ESP_ERR_NVS_NOT_FOUND:   return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_READ_ONLY:   return "ESP_ERR_NVS_READ_ONLY";
+    case ESP_ERR_NVS_INVALID_HANDLE: return "ESP_ERR_NVS_INVALID_HANDLE";
+    case ESP_ERR_NVS_KEY_TOO_LONG: return "ESP_ERR_NVS_KEY_TOO_LONG";
+    case ESP_ERR_NVS_INVALID_LENGTH: return "ESP_ERR_NVS_INVALID_LENGTH";
+    case ESP_ERR_NVS_NOT_ENOUGH_SPACE: return "ESP_ERR_NVS_NOT_ENOUGH_SPACE";
+    default:                      return "UNKNOWN ERROR";
+    }
+}
+
+int host_log_enabled(void)
+{
+    static int enabled = -1;
+    if (enabled < 0) {
+        const char *env = getenv("HOST_LOG");
+        enabled = !(env && strcmp(env, "0") == 0);
+    }
+    return enabled;
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+// ---- Clock and timers ----
+
+#define MAX_TIMERS 16
+
+struct host_timer {
+    esp_timer_create_args_t args;
+    bool active;
+    int64_t due_us;
+    uint64_t period_us;     // 0 for one-shot
+};
+
+static struct host_timer timers[MAX_TIMERS];
+static size_t timer_count;
+static bool clock_fake;
+static int64_t fake_us;
+static uint32_t fake_cycles_mhz;
+static uint32_t fake_cycles;
+
+uint64_t host_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return clock_fake ? fake_us : (int64_t)(host_now_ns() / 1000);
+}
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void)
+{
+    return fake_cycles_mhz ? fake_cycles : (esp_cpu_cycle_count_t)host_now_ns();
+}
+
+uint32_t esp_rom_get_cpu_ticks_per_us(void)
+{
+    return fake_cycles_mhz ? fake_cycles_mhz : 1000;
+}
+
+void host_cpu_set_fake_cycles(uint32_t mhz)
+{
+    fake_cycles_mhz = mhz;
+}
+
+void host_cpu_set_cycles(uint32_t cycles)
+{
+    fake_cycles = cycles;
+}
+
+void host_clock_set_fake(int64_t start_us)
+{
+    clock_fake = true;
+    fake_us = start_us;
+}
+
+void host_clock_set_real(void)
+{
+    clock_fake = false;
+}
+
+void host_clock_advance_us(int64_t us)
+{
+    int64_t end = fake_us + us;
+    while (1) {
+        // Fire timers in order of their due time
+        struct host_timer *next = NULL;
+        for (size_t i = 0; i < timer_count; i++) {
+            if (timers[i].active && timers[i].due_us <= end &&
+                (next == NULL || timers[i].due_us < next->due_us)) {
+                next = &timers[i];
+            }
+        }
+        if (next == NULL) {
+            break;
+        }
+        if (next->due_us > fake_us) {
+            fake_us = next->due_us;
+        }
+        if (next->period_us) {
+            next->due_us += next->period_us;
+        } else {
+            next->active = false;
+        }
+        next->args.callback(next->args.arg);
+    }
+    fake_us = end;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out)
+{
+    if (timer_count == MAX_TIMERS) {
+        return ESP_ERR_NO_MEM;
+    }
+    timers[timer_count].args = *args;
+    timers[timer_count].active = false;
+    *out = &timers[timer_count++];
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = true;
+    timer->due_us = esp_timer_get_time() + (int64_t)timeout_us;
+    timer->period_us = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = true;
+    timer->due_us = esp_timer_get_time() + (int64_t)period_us;
+    timer->period_us = period_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer->active;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    timer->active = false;
+    return ESP_OK;
+}
+
+// ---- Sleep ----
+
+static uint64_t sleep_timer_us;
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void)
+{
+    return ESP_SLEEP_WAKEUP_UNDEFINED;
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us)
+{
+    sleep_timer_us = time_in_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_ulp_wakeup(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_light_sleep_start(void)
+{
+    if (clock_fake) {
+        host_clock_advance_us((int64_t)sleep_timer_us);
+    }
+    return ESP_OK;
+}
+
+void esp_deep_sleep_start(void)
+{
+    printf("esp_deep_sleep_start(): end of the host run\n");
+    exit(0);
+}
+
+// ---- Semaphores ----
+
+#define MAX_SEMAPHORES 256
+
+struct host_semaphore {
+    int count;
+    int max;
+};
+
+static struct host_semaphore semaphores[MAX_SEMAPHORES];
+static size_t semaphore_count;
+
+static SemaphoreHandle_t new_semaphore(int count, int max)
+{
+    if (semaphore_count == MAX_SEMAPHORES) {
+        return NULL;
+    }
+    semaphores[semaphore_count].count = count;
+    semaphores[semaphore_count].max = max;
+    return &semaphores[semaphore_count++];
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return new_semaphore(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer)
+{
+    return new_semaphore(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return new_semaphore(0, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    if (sem->count == 0) {
+        return pdFALSE;
+    }
+    sem->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem->count == sem->max) {
+        return pdFALSE;
+    }
+    sem->count++;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *woken)
+{
+    return xSemaphoreGive(sem);
+}
+
+// ---- File-backed flash ----
+
+#define MAX_PARTITIONS 8
+#define SECTOR_SIZE    4096
+
+typedef struct {
+    esp_partition_t part;
+    int fd;
+    uint64_t fail_after;        // UINT64_MAX: no power cut armed
+    host_partition_stats_t stats;
+} host_partition_t;
+
+static host_partition_t partitions[MAX_PARTITIONS];
+static size_t partition_count;
+
+static host_partition_t *lookup(const esp_partition_t *part)
+{
+    return (host_partition_t *)part;   // part is the first member
+}
+
+static void fill_erased(int fd, size_t offset, size_t size)
+{
+    uint8_t block[SECTOR_SIZE];
+    memset(block, 0xFF, sizeof(block));
+    for (size_t done = 0; done < size; done += sizeof(block)) {
+        size_t n = size - done < sizeof(block) ? size - done : sizeof(block);
+        if (pwrite(fd, block, n, offset + done) != (ssize_t)n) {
+            abort();
+        }
+    }
+}
+
+const esp_partition_t *host_partition_add(const char *label, esp_partition_type_t type,
+                                          esp_partition_subtype_t subtype, uint32_t size,
+                                          const char *path)
+{
+    host_partition_t *p = NULL;
+    for (size_t i = 0; i < partition_count; i++) {
+        if (strcmp(partitions[i].part.label, label) == 0) {
+            p = &partitions[i];
+            close(p->fd);
+        }
+    }
+    if (p == NULL) {
+        if (partition_count == MAX_PARTITIONS) {
+            return NULL;
+        }
+        p = &partitions[partition_count++];
+    }
+
+    memset(p, 0, sizeof(*p));
+    p->part.type = type;
+    p->part.subtype = subtype;
+    p->part.address = 0x10000 * (uint32_t)(p - partitions + 1);
+    p->part.size = size;
+    p->part.erase_size = SECTOR_SIZE;
+    strncpy(p->part.label, label, sizeof(p->part.label) - 1);
+    p->fail_after = UINT64_MAX;
+
+    p->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (p->fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(p->fd, &st) != 0 || st.st_size != (off_t)size) {
+        if (ftruncate(p->fd, 0) != 0) {
+            return NULL;
+        }
+        fill_erased(p->fd, 0, size);
+    }
+    return &p->part;
+}
+
+void host_partition_wipe(const esp_partition_t *part)
+{
+    fill_erased(lookup(part)->fd, 0, part->size);
+}
+
+void host_partition_fail_after(const esp_partition_t *part, uint64_t bytes)
+{
+    lookup(part)->fail_after = bytes;
+}
+
+void host_partition_get_stats(const esp_partition_t *part, host_partition_stats_t *stats)
+{
+    *stats = lookup(part)->stats;
+}
+
+void host_partition_reset_stats(const esp_partition_t *part)
+{
+    memset(&lookup(part)->stats, 0, sizeof(host_partition_stats_t));
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype, const char *label)
+{
+    for (host_partition_t *p = partitions; p < partitions + partition_count; p++) {
+        if ((type == ESP_PARTITION_TYPE_ANY || p->part.type == type) &&
+            (subtype == ESP_PARTITION_SUBTYPE_ANY || p->part.subtype == subtype) &&
+            (label == NULL || strncmp(p->part.label, label, sizeof(p->part.label)) == 0)) {
+            return &p->part;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t size)
+{
+    if (offset > part->size || size > part->size - offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    host_partition_t *p = lookup(part);
+    if (pread(p->fd, dst, size, offset) != (ssize_t)size) {
+        return ESP_FAIL;
+    }
+    p->stats.bytes_read += size;
+    return ESP_OK;
+}
+
+// NOR flash can only clear bits: the result is the old contents AND the new data
+esp_err_t esp_partition_write(const esp_partition_t *part, size_t offset, const void *src, size_t size)
+{
+    if (offset > part->size || size > part->size - offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    host_partition_t *p = lookup(part);
+    p->stats.write_calls++;
+
+    bool cut = size > p->fail_after;
+    size_t n = cut ? (size_t)p->fail_after : size;
+    if (p->fail_after != UINT64_MAX) {
+        p->fail_after -= n;
+    }
+
+    const uint8_t *in = src;
+    uint8_t block[SECTOR_SIZE];
+    for (size_t done = 0; done < n; done += sizeof(block)) {
+        size_t chunk = n - done < sizeof(block) ? n - done : sizeof(block);
+        if (pread(p->fd, block, chunk, offset + done) != (ssize_t)chunk) {
+            return ESP_FAIL;
+        }
+        for (size_t i = 0; i < chunk; i++) {
+            block[i] &= in[done + i];
+        }
+        if (pwrite(p->fd, block, chunk, offset + done) != (ssize_t)chunk) {
+            return ESP_FAIL;
+        }
+    }
+    p->stats.bytes_written += n;
+    return cut ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *part, size_t offset, size_t size)
+{
+    if (offset % SECTOR_SIZE || size % SECTOR_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (offset > part->size || size > part->size - offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    host_partition_t *p = lookup(part);
+    fill_erased(p->fd, offset, size);
+    p->stats.bytes_erased += size;
+    p->stats.erase_calls++;
+    return ESP_OK;
+}
+
+// ---- Tasks, heap, restart ----
+
+#define HOST_HEAP_SIZE (320 * 1024)
+
+static int restart_count;
+
+#define MAX_TASKS 32
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+    char name[16];
+    UBaseType_t priority;
+    uint32_t stack_depth;
+    volatile bool ended;
+};
+
+static struct host_task main_task = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .name = "main",
+    .priority = 1,
+    .stack_depth = 3584,
+};
+static __thread struct host_task *current_task;
+
+static pthread_mutex_t task_list_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct host_task *task_list[MAX_TASKS];
+static size_t task_list_count;
+
+static void *task_entry(void *arg)
+{
+    struct host_task *task = arg;
+    current_task = task;
+    task->fn(task->arg);
+    task->ended = true;
+    return NULL;    // A FreeRTOS task must not return, but on the host it just ends
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *created)
+{
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    snprintf(task->name, sizeof(task->name), "%s", name);
+    task->priority = priority;
+    task->stack_depth = stack_depth;
+    pthread_mutex_lock(&task_list_lock);
+    if (task_list_count < MAX_TASKS) {
+        task_list[task_list_count++] = task;
+    }
+    pthread_mutex_unlock(&task_list_lock);
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_cond_init(&task->cond, NULL);
+    if (created) {
+        *created = task;    // Before the thread runs, as FreeRTOS does
+    }
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *created, BaseType_t core_id)
+{
+    return xTaskCreate(fn, name, stack_depth, arg, priority, created);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return current_task ? current_task : &main_task;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    xTaskNotifyGive(task);
+    if (woken) {
+        *woken = pdTRUE;
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    struct host_task *task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    uint64_t ns = (uint64_t)deadline.tv_nsec + (uint64_t)ticks_to_wait * portTICK_PERIOD_MS * 1000000ull;
+    deadline.tv_sec += ns / 1000000000ull;
+    deadline.tv_nsec = ns % 1000000000ull;
+
+    pthread_mutex_lock(&task->lock);
+    while (task->notify == 0 && ticks_to_wait > 0) {
+        int err = ticks_to_wait == portMAX_DELAY ? pthread_cond_wait(&task->cond, &task->lock)
+                  : pthread_cond_timedwait(&task->cond, &task->lock, &deadline);
+        if (err == ETIMEDOUT) {
+            break;
+        }
+    }
+    uint32_t value = task->notify;
+    if (value) {
+        task->notify = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (clock_fake) {
+        host_clock_advance_us((int64_t)ticks * portTICK_PERIOD_MS * 1000);
+    } else {
+        struct timespec ts = { .tv_sec = ticks * portTICK_PERIOD_MS / 1000,
+                               .tv_nsec = (long)(ticks * portTICK_PERIOD_MS % 1000) * 1000000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000 / portTICK_PERIOD_MS);
+}
+
+static uint32_t thread_cpu_us(pthread_t thread)
+{
+    clockid_t clock;
+    struct timespec ts;
+    if (pthread_getcpuclockid(thread, &clock) != 0 || clock_gettime(clock, &ts) != 0) {
+        return 0;
+    }
+    return (uint32_t)(ts.tv_sec * 1000000ull + ts.tv_nsec / 1000);
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t size,
+                                 configRUN_TIME_COUNTER_TYPE *total_run_time)
+{
+    UBaseType_t count = 0;
+    if (main_task.thread == 0) {
+        main_task.thread = pthread_self();    // The first caller is the test's main thread
+    }
+    pthread_mutex_lock(&task_list_lock);
+    for (size_t i = 0; i <= task_list_count && count < size; i++) {
+        struct host_task *task = i == 0 ? &main_task : task_list[i - 1];
+        if (task->ended) {
+            continue;
+        }
+        status[count++] = (TaskStatus_t){
+            .xHandle = task,
+            .pcTaskName = task->name,
+            .xTaskNumber = i,
+            .eCurrentState = task == xTaskGetCurrentTaskHandle() ? eRunning : eBlocked,
+            .uxCurrentPriority = task->priority,
+            .uxBasePriority = task->priority,
+            .ulRunTimeCounter = thread_cpu_us(task->thread),
+            .usStackHighWaterMark = task->stack_depth,
+        };
+    }
+    pthread_mutex_unlock(&task_list_lock);
+    if (total_run_time) {
+        *total_run_time = (uint32_t)(host_now_ns() / 1000);
+    }
+    return count;
+}
+
+void heap_caps_get_info(multi_heap_info_t *info, uint32_t caps)
+{
+    struct mallinfo2 mi = mallinfo2();
+    size_t free_bytes = heap_caps_get_free_size(caps);
+    *info = (multi_heap_info_t){
+        .total_free_bytes = free_bytes,
+        .total_allocated_bytes = mi.uordblks,
+        .largest_free_block = free_bytes,
+        .minimum_free_bytes = free_bytes,
+        .allocated_blocks = mi.hblks + 1,
+        .free_blocks = mi.ordblks,
+        .total_blocks = mi.hblks + 1 + mi.ordblks,
+    };
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    size_t used = mallinfo2().uordblks;
+    return used < HOST_HEAP_SIZE ? HOST_HEAP_SIZE - used : 0;
+}
+
+void esp_restart(void)
+{
+    restart_count++;
+}
+
+int host_restart_count(void)
+{
+    return restart_count;
+}
+
+// ---- OTA ----
+
+static const esp_partition_t *ota_running;
+static const esp_partition_t *ota_boot;
+
+static struct {
+    const esp_partition_t *part;
+    bool sequential;
+    size_t written;
+    size_t erased;          // Sectors below this offset are erased
+} ota;
+
+void host_ota_set_running(const esp_partition_t *part)
+{
+    ota_running = part;
+}
+
+const esp_partition_t *esp_ota_get_running_partition(void)
+{
+    if (ota_running == NULL) {
+        ota_running = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_FACTORY, NULL);
+    }
+    return ota_running;
+}
+
+const esp_partition_t *esp_ota_get_boot_partition(void)
+{
+    return ota_boot ? ota_boot : esp_ota_get_running_partition();
+}
+
+// ota_0 and ota_1 take turns
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+    const esp_partition_t *from = start_from ? start_from : esp_ota_get_running_partition();
+    esp_partition_subtype_t next = (from && from->subtype == ESP_PARTITION_SUBTYPE_APP_OTA_0)
+                                   ? ESP_PARTITION_SUBTYPE_APP_OTA_1 : ESP_PARTITION_SUBTYPE_APP_OTA_0;
+    return esp_partition_find_first(ESP_PARTITION_TYPE_APP, next, NULL);
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle)
+{
+    if (partition == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (partition == esp_ota_get_running_partition()) {
+        return ESP_ERR_OTA_PARTITION_CONFLICT;
+    }
+    memset(&ota, 0, sizeof(ota));
+    ota.part = partition;
+    ota.sequential = image_size == OTA_WITH_SEQUENTIAL_WRITES;
+    if (!ota.sequential) {
+        size_t size = image_size == OTA_SIZE_UNKNOWN ? partition->size
+                      : (image_size + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE;
+        esp_err_t err = esp_partition_erase_range(partition, 0, size);
+        if (err != ESP_OK) {
+            return err;
+        }
+        ota.erased = size;
+    }
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
+{
+    if (handle != 1 || ota.part == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (ota.written == 0 && size > 0 && *(const uint8_t *)data != ESP_IMAGE_HEADER_MAGIC) {
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    if (size > ota.part->size - ota.written) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    // Sequential writes erase each sector when the data first reaches it
+    while (ota.erased < ota.written + size) {
+        esp_err_t err = esp_partition_erase_range(ota.part, ota.erased, SECTOR_SIZE);
+        if (err != ESP_OK) {
+            return err;
+        }
+        ota.erased += SECTOR_SIZE;
+    }
+    esp_err_t err = esp_partition_write(ota.part, ota.written, data, size);
+    if (err == ESP_OK) {
+        ota.written += size;
+    }
+    return err;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle)
+{
+    if (handle != 1 || ota.part == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = ota.written > 0 ? ESP_OK : ESP_ERR_OTA_VALIDATE_FAILED;
+    ota.part = NULL;
+    return err;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle)
+{
+    ota.part = NULL;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition)
+{
+    uint8_t magic;
+    if (esp_partition_read(partition, 0, &magic, 1) != ESP_OK || magic != ESP_IMAGE_HEADER_MAGIC) {
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    ota_boot = partition;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void)
+{
+    return ESP_OK;
+}
+
+// ---- HTTP server ----
+
+#define MAX_URI_HANDLERS 16
+
+static httpd_uri_t uri_handlers[MAX_URI_HANDLERS];
+static size_t uri_handler_count;
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler)
+{
+    for (size_t i = 0; i < uri_handler_count; i++) {
+        if (uri_handlers[i].method == uri_handler->method && strcmp(uri_handlers[i].uri, uri_handler->uri) == 0) {
+            uri_handlers[i] = *uri_handler;     // Registered again by a re-run of the test setup
+            return ESP_OK;
+        }
+    }
+    if (uri_handler_count == MAX_URI_HANDLERS) {
+        return ESP_ERR_NO_MEM;
+    }
+    uri_handlers[uri_handler_count++] = *uri_handler;
+    return ESP_OK;
+}
+
+void host_http_request(httpd_req_t *req, httpd_method_t method, const char *uri,
+                       const void *body, size_t len)
+{
+    memset(req, 0, sizeof(*req));
+    req->method = method;
+    strncpy(req->uri, uri, sizeof(req->uri) - 1);
+    req->content_len = len;
+    req->host_body = body;
+    req->host_status = 200;
+}
+
+void host_http_add_header(httpd_req_t *req, const char *field, const char *value)
+{
+    for (int i = 0; i < HOST_HTTP_MAX_HEADERS; i++) {
+        if (req->host_headers[i][0] == NULL) {
+            req->host_headers[i][0] = field;
+            req->host_headers[i][1] = value;
+            return;
+        }
+    }
+    abort();
+}
+
+esp_err_t host_http_call(httpd_req_t *req)
+{
+    for (size_t i = 0; i < uri_handler_count; i++) {
+        if ((int)uri_handlers[i].method == req->method && strcmp(uri_handlers[i].uri, req->uri) == 0) {
+            req->user_ctx = uri_handlers[i].user_ctx;
+            return uri_handlers[i].handler(req);
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+int httpd_req_recv(httpd_req_t *req, char *buf, size_t buf_len)
+{
+    req->host_recv_calls++;
+    if (req->host_timeout_every && req->host_recv_calls % req->host_timeout_every == 0) {
+        return HTTPD_SOCK_ERR_TIMEOUT;
+    }
+    size_t n = req->content_len - req->host_body_pos;
+    if (n > buf_len) {
+        n = buf_len;
+    }
+    if (req->host_chunk && n > req->host_chunk) {
+        n = req->host_chunk;
+    }
+    if (n == 0) {
+        return 0;       // Connection closed
+    }
+    memcpy(buf, req->host_body + req->host_body_pos, n);
+    req->host_body_pos += n;
+    return (int)n;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *req, const char *field, char *val, size_t val_size)
+{
+    for (int i = 0; i < HOST_HTTP_MAX_HEADERS && req->host_headers[i][0]; i++) {
+        if (strcasecmp(req->host_headers[i][0], field) == 0) {
+            snprintf(val, val_size, "%s", req->host_headers[i][1]);
+            return strlen(req->host_headers[i][1]) < val_size ? ESP_OK : ESP_ERR_HTTPD_RESULT_TRUNC;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, size_t val_size)
+{
+    size_t key_len = strlen(key);
+    for (const char *p = qry; p && *p; p = strchr(p, '&') ? strchr(p, '&') + 1 : NULL) {
+        if (strncmp(p, key, key_len) == 0 && p[key_len] == '=') {
+            const char *value = p + key_len + 1;
+            size_t len = strcspn(value, "&");
+            snprintf(val, val_size, "%.*s", (int)len, value);
+            return len < val_size ? ESP_OK : ESP_ERR_HTTPD_RESULT_TRUNC;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type)
+{
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t *req, const char *status)
+{
+    req->host_status = atoi(status);
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field, const char *value)
+{
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t buf_len)
+{
+    if (buf == NULL) {
+        return ESP_OK;      // End of a chunked response
+    }
+    size_t len = buf_len == HTTPD_RESP_USE_STRLEN ? strlen(buf) : (size_t)buf_len;
+    size_t room = sizeof(req->host_reply) - 1 - req->host_reply_len;
+    if (len > room) {
+        len = room;
+    }
+    memcpy(req->host_reply + req->host_reply_len, buf, len);
+    req->host_reply_len += len;
+    req->host_reply[req->host_reply_len] = '\0';
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t buf_len)
+{
+    req->host_reply_len = 0;
+    req->host_reply[0] = '\0';
+    return httpd_resp_send_chunk(req, buf, buf_len);
+}
+
+esp_err_t httpd_resp_sendstr(httpd_req_t *req, const char *str)
+{
+    return httpd_resp_send(req, str, HTTPD_RESP_USE_STRLEN);
+}
+
+esp_err_t httpd_resp_sendstr_chunk(httpd_req_t *req, const char *str)
+{
+    return httpd_resp_send_chunk(req, str, HTTPD_RESP_USE_STRLEN);
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *msg)
+{
+    req->host_status = error;
+    return httpd_resp_sendstr(req, msg);
+}
+
+// ---- SHA-256 and HMAC (FIPS 180-4, RFC 2104) ----
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(mbedtls_sha256_context *ctx, const uint8_t *p)
+{
+    uint32_t w[64], s[8];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)p[4 * i] << 24 | p[4 * i + 1] << 16 | p[4 * i + 2] << 8 | p[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ROR32(w[i - 15], 7) ^ ROR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROR32(w[i - 2], 17) ^ ROR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    memcpy(s, ctx->state, sizeof(s));
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = s[7] + (ROR32(s[4], 6) ^ ROR32(s[4], 11) ^ ROR32(s[4], 25)) +
+                      ((s[4] & s[5]) ^ (~s[4] & s[6])) + sha256_k[i] + w[i];
+        uint32_t t2 = (ROR32(s[0], 2) ^ ROR32(s[0], 13) ^ ROR32(s[0], 22)) +
+                      ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+        memmove(s + 1, s, 7 * sizeof(uint32_t));
+        s[4] += t1;
+        s[0] = t1 + t2;
+    }
+    for (int i = 0; i < 8; i++) {
+        ctx->state[i] += s[i];
+    }
+}
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224)
+{
+    static const uint32_t init[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    if (is224) {
+        return -1;
+    }
+    memcpy(ctx->state, init, sizeof(init));
+    ctx->total = 0;
+    return 0;
+}
+
+int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input, size_t ilen)
+{
+    size_t fill = ctx->total % 64;
+    ctx->total += ilen;
+    if (fill && fill + ilen >= 64) {
+        memcpy(ctx->buffer + fill, input, 64 - fill);
+        sha256_block(ctx, ctx->buffer);
+        input += 64 - fill;
+        ilen -= 64 - fill;
+        fill = 0;
+    }
+    for (; fill == 0 && ilen >= 64; input += 64, ilen -= 64) {
+        sha256_block(ctx, input);
+    }
+    memcpy(ctx->buffer + fill, input, ilen);
+    return 0;
+}
+
+int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char output[32])
+{
+    uint64_t bits = ctx->total * 8;
+    uint8_t pad[72] = { 0x80 };
+    size_t pad_len = (ctx->total % 64 < 56 ? 56 : 120) - ctx->total % 64;
+    for (int i = 0; i < 8; i++) {
+        pad[pad_len + i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+    mbedtls_sha256_update(ctx, pad, pad_len + 8);
+    for (int i = 0; i < 8; i++) {
+        output[4 * i] = ctx->state[i] >> 24;
+        output[4 * i + 1] = ctx->state[i] >> 16;
+        output[4 * i + 2] = ctx->state[i] >> 8;
+        output[4 * i + 3] = ctx->state[i];
+    }
+    return 0;
+}
+
+int mbedtls_sha256(const unsigned char *input, size_t ilen, unsigned char output[32], int is224)
+{
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    int ret = mbedtls_sha256_starts(&ctx, is224);
+    if (ret == 0) {
+        mbedtls_sha256_update(&ctx, input, ilen);
+        mbedtls_sha256_finish(&ctx, output);
+    }
+    mbedtls_sha256_free(&ctx);
+    return ret;
+}
+
+static const struct mbedtls_md_info_t { int type; } sha256_info = { MBEDTLS_MD_SHA256 };
+
+const mbedtls_md_info_t *mbedtls_md_info_from_type(mbedtls_md_type_t md_type)
+{
+    return md_type == MBEDTLS_MD_SHA256 ? &sha256_info : NULL;
+}
+
+int mbedtls_md_hmac(const mbedtls_md_info_t *md_info, const unsigned char *key, size_t keylen,
+                    const unsigned char *input, size_t ilen, unsigned char *output)
+{
+    uint8_t k[64] = { 0 }, pad[64], inner[32];
+    mbedtls_sha256_context ctx;
+
+    if (md_info != &sha256_info) {
+        return -1;
+    }
+    if (keylen > sizeof(k)) {
+        mbedtls_sha256(key, keylen, k, 0);
+    } else {
+        memcpy(k, key, keylen);
+    }
+
+    for (int i = 0; i < 64; i++) {
+        pad[i] = k[i] ^ 0x36;
+    }
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    mbedtls_sha256_update(&ctx, pad, sizeof(pad));
+    mbedtls_sha256_update(&ctx, input, ilen);
+    mbedtls_sha256_finish(&ctx, inner);
+
+    for (int i = 0; i < 64; i++) {
+        pad[i] = k[i] ^ 0x5c;
+    }
+    mbedtls_sha256_starts(&ctx, 0);
+    mbedtls_sha256_update(&ctx, pad, sizeof(pad));
+    mbedtls_sha256_update(&ctx, inner, sizeof(inner));
+    mbedtls_sha256_finish(&ctx, output);
+    mbedtls_sha256_free(&ctx);
+    return 0;
+}
+
+// ---- GPIO, ADC, DHT, UART, RNG ----
+
+static uint8_t gpio_levels[GPIO_NUM_MAX];
+static struct {
+    gpio_isr_t fn;
+    void *arg;
+    gpio_int_type_t type;
+    bool enabled;
+} gpio_intr[GPIO_NUM_MAX];
+static bool gpio_isr_service;
+
+gpio_dev_t GPIO;
+const uint32_t GPIO_PIN_MUX_REG[GPIO_NUM_MAX];
+static int adc_raw[ADC1_CHANNEL_MAX];
+static struct {
+    float temperature, humidity;
+    esp_err_t result;
+} dht_reading = { 22.0f, 40.0f, ESP_OK };
+
+#define UART_BUF_SIZE 4096
+
+static struct {
+    uint8_t out[UART_BUF_SIZE];
+    size_t out_len;
+    uint8_t in[UART_BUF_SIZE];
+    size_t in_len, in_pos;
+    uint32_t baud;
+} uarts[UART_NUM_MAX];
+
+void host_gpio_set_input(gpio_num_t gpio, int level)
+{
+    gpio_levels[gpio] = level != 0;
+}
+
+int host_gpio_get_output(gpio_num_t gpio)
+{
+    return gpio_levels[gpio];
+}
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    return config->pin_bit_mask >> GPIO_NUM_MAX ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+    return GPIO_IS_VALID_GPIO(gpio_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    if (!GPIO_IS_VALID_GPIO(gpio_num) || ((mode & GPIO_MODE_OUTPUT) && !GPIO_IS_VALID_OUTPUT_GPIO(gpio_num))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, gpio_pull_mode_t pull)
+{
+    return GPIO_IS_VALID_GPIO(gpio_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (!GPIO_IS_VALID_OUTPUT_GPIO(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_levels[gpio_num] = level != 0;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    return GPIO_IS_VALID_GPIO(gpio_num) ? gpio_levels[gpio_num] : 0;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    if (gpio_isr_service) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    gpio_isr_service = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args)
+{
+    if (!gpio_isr_service) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!GPIO_IS_VALID_GPIO(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_intr[gpio_num].fn = isr_handler;
+    gpio_intr[gpio_num].arg = args;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+    if (!GPIO_IS_VALID_GPIO(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_intr[gpio_num].fn = NULL;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+    if (!GPIO_IS_VALID_GPIO(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_intr[gpio_num].type = intr_type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num)
+{
+    if (!GPIO_IS_VALID_GPIO(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_intr[gpio_num].enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num)
+{
+    if (!GPIO_IS_VALID_GPIO(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_intr[gpio_num].enabled = false;
+    return ESP_OK;
+}
+
+bool host_gpio_trigger(gpio_num_t gpio, int level)
+{
+    gpio_levels[gpio] = level != 0;
+    gpio_int_type_t type = gpio_intr[gpio].type;
+    bool match = type == GPIO_INTR_ANYEDGE || (type == GPIO_INTR_POSEDGE && level) ||
+                 (type == GPIO_INTR_NEGEDGE && !level) || (type == GPIO_INTR_HIGH_LEVEL && level) ||
+                 (type == GPIO_INTR_LOW_LEVEL && !level);
+    if (!gpio_intr[gpio].enabled || gpio_intr[gpio].fn == NULL || !match) {
+        return false;
+    }
+    gpio_intr[gpio].fn(gpio_intr[gpio].arg);
+    return true;
+}
+
+void host_adc_set_raw(adc1_channel_t channel, int raw)
+{
+    adc_raw[channel] = raw;
+}
+
+// ---- LEDC and gptimer ----
+
+static struct {
+    uint32_t freq_hz;
+    uint32_t resolution;
+} ledc_timers[LEDC_SPEED_MODE_MAX][LEDC_TIMER_MAX];
+
+static struct {
+    host_ledc_channel_t running;
+    uint32_t duty, hpoint;      // Set, not yet updated
+} ledc_channels[LEDC_SPEED_MODE_MAX][LEDC_CHANNEL_MAX];
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *timer_conf)
+{
+    if (timer_conf->speed_mode >= LEDC_SPEED_MODE_MAX || timer_conf->timer_num >= LEDC_TIMER_MAX ||
+        timer_conf->freq_hz == 0 || timer_conf->duty_resolution >= LEDC_TIMER_BIT_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ledc_timers[timer_conf->speed_mode][timer_conf->timer_num].freq_hz = timer_conf->freq_hz;
+    ledc_timers[timer_conf->speed_mode][timer_conf->timer_num].resolution = timer_conf->duty_resolution;
+    return ESP_OK;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *ledc_conf)
+{
+    if (ledc_conf->speed_mode >= LEDC_SPEED_MODE_MAX || ledc_conf->channel >= LEDC_CHANNEL_MAX ||
+        ledc_conf->timer_sel >= LEDC_TIMER_MAX || !GPIO_IS_VALID_OUTPUT_GPIO(ledc_conf->gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ledc_channels[ledc_conf->speed_mode][ledc_conf->channel].running = (host_ledc_channel_t){
+        .gpio = ledc_conf->gpio_num,
+        .timer = ledc_conf->timer_sel,
+        .duty = ledc_conf->duty,
+        .hpoint = ledc_conf->hpoint,
+    };
+    ledc_channels[ledc_conf->speed_mode][ledc_conf->channel].duty = ledc_conf->duty;
+    ledc_channels[ledc_conf->speed_mode][ledc_conf->channel].hpoint = ledc_conf->hpoint;
+    return ESP_OK;
+}
+
+esp_err_t ledc_timer_rst(ledc_mode_t speed_mode, ledc_timer_t timer_sel)
+{
+    return speed_mode < LEDC_SPEED_MODE_MAX && timer_sel < LEDC_TIMER_MAX ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t ledc_set_freq(ledc_mode_t speed_mode, ledc_timer_t timer_num, uint32_t freq_hz)
+{
+    if (speed_mode >= LEDC_SPEED_MODE_MAX || timer_num >= LEDC_TIMER_MAX || freq_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ledc_timers[speed_mode][timer_num].freq_hz = freq_hz;
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_duty_with_hpoint(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty, uint32_t hpoint)
+{
+    if (speed_mode >= LEDC_SPEED_MODE_MAX || channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t resolution = ledc_timers[speed_mode][ledc_channels[speed_mode][channel].running.timer].resolution;
+    if (duty > (1u << resolution) || hpoint >= (1u << resolution)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ledc_channels[speed_mode][channel].duty = duty;
+    ledc_channels[speed_mode][channel].hpoint = hpoint;
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty)
+{
+    if (speed_mode >= LEDC_SPEED_MODE_MAX || channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ledc_set_duty_with_hpoint(speed_mode, channel, duty, ledc_channels[speed_mode][channel].hpoint);
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    if (speed_mode >= LEDC_SPEED_MODE_MAX || channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ledc_channels[speed_mode][channel].running.duty = ledc_channels[speed_mode][channel].duty;
+    ledc_channels[speed_mode][channel].running.hpoint = ledc_channels[speed_mode][channel].hpoint;
+    return ESP_OK;
+}
+
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    return ledc_channels[speed_mode][channel].running.duty;
+}
+
+void host_ledc_get_channel(ledc_mode_t mode, ledc_channel_t channel, host_ledc_channel_t *out)
+{
+    *out = ledc_channels[mode][channel].running;
+}
+
+uint32_t host_ledc_get_freq(ledc_mode_t mode, ledc_timer_t timer)
+{
+    return ledc_timers[mode][timer].freq_hz;
+}
+
+uint32_t host_ledc_get_resolution(ledc_mode_t mode, ledc_timer_t timer)
+{
+    return ledc_timers[mode][timer].resolution;
+}
+
+typedef enum { TIMER_INIT, TIMER_ENABLED, TIMER_RUNNING } gptimer_state_t;
+
+struct gptimer_t {
+    gptimer_config_t config;
+    gptimer_alarm_config_t alarm;
+    gptimer_event_callbacks_t callbacks;
+    void *user_data;
+    gptimer_state_t state;
+    uint64_t count;
+};
+
+static struct gptimer_t *last_gptimer;
+static esp_err_t gptimer_start_error = ESP_OK;
+
+esp_err_t gptimer_new_timer(const gptimer_config_t *config, gptimer_handle_t *ret_timer)
+{
+    if (config->resolution_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct gptimer_t *timer = calloc(1, sizeof(*timer));
+    if (timer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->config = *config;
+    last_gptimer = timer;
+    *ret_timer = timer;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_del_timer(gptimer_handle_t timer)
+{
+    if (timer->state != TIMER_INIT) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (last_gptimer == timer) {
+        last_gptimer = NULL;
+    }
+    free(timer);
+    return ESP_OK;
+}
+
+esp_err_t gptimer_register_event_callbacks(gptimer_handle_t timer, const gptimer_event_callbacks_t *cbs, void *user_data)
+{
+    if (timer->state != TIMER_INIT) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->callbacks = *cbs;
+    timer->user_data = user_data;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_set_alarm_action(gptimer_handle_t timer, const gptimer_alarm_config_t *config)
+{
+    timer->alarm = *config;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_enable(gptimer_handle_t timer)
+{
+    if (timer->state != TIMER_INIT) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->state = TIMER_ENABLED;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_disable(gptimer_handle_t timer)
+{
+    if (timer->state != TIMER_ENABLED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->state = TIMER_INIT;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_start(gptimer_handle_t timer)
+{
+    esp_err_t err = gptimer_start_error;
+    gptimer_start_error = ESP_OK;
+    if (err == ESP_OK && timer->state != TIMER_ENABLED) {
+        err = ESP_ERR_INVALID_STATE;
+    }
+    if (err == ESP_OK) {
+        timer->state = TIMER_RUNNING;
+    }
+    return err;
+}
+
+esp_err_t gptimer_stop(gptimer_handle_t timer)
+{
+    if (timer->state != TIMER_RUNNING) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->state = TIMER_ENABLED;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_get_raw_count(gptimer_handle_t timer, uint64_t *value)
+{
+    *value = timer->count;
+    return ESP_OK;
+}
+
+bool host_gptimer_alarm(uint64_t count)
+{
+    struct gptimer_t *timer = last_gptimer;
+    if (timer == NULL || timer->state != TIMER_RUNNING || timer->callbacks.on_alarm == NULL) {
+        return false;
+    }
+    gptimer_alarm_event_data_t event = {
+        .count_value = timer->alarm.alarm_count,
+        .alarm_value = timer->alarm.alarm_count,
+    };
+    timer->count = count;
+    return timer->callbacks.on_alarm(timer, &event, timer->user_data);
+}
+
+void host_gptimer_fail_next_start(esp_err_t err)
+{
+    gptimer_start_error = err;
+}
+
+esp_err_t adc1_config_width(adc_bits_width_t width_bit)
+{
+    return ESP_OK;
+}
+
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten)
+{
+    return channel < ADC1_CHANNEL_MAX ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int adc1_get_raw(adc1_channel_t channel)
+{
+    return channel < ADC1_CHANNEL_MAX ? adc_raw[channel] : -1;
+}
+
+void host_dht_set(float temperature, float humidity, esp_err_t result)
+{
+    dht_reading.temperature = temperature;
+    dht_reading.humidity = humidity;
+    dht_reading.result = result;
+}
+
+esp_err_t dht_read_float_data(dht_sensor_type_t sensor_type, gpio_num_t pin, float *humidity, float *temperature)
+{
+    if (dht_reading.result == ESP_OK) {
+        *humidity = dht_reading.humidity;
+        *temperature = dht_reading.temperature;
+    }
+    return dht_reading.result;
+}
+
+uint32_t esp_random(void)
+{
+    static uint32_t state = 2463534242u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *uart_config)
+{
+    if (uart_num < 0 || uart_num >= UART_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uarts[uart_num].baud = uart_config->baud_rate;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num)
+{
+    return uart_num >= 0 && uart_num < UART_NUM_MAX ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size,
+                              int queue_size, void *uart_queue, int intr_alloc_flags)
+{
+    return uart_num >= 0 && uart_num < UART_NUM_MAX ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t uart_set_baudrate(uart_port_t uart_num, uint32_t baudrate)
+{
+    if (uart_num < 0 || uart_num >= UART_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uarts[uart_num].baud = baudrate;
+    return ESP_OK;
+}
+
+uint32_t host_uart_get_baud(uart_port_t port)
+{
+    return uarts[port].baud;
+}
+
+// Bytes that do not fit in the capture buffer are dropped, as by a full TX ring
+int uart_write_bytes(uart_port_t uart_num, const void *src, size_t size)
+{
+    size_t room = UART_BUF_SIZE - uarts[uart_num].out_len;
+    size_t n = size < room ? size : room;
+    memcpy(uarts[uart_num].out + uarts[uart_num].out_len, src, n);
+    uarts[uart_num].out_len += n;
+    return (int)size;
+}
+
+size_t host_uart_take_output(uart_port_t port, void *buf, size_t size)
+{
+    size_t n = uarts[port].out_len < size ? uarts[port].out_len : size;
+    memcpy(buf, uarts[port].out, n);
+    memmove(uarts[port].out, uarts[port].out + n, uarts[port].out_len - n);
+    uarts[port].out_len -= n;
+    return n;
+}
+
+void host_uart_feed(uart_port_t port, const void *data, size_t len)
+{
+    if (uarts[port].in_pos == uarts[port].in_len) {
+        uarts[port].in_pos = uarts[port].in_len = 0;
+    }
+    size_t room = UART_BUF_SIZE - uarts[port].in_len;
+    size_t n = len < room ? len : room;
+    memcpy(uarts[port].in + uarts[port].in_len, data, n);
+    uarts[port].in_len += n;
+}
+
+// Never waits: returns what has been fed so far
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length, TickType_t ticks_to_wait)
+{
+    size_t n = uarts[uart_num].in_len - uarts[uart_num].in_pos;
+    if (n > length) {
+        n = length;
+    }
+    memcpy(buf, uarts[uart_num].in + uarts[uart_num].in_pos, n);
+    uarts[uart_num].in_pos += n;
+    return (int)n;
+}
+
+// ---- NVS ----
+
+#define MAX_NVS_ENTRIES 64
+#define MAX_NVS_HANDLES 8
+#define NVS_NAME_MAX    15
+
+enum { NVS_TYPE_I32, NVS_TYPE_STR, NVS_TYPE_BLOB };
+
+static struct {
+    char ns[NVS_NAME_MAX + 1];
+    char key[NVS_NAME_MAX + 1];
+    int type;
+    void *data;
+    size_t size;            // Strings include the terminating zero, as in NVS
+} nvs_entries[MAX_NVS_ENTRIES];
+
+static struct {
+    bool open;
+    bool writable;
+    char ns[NVS_NAME_MAX + 1];
+} nvs_handles[MAX_NVS_HANDLES];
+
+static esp_err_t nvs_fail_err;
+static int nvs_fail_count;          // Writes left to fail (host_nvs_fail_writes())
+
+static bool nvs_namespace_exists(const char *ns)
+{
+    for (size_t i = 0; i < MAX_NVS_ENTRIES; i++) {
+        if (nvs_entries[i].data && strcmp(nvs_entries[i].ns, ns) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int nvs_find(nvs_handle_t handle, const char *key)
+{
+    for (int i = 0; i < MAX_NVS_ENTRIES; i++) {
+        if (nvs_entries[i].data && strcmp(nvs_entries[i].ns, nvs_handles[handle - 1].ns) == 0 &&
+            strcmp(nvs_entries[i].key, key) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static esp_err_t nvs_check(nvs_handle_t handle, const char *key, bool write)
+{
+    if (handle == 0 || handle > MAX_NVS_HANDLES || !nvs_handles[handle - 1].open) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (write && !nvs_handles[handle - 1].writable) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    if (key && strlen(key) > NVS_NAME_MAX) {
+        return ESP_ERR_NVS_KEY_TOO_LONG;
+    }
+    if (write && nvs_fail_count > 0) {
+        nvs_fail_count--;
+        return nvs_fail_err;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t nvs_store(nvs_handle_t handle, const char *key, int type, const void *value, size_t size)
+{
+    esp_err_t err = nvs_check(handle, key, true);
+    if (err != ESP_OK) {
+        return err;
+    }
+    int slot = nvs_find(handle, key);
+    if (slot < 0) {
+        for (slot = 0; slot < MAX_NVS_ENTRIES && nvs_entries[slot].data; slot++) {
+        }
+        if (slot == MAX_NVS_ENTRIES) {
+            return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        }
+        strcpy(nvs_entries[slot].ns, nvs_handles[handle - 1].ns);
+        strcpy(nvs_entries[slot].key, key);
+    }
+    free(nvs_entries[slot].data);
+    nvs_entries[slot].data = malloc(size ? size : 1);
+    memcpy(nvs_entries[slot].data, value, size);
+    nvs_entries[slot].size = size;
+    nvs_entries[slot].type = type;
+    return ESP_OK;
+}
+
+// A key stored with another type is not found, as in NVS
+static esp_err_t nvs_load(nvs_handle_t handle, const char *key, int type, void *out, size_t *size)
+{
+    esp_err_t err = nvs_check(handle, key, false);
+    if (err != ESP_OK) {
+        return err;
+    }
+    int slot = nvs_find(handle, key);
+    if (slot < 0 || nvs_entries[slot].type != type) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (out == NULL) {
+        *size = nvs_entries[slot].size;
+        return ESP_OK;
+    }
+    if (*size < nvs_entries[slot].size) {
+        *size = nvs_entries[slot].size;
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out, nvs_entries[slot].data, nvs_entries[slot].size);
+    *size = nvs_entries[slot].size;
+    return ESP_OK;
+}
+
+void host_nvs_erase(void)
+{
+    for (size_t i = 0; i < MAX_NVS_ENTRIES; i++) {
+        free(nvs_entries[i].data);
+        nvs_entries[i].data = NULL;
+    }
+}
+
+void host_nvs_fail_writes(esp_err_t err, int count)
+{
+    nvs_fail_err = err;
+    nvs_fail_count = count;
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    host_nvs_erase();
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    if (strlen(namespace_name) > NVS_NAME_MAX) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+    if (open_mode == NVS_READONLY && !nvs_namespace_exists(namespace_name)) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    for (size_t i = 0; i < MAX_NVS_HANDLES; i++) {
+        if (!nvs_handles[i].open) {
+            nvs_handles[i].open = true;
+            nvs_handles[i].writable = open_mode == NVS_READWRITE;
+            strcpy(nvs_handles[i].ns, namespace_name);
+            *out_handle = i + 1;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    if (handle > 0 && handle <= MAX_NVS_HANDLES) {
+        nvs_handles[handle - 1].open = false;
+    }
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char *key, int32_t value)
+{
+    return nvs_store(handle, key, NVS_TYPE_I32, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value)
+{
+    return nvs_store(handle, key, NVS_TYPE_STR, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return nvs_store(handle, key, NVS_TYPE_BLOB, value, length);
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char *key, int32_t *out_value)
+{
+    size_t size = sizeof(*out_value);
+    return nvs_load(handle, key, NVS_TYPE_I32, out_value, &size);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length)
+{
+    return nvs_load(handle, key, NVS_TYPE_STR, out_value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    return nvs_load(handle, key, NVS_TYPE_BLOB, out_value, length);
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    esp_err_t err = nvs_check(handle, key, true);
+    if (err != ESP_OK) {
+        return err;
+    }
+    int slot = nvs_find(handle, key);
+    if (slot < 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    free(nvs_entries[slot].data);
+    nvs_entries[slot].data = NULL;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+    esp_err_t err = nvs_check(handle, NULL, true);
+    for (size_t i = 0; i < MAX_NVS_ENTRIES && err == ESP_OK; i++) {
+        if (nvs_entries[i].data && strcmp(nvs_entries[i].ns, nvs_handles[handle - 1].ns) == 0) {
+            free(nvs_entries[i].data);
+            nvs_entries[i].data = NULL;
+        }
+    }
+    return err;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return nvs_check(handle, NULL, true);
+}
+
+// ---- ADC calibration (ESP32 line fitting) ----
+
+// Linear part: mV = (coeff_a * raw + 32768) / 65536 + offset, coeff_a = Vref * scale / 4096
+static const uint32_t atten_scales[4] = { 57431, 76236, 105481, 196602 };
+static const uint32_t atten_offsets[4] = { 75, 78, 107, 142 };
+
+// 12 dB above raw 2880: measured curves for Vref 1000 and 1200 mV, one point every 64 codes
+#define LUT_VREF_LOW    1000
+#define LUT_VREF_HIGH   1200
+#define LUT_STEP        64
+#define LUT_LOW_THRESH  2880
+#define LUT_HIGH_THRESH (LUT_LOW_THRESH + LUT_STEP)
+static const uint32_t lut_adc1_low[20] = {
+    2240, 2297, 2352, 2405, 2457, 2512, 2564, 2616, 2664, 2709,
+    2754, 2795, 2832, 2868, 2903, 2937, 2969, 3000, 3030, 3060,
+};
+static const uint32_t lut_adc1_high[20] = {
+    2667, 2706, 2745, 2780, 2813, 2844, 2873, 2901, 2928, 2952,
+    2976, 2996, 3016, 3034, 3052, 3068, 3084, 3098, 3112, 3126,
+};
+
+struct adc_cali_scheme_t {
+    adc_atten_t atten;
+    uint32_t vref;
+    uint32_t coeff_a;
+    uint32_t coeff_b;
+};
+
+static adc_cali_line_fitting_efuse_val_t efuse_source = ADC_CALI_LINE_FITTING_EFUSE_VAL_EFUSE_VREF;
+static uint32_t efuse_vref = 1100;
+
+void host_adc_cali_set_efuse(adc_cali_line_fitting_efuse_val_t source, uint32_t vref_mv)
+{
+    efuse_source = source;
+    efuse_vref = vref_mv;
+}
+
+esp_err_t adc_cali_scheme_line_fitting_check_efuse(adc_cali_line_fitting_efuse_val_t *cali_val)
+{
+    *cali_val = efuse_source;
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_create_scheme_line_fitting(const adc_cali_line_fitting_config_t *config,
+                                              adc_cali_handle_t *ret_handle)
+{
+    if (config->unit_id != ADC_UNIT_1 || config->atten > ADC_ATTEN_DB_12 ||
+        (config->bitwidth != ADC_BITWIDTH_12 && config->bitwidth != ADC_BITWIDTH_DEFAULT)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct adc_cali_scheme_t *cali = malloc(sizeof(*cali));
+    if (cali == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    cali->atten = config->atten;
+    cali->vref = efuse_source == ADC_CALI_LINE_FITTING_EFUSE_VAL_DEFAULT_VREF ? config->default_vref : efuse_vref;
+    cali->coeff_a = cali->vref * atten_scales[config->atten] / 4096;
+    cali->coeff_b = atten_offsets[config->atten];
+    *ret_handle = cali;
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_delete_scheme_line_fitting(adc_cali_handle_t handle)
+{
+    free(handle);
+    return ESP_OK;
+}
+
+// Bilinear interpolation between the two Vref curves and the two nearest points
+static uint32_t lut_voltage(uint32_t raw, uint32_t vref)
+{
+    vref = vref < LUT_VREF_LOW ? LUT_VREF_LOW : vref > LUT_VREF_HIGH ? LUT_VREF_HIGH : vref;
+    uint32_t i = (raw - LUT_LOW_THRESH) / LUT_STEP;
+    int x2dist = LUT_VREF_HIGH - vref;
+    int x1dist = vref - LUT_VREF_LOW;
+    int y2dist = (i + 1) * LUT_STEP + LUT_LOW_THRESH - raw;
+    int y1dist = raw - (i * LUT_STEP + LUT_LOW_THRESH);
+    int voltage = lut_adc1_low[i] * x2dist * y2dist + lut_adc1_high[i] * x1dist * y2dist +
+                  lut_adc1_low[i + 1] * x2dist * y1dist + lut_adc1_high[i + 1] * x1dist * y1dist;
+    voltage += (LUT_VREF_HIGH - LUT_VREF_LOW) * LUT_STEP / 2;
+    return voltage / ((LUT_VREF_HIGH - LUT_VREF_LOW) * LUT_STEP);
+}
+
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int *voltage)
+{
+    if (handle == NULL || raw < 0 || raw > 4095) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t linear = (handle->coeff_a * raw + 32768) / 65536 + handle->coeff_b;
+    if (handle->atten != ADC_ATTEN_DB_12 || raw < LUT_LOW_THRESH) {
+        *voltage = linear;
+    } else if (raw <= LUT_HIGH_THRESH) {
+        // Blend from the line into the table over one step
+        uint32_t lut = lut_voltage(raw, handle->vref);
+        *voltage = (linear * (LUT_HIGH_THRESH - raw) + lut * (raw - LUT_LOW_THRESH)) / LUT_STEP;
+    } else {
+        *voltage = lut_voltage(raw, handle->vref);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+// Controls for the host emulation of the ESP-IDF APIs. Only the tests include this.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/adc.h"
+#include "driver/gpio.h"
+#include "driver/gptimer.h"
+#include "driver/ledc.h"
+#include "driver/uart.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "esp_partition.h"
+
+// ---- Clock ----
+
+// Switch esp_timer_get_time() and the tick count to a fake clock starting at start_us
+void host_clock_set_fake(int64_t start_us);
+
+// Back to the monotonic clock (for benchmarks)
+void host_clock_set_real(void);
+
+// Move the fake clock forward, firing every esp_timer that falls due on the way
+void host_clock_advance_us(int64_t us);
+
+// Monotonic nanoseconds, for timing code under test
+uint64_t host_now_ns(void);
+
+// Switch esp_cpu_get_cycle_count() to a counter the test sets, at mhz cycles per
+// microsecond (240 for the ESP32's 240 MHz); 0 goes back to host nanoseconds
+void host_cpu_set_fake_cycles(uint32_t mhz);
+void host_cpu_set_cycles(uint32_t cycles);
+
+// ---- File-backed flash ----
+
+typedef struct {
+    uint64_t bytes_read;
+    uint64_t bytes_written;      // Bytes passed to esp_partition_write()
+    uint64_t bytes_erased;
+    uint32_t write_calls;
+    uint32_t erase_calls;
+} host_partition_stats_t;
+
+// Register a partition whose contents live in a file. An existing file of the right size is
+// kept (a "reboot"), anything else is replaced by an erased image.
+const esp_partition_t *host_partition_add(const char *label, esp_partition_type_t type,
+                                          esp_partition_subtype_t subtype, uint32_t size,
+                                          const char *path);
+
+// Erase the whole image, as a fresh chip would be
+void host_partition_wipe(const esp_partition_t *part);
+
+// Power cut: the write that crosses the next `bytes` programmed bytes stops there and fails
+void host_partition_fail_after(const esp_partition_t *part, uint64_t bytes);
+
+void host_partition_get_stats(const esp_partition_t *part, host_partition_stats_t *stats);
+void host_partition_reset_stats(const esp_partition_t *part);
+
+// ---- OTA and restarts ----
+
+// The partition esp_ota_get_running_partition() returns (default: the factory app)
+void host_ota_set_running(const esp_partition_t *part);
+
+// How often esp_restart() was called
+int host_restart_count(void);
+
+// ---- HTTP server ----
+
+// Build a request with a body; headers are added with host_http_add_header()
+void host_http_request(httpd_req_t *req, httpd_method_t method, const char *uri,
+                       const void *body, size_t len);
+void host_http_add_header(httpd_req_t *req, const char *field, const char *value);
+
+// Run the handler registered for req->method and req->uri
+esp_err_t host_http_call(httpd_req_t *req);
+
+// ---- Peripherals ----
+
+// Level gpio_get_level() returns for an input; outputs can be read back
+void host_gpio_set_input(gpio_num_t gpio, int level);
+int host_gpio_get_output(gpio_num_t gpio);
+
+// Set an input and take its interrupt: the handler added with gpio_isr_handler_add() runs
+// if the interrupt is enabled and its type matches the level (any edge, or the new level's
+// edge). The level need not change, as when the ISR was late and missed edges.
+// Returns whether the handler ran.
+bool host_gpio_trigger(gpio_num_t gpio, int level);
+
+void host_adc_set_raw(adc1_channel_t channel, int raw);
+
+// A LEDC channel as the hardware runs it: duty and hpoint as of the last ledc_update_duty()
+typedef struct {
+    int gpio;
+    ledc_timer_t timer;
+    uint32_t duty;
+    uint32_t hpoint;
+} host_ledc_channel_t;
+
+void host_ledc_get_channel(ledc_mode_t mode, ledc_channel_t channel, host_ledc_channel_t *out);
+uint32_t host_ledc_get_freq(ledc_mode_t mode, ledc_timer_t timer);
+uint32_t host_ledc_get_resolution(ledc_mode_t mode, ledc_timer_t timer);
+
+// Run the alarm callback of the last gptimer created, if it is started. During the callback
+// gptimer_get_raw_count() returns `count`: with auto-reload, the time since the alarm.
+// Returns what the callback returned, or false if it did not run.
+bool host_gptimer_alarm(uint64_t count);
+
+// The next gptimer_start() fails with err
+void host_gptimer_fail_next_start(esp_err_t err);
+
+// What the next dht_read_float_data() returns (result != ESP_OK: a failed read)
+void host_dht_set(float temperature, float humidity, esp_err_t result);
+
+// Bytes written with uart_write_bytes(), oldest first; the returned bytes are removed
+size_t host_uart_take_output(uart_port_t port, void *buf, size_t size);
+
+// Bytes for uart_read_bytes() to return
+void host_uart_feed(uart_port_t port, const void *data, size_t len);
+
+// Last rate set with uart_param_config() or uart_set_baudrate()
+uint32_t host_uart_get_baud(uart_port_t port);
+
+// ---- ADC calibration and NVS ----
+
+// What adc_cali_scheme_line_fitting_check_efuse() reports and the Vref the curve uses
+// (default: eFuse Vref, 1100 mV). DEFAULT_VREF uses the config's default_vref instead.
+void host_adc_cali_set_efuse(adc_cali_line_fitting_efuse_val_t source, uint32_t vref_mv);
+
+// Erase every NVS namespace, as a fresh chip would be
+void host_nvs_erase(void);
+
+// The next `count` NVS writes (nvs_set_*(), nvs_erase_*(), nvs_commit()) fail with err
+// and change nothing, like a full or worn partition
+void host_nvs_fail_writes(esp_err_t err, int count);
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "soc/gpio_struct.h"
+
+// IO MUX registers have no effect on the host
+extern const uint32_t GPIO_PIN_MUX_REG[GPIO_NUM_MAX];
+#define PIN_INPUT_ENABLE(reg) ((void)(reg))
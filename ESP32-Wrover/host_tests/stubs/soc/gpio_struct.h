@@ -0,0 +1,8 @@
+#pragma once
+
+// The GPIO register block; the low-level calls on the host go through driver/gpio.h
+typedef struct {
+    int unused;
+} gpio_dev_t;
+
+extern gpio_dev_t GPIO;
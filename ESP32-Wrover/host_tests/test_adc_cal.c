@@ -0,0 +1,223 @@
+// Lesson 31: lookup tables against the line fitting curve at every code, for each attenuation,
+// several eFuse Vrefs and a two-point calibration from NVS; conversion cost per sample.
+
+#include <stdlib.h>
+
+#include "nvs.h"
+
+#include "host_idf.h"
+#include "host_test.h"
+#include "adc_cal.h"
+
+#define BENCH_SAMPLES 4096
+#define BENCH_ROUNDS  2000
+
+static const adc_atten_t attens[] = { ADC_ATTEN_DB_0, ADC_ATTEN_DB_2_5, ADC_ATTEN_DB_6, ADC_ATTEN_DB_12 };
+
+static adc_cali_handle_t reference(adc_atten_t atten)
+{
+    adc_cali_line_fitting_config_t config = {
+        .unit_id = ADC_UNIT_1,
+        .atten = atten,
+        .bitwidth = ADC_BITWIDTH_12,
+        .default_vref = 1100,
+    };
+    adc_cali_handle_t handle = NULL;
+    CHECK_EQ(adc_cali_create_scheme_line_fitting(&config, &handle), ESP_OK);
+    return handle;
+}
+
+// Largest difference between the table and the eFuse curve over all 4096 codes
+static int max_error_mv(const adc_cal_t *cal, adc_cali_handle_t handle, int *worst_raw)
+{
+    int max_error = 0;
+    for (int raw = 0; raw < 4096; raw++) {
+        int mv;
+        adc_cali_raw_to_voltage(handle, raw, &mv);
+        int error = abs((int)adc_cal_raw_to_mv(cal, raw) - mv);
+        if (error > max_error) {
+            max_error = error;
+            *worst_raw = raw;
+        }
+    }
+    return max_error;
+}
+
+static void test_efuse_tables(void)
+{
+    static const uint32_t vrefs[] = { 1000, 1100, 1200 };
+    static adc_cal_t cal;
+
+    for (size_t v = 0; v < sizeof(vrefs) / sizeof(vrefs[0]); v++) {
+        host_adc_cali_set_efuse(ADC_CALI_LINE_FITTING_EFUSE_VAL_EFUSE_VREF, vrefs[v]);
+        for (size_t a = 0; a < sizeof(attens) / sizeof(attens[0]); a++) {
+            CHECK_EQ(adc_cal_init(&cal, ADC1_CHANNEL_6, attens[a]), ESP_OK);
+            CHECK_EQ(cal.source, ADC_CAL_SOURCE_EFUSE_VREF);
+
+            adc_cali_handle_t handle = reference(attens[a]);
+            int worst_raw = 0;
+            int error = max_error_mv(&cal, handle, &worst_raw);
+            // 1 mV from rounding; 2 mV at 12 dB where the curve blends from the line into
+            // its table over raw 2880..2944 and is not straight within one 16-code step
+            CHECK(error <= (attens[a] == ADC_ATTEN_DB_12 ? 2 : 1));
+            if (vrefs[v] != 1100 && error > 1) {
+                printf("Atten %d, Vref %u mV: max error %d mV at raw %d\n",
+                       (int)attens[a], (unsigned)vrefs[v], error, worst_raw);
+            }
+            if (vrefs[v] == 1100) {
+                printf("Atten %d, Vref %u mV: table vs eFuse curve max error %d mV at raw %d\n",
+                       (int)attens[a], (unsigned)vrefs[v], error, worst_raw);
+            }
+            adc_cali_delete_scheme_line_fitting(handle);
+        }
+    }
+
+    // The bend at the top of 12 dB: a straight line from the lower range misses it badly
+    host_adc_cali_set_efuse(ADC_CALI_LINE_FITTING_EFUSE_VAL_EFUSE_VREF, 1100);
+    CHECK_EQ(adc_cal_init(&cal, ADC1_CHANNEL_6, ADC_ATTEN_DB_12), ESP_OK);
+    int32_t slope_x1000 = (cal.lut[160] - cal.lut[16]) * 1000 / (2560 - 256);
+    int32_t straight = cal.lut[16] + slope_x1000 * (4095 - 256) / 1000;
+    printf("12 dB at raw 4095: %u mV, a straight line through raw 256 and 2560 gives %d mV\n",
+           (unsigned)adc_cal_raw_to_mv(&cal, 4095), (int)straight);
+    CHECK(straight - (int32_t)adc_cal_raw_to_mv(&cal, 4095) > 300);
+
+    // No eFuse values: the default Vref
+    host_adc_cali_set_efuse(ADC_CALI_LINE_FITTING_EFUSE_VAL_DEFAULT_VREF, 0);
+    CHECK_EQ(adc_cal_init(&cal, ADC1_CHANNEL_6, ADC_ATTEN_DB_12), ESP_OK);
+    CHECK_EQ(cal.source, ADC_CAL_SOURCE_DEFAULT_VREF);
+    host_adc_cali_set_efuse(ADC_CALI_LINE_FITTING_EFUSE_VAL_EFUSE_TP, 1100);
+    CHECK_EQ(adc_cal_init(&cal, ADC1_CHANNEL_6, ADC_ATTEN_DB_12), ESP_OK);
+    CHECK_EQ(cal.source, ADC_CAL_SOURCE_EFUSE_TP);
+    host_adc_cali_set_efuse(ADC_CALI_LINE_FITTING_EFUSE_VAL_EFUSE_VREF, 1100);
+}
+
+static void test_two_point(void)
+{
+    static adc_cal_t cal;
+    const adc_cal_point_t points[2] = { { .raw = 250, .mv = 300 }, { .raw = 3300, .mv = 2800 } };
+
+    host_nvs_erase();
+    CHECK_EQ(adc_cal_save_two_point(ADC1_CHANNEL_6, ADC_ATTEN_DB_12, points), ESP_OK);
+    CHECK_EQ(adc_cal_init(&cal, ADC1_CHANNEL_6, ADC_ATTEN_DB_12), ESP_OK);
+    CHECK_EQ(cal.source, ADC_CAL_SOURCE_TWO_POINT);
+    CHECK_EQ(adc_cal_raw_to_mv(&cal, 250), 300);
+    CHECK_EQ(adc_cal_raw_to_mv(&cal, 3300), 2800);
+
+    // Against the exact line, clamped to 0..3900 mV
+    int max_error = 0;
+    for (int raw = 0; raw < 4096; raw++) {
+        double mv = 300 + (raw - 250) * 2500.0 / 3050;
+        mv = mv < 0 ? 0 : mv > 3900 ? 3900 : mv;
+        int error = abs((int)adc_cal_raw_to_mv(&cal, raw) - (int)(mv + 0.5));
+        max_error = error > max_error ? error : max_error;
+    }
+    printf("Two-point: table vs exact line max error %d mV\n", max_error);
+    CHECK(max_error <= 1);
+
+    // Only for this channel and attenuation
+    CHECK_EQ(adc_cal_init(&cal, ADC1_CHANNEL_6, ADC_ATTEN_DB_6), ESP_OK);
+    CHECK_EQ(cal.source, ADC_CAL_SOURCE_EFUSE_VREF);
+    CHECK_EQ(adc_cal_init(&cal, ADC1_CHANNEL_7, ADC_ATTEN_DB_12), ESP_OK);
+    CHECK_EQ(cal.source, ADC_CAL_SOURCE_EFUSE_VREF);
+
+    CHECK_EQ(adc_cal_erase_two_point(ADC1_CHANNEL_6, ADC_ATTEN_DB_12), ESP_OK);
+    CHECK_EQ(adc_cal_erase_two_point(ADC1_CHANNEL_6, ADC_ATTEN_DB_12), ESP_OK);   // Already gone
+    CHECK_EQ(adc_cal_init(&cal, ADC1_CHANNEL_6, ADC_ATTEN_DB_12), ESP_OK);
+    CHECK_EQ(cal.source, ADC_CAL_SOURCE_EFUSE_VREF);
+}
+
+static void test_bad_two_point(void)
+{
+    static adc_cal_t cal;
+    const adc_cal_point_t reversed[2] = { { .raw = 3300, .mv = 2800 }, { .raw = 250, .mv = 300 } };
+    const adc_cal_point_t flat[2] = { { .raw = 250, .mv = 300 }, { .raw = 3300, .mv = 300 } };
+
+    host_nvs_erase();
+    CHECK_EQ(adc_cal_save_two_point(ADC1_CHANNEL_6, ADC_ATTEN_DB_12, reversed), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(adc_cal_save_two_point(ADC1_CHANNEL_6, ADC_ATTEN_DB_12, flat), ESP_ERR_INVALID_ARG);
+
+    // Bad blobs already in NVS (an older layout, or written by hand) fall back to eFuse
+    nvs_handle_t nvs;
+    CHECK_EQ(nvs_open("adc_cal", NVS_READWRITE, &nvs), ESP_OK);
+    CHECK_EQ(nvs_set_blob(nvs, "c6_a3", reversed, sizeof(reversed)), ESP_OK);
+    CHECK_EQ(nvs_set_blob(nvs, "c7_a3", reversed, 4), ESP_OK);
+    nvs_close(nvs);
+    CHECK_EQ(adc_cal_init(&cal, ADC1_CHANNEL_6, ADC_ATTEN_DB_12), ESP_OK);
+    CHECK_EQ(cal.source, ADC_CAL_SOURCE_EFUSE_VREF);
+    CHECK_EQ(adc_cal_init(&cal, ADC1_CHANNEL_7, ADC_ATTEN_DB_12), ESP_OK);
+    CHECK_EQ(cal.source, ADC_CAL_SOURCE_EFUSE_VREF);
+    host_nvs_erase();
+}
+
+static void test_block(void)
+{
+    static adc_cal_t cal;
+    static uint16_t raw[4096], mv[4096];
+
+    CHECK_EQ(adc_cal_init(&cal, ADC1_CHANNEL_6, ADC_ATTEN_DB_12), ESP_OK);
+    for (int i = 0; i < 4096; i++) {
+        raw[i] = i | (i & 1) << 12;     // Stray bits above the 12-bit code are ignored
+    }
+    adc_cal_convert_block(&cal, raw, mv, 4096);
+    bool same = true;
+    for (int i = 0; i < 4096; i++) {
+        same &= mv[i] == adc_cal_raw_to_mv(&cal, i);
+    }
+    CHECK(same);
+    int top;
+    adc_cali_handle_t handle = reference(ADC_ATTEN_DB_12);
+    adc_cali_raw_to_voltage(handle, 4095, &top);
+    adc_cali_delete_scheme_line_fitting(handle);
+    CHECK_EQ(adc_cal_raw_to_mv(&cal, 4095), top);       // The extrapolated last entry
+
+    // In place, as the lesson's main loop could
+    adc_cal_convert_block(&cal, raw, raw, 4096);
+    CHECK_EQ(raw[1000], mv[1000]);
+}
+
+// Per-sample eFuse API against the table on a whole block, as main.c's benchmark()
+static void bench(void)
+{
+    static adc_cal_t cal;
+    static uint16_t raw[BENCH_SAMPLES], mv[BENCH_SAMPLES];
+    volatile uint32_t sink = 0;
+
+    CHECK_EQ(adc_cal_init(&cal, ADC1_CHANNEL_6, ADC_ATTEN_DB_12), ESP_OK);
+    adc_cali_handle_t handle = reference(ADC_ATTEN_DB_12);
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        raw[i] = (i * 2654435761u) >> 20;
+    }
+
+    uint64_t start = host_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int i = 0; i < BENCH_SAMPLES; i++) {
+            int v;
+            adc_cali_raw_to_voltage(handle, raw[i], &v);
+            mv[i] = v;
+        }
+        sink += mv[r % BENCH_SAMPLES];
+    }
+    double api_ns = (double)(host_now_ns() - start) / BENCH_ROUNDS / BENCH_SAMPLES;
+
+    start = host_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        adc_cal_convert_block(&cal, raw, mv, BENCH_SAMPLES);
+        sink += mv[r % BENCH_SAMPLES];
+    }
+    double lut_ns = (double)(host_now_ns() - start) / BENCH_ROUNDS / BENCH_SAMPLES;
+    adc_cali_delete_scheme_line_fitting(handle);
+
+    printf("Conversion cost: adc_cali_raw_to_voltage() %.2f ns/sample, lookup table %.2f ns/sample (%.1fx)\n",
+           api_ns, lut_ns, api_ns / lut_ns);
+    printf("Table size: %zu bytes per channel and attenuation\n", sizeof(cal.lut));
+}
+
+int main(void)
+{
+    test_efuse_tables();
+    test_two_point();
+    test_bad_two_point();
+    test_block();
+    bench();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,510 @@
+// Lesson 36: the configuration store on the emulated NVS: defaults, stored and invalid values,
+// set/get with range checks, subscribers and quiet mode, the debounce timer on the fake clock
+// (2 s quiet, 10 s at most), failed commits retried with backoff, reset; the config command
+// and the HTTP handlers; the cost of a cached read.
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "nvs.h"
+
+#include "host_idf.h"
+#include "host_test.h"
+#include "config.h"
+#include "config_ui.h"
+#include "console.h"
+
+#define SETTLE_US   20000       // Real time for the commit task to finish what a timer started
+#define BENCH_READS 1000000
+
+static int notified[CONFIG_KEY_COUNT + 1];     // Per key, and [CONFIG_KEY_COUNT] for "any"
+static char out[4096];
+static size_t out_len;
+
+static void on_key(config_key_t key, void *ctx)
+{
+    notified[key]++;
+}
+
+static void on_any(config_key_t key, void *ctx)
+{
+    notified[CONFIG_KEY_COUNT]++;
+}
+
+static void capture(void *ctx, const char *data, size_t len)
+{
+    if (out_len + len < sizeof(out)) {
+        memcpy(out + out_len, data, len);
+        out_len += len;
+        out[out_len] = '\0';
+    }
+}
+
+static const char *feed(const char *input)
+{
+    out_len = 0;
+    out[0] = '\0';
+    console_feed(input, strlen(input));
+    return out;
+}
+
+static uint32_t attempts(void)
+{
+    config_stats_t stats;
+    config_get_stats(&stats);
+    return stats.commits + stats.failed_commits;
+}
+
+// The timer only wakes the commit task, which writes NVS in its own thread
+static bool wait_attempts(uint32_t n)
+{
+    for (int i = 0; i < 2000 && attempts() < n; i++) {
+        usleep(1000);
+    }
+    return attempts() >= n;
+}
+
+// Move the fake clock and give a commit the timer started time to finish, so the test
+// never advances the clock while the commit task reschedules
+static void advance_ms(int64_t ms)
+{
+    host_clock_advance_us(ms * 1000);
+    usleep(SETTLE_US);
+}
+
+static int32_t stored_int(const char *key)
+{
+    nvs_handle_t nvs;
+    int32_t value = -1;
+    if (nvs_open("config", NVS_READONLY, &nvs) == ESP_OK) {
+        nvs_get_i32(nvs, key, &value);
+        nvs_close(nvs);
+    }
+    return value;
+}
+
+static const char *stored_str(const char *key)
+{
+    static char value[CONFIG_STR_MAX + 1];
+    size_t size = sizeof(value);
+    nvs_handle_t nvs;
+    value[0] = '\0';
+    if (nvs_open("config", NVS_READONLY, &nvs) == ESP_OK) {
+        nvs_get_str(nvs, key, value, &size);
+        nvs_close(nvs);
+    }
+    return value;
+}
+
+// Runs one test in a child process: config_init() starts a task, so once per program
+static void run_isolated(const char *name, void (*fn)(void))
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        fn();
+        exit(HOST_TEST_RESULT());
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "%s failed\n", name);
+        host_test_failures++;
+    }
+}
+
+// A value out of range, a string of the wrong length or type falls back to the default
+static void test_load_stored(void)
+{
+    nvs_handle_t nvs;
+    host_nvs_erase();
+    CHECK_EQ(nvs_open("config", NVS_READWRITE, &nvs), ESP_OK);
+    nvs_set_i32(nvs, "uart_baud", 57600);
+    nvs_set_i32(nvs, "time_log_ms", 5);                 // Below 1000
+    nvs_set_str(nvs, "timezone", "CET-1CEST,M3.5.0,M10.5.0/3");
+    nvs_set_str(nvs, "wifi_ssid", "");                  // Shorter than 1 character
+    nvs_set_str(nvs, "wifi_pass", "0123456789012345678901234567890123456789012345678901234567890123");
+    nvs_set_i32(nvs, "ntp_server", 1);                  // Stored with the wrong type
+    nvs_commit(nvs);
+    nvs_close(nvs);
+
+    host_clock_set_fake(1000000);
+    CHECK_EQ(config_init(), ESP_OK);
+
+    char text[CONFIG_STR_MAX + 1];
+    CHECK_EQ(config_get_int(CONFIG_UART_BAUD), 57600);
+    CHECK_EQ(config_get_int(CONFIG_TIME_LOG_MS), 5000);
+    config_get_str(CONFIG_TIMEZONE, text, sizeof(text));
+    CHECK(strcmp(text, "CET-1CEST,M3.5.0,M10.5.0/3") == 0);
+    config_get_str(CONFIG_WIFI_SSID, text, sizeof(text));
+    CHECK(strcmp(text, "Your SSID") == 0);
+    config_get_str(CONFIG_WIFI_PASS, text, sizeof(text));   // 64 characters, the limit is 63
+    CHECK(strcmp(text, "Your Password") == 0);
+    config_get_str(CONFIG_NTP_SERVER, text, sizeof(text));
+    CHECK(strcmp(text, "pool.ntp.org") == 0);
+    for (int key = 0; key < CONFIG_KEY_COUNT; key++) {
+        CHECK(!config_is_dirty(key));
+    }
+}
+
+static void test_defaults(void)
+{
+    char text[CONFIG_STR_MAX + 1];
+    config_stats_t stats;
+
+    CHECK_EQ(config_get_int(CONFIG_UART_BAUD), 115200);
+    CHECK_EQ(config_get_int(CONFIG_TIME_LOG_MS), 5000);
+    config_get_str(CONFIG_TIMEZONE, text, sizeof(text));
+    CHECK(strcmp(text, "EST5EDT,M3.2.0/2,M11.1.0/2") == 0);
+    config_get_str(CONFIG_TIMEZONE, text, 5);               // Truncated, still terminated
+    CHECK(strcmp(text, "EST5") == 0);
+    config_get_stats(&stats);
+    CHECK_EQ(stats.sets, 0);
+    CHECK_EQ(stats.commits, 0);
+}
+
+static void test_set_and_text(void)
+{
+    char text[CONFIG_STR_MAX + 1];
+    config_key_t key;
+    char longest[CONFIG_STR_MAX + 1] = { 0 };
+    memset(longest, 'a', 63);
+
+    CHECK_EQ(config_set_int(CONFIG_UART_BAUD, 9599), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(config_set_int(CONFIG_UART_BAUD, 921601), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(config_set_int(CONFIG_TIMEZONE, 1), ESP_ERR_INVALID_ARG);      // A string setting
+    CHECK_EQ(config_set_int(CONFIG_KEY_COUNT, 1), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(config_set_str(CONFIG_UART_BAUD, "1"), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(config_set_str(CONFIG_WIFI_SSID, ""), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(config_set_str(CONFIG_WIFI_SSID, "123456789012345678901234567890123"), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(config_set_str(CONFIG_WIFI_PASS, ""), ESP_OK);                  // An open network
+    CHECK_EQ(config_set_str(CONFIG_NTP_SERVER, longest), ESP_OK);
+    longest[63] = 'a';                                                      // 64 characters
+    CHECK_EQ(config_set_str(CONFIG_NTP_SERVER, longest), ESP_ERR_INVALID_SIZE);
+
+    CHECK(config_find("uart_baud", &key) && key == CONFIG_UART_BAUD);
+    CHECK(!config_find("uart", &key));
+    CHECK_EQ(config_set_from_text(CONFIG_UART_BAUD, "0x1c200"), ESP_OK);    // 115200
+    CHECK_EQ(config_set_from_text(CONFIG_UART_BAUD, "9600 "), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(config_set_from_text(CONFIG_UART_BAUD, ""), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(config_set_from_text(CONFIG_UART_BAUD, "12"), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(config_set_from_text(CONFIG_UART_BAUD, "230400"), ESP_OK);
+    CHECK_EQ(config_get_int(CONFIG_UART_BAUD), 230400);
+    CHECK_EQ(config_set_from_text(CONFIG_WIFI_SSID, "My Network"), ESP_OK);
+    CHECK_EQ(config_set_from_text(CONFIG_WIFI_PASS, "secret123"), ESP_OK);
+
+    config_format(CONFIG_UART_BAUD, text, sizeof(text));
+    CHECK(strcmp(text, "230400") == 0);
+    config_format(CONFIG_WIFI_SSID, text, sizeof(text));
+    CHECK(strcmp(text, "My Network") == 0);
+    config_format(CONFIG_WIFI_PASS, text, sizeof(text));
+    CHECK(strcmp(text, "********") == 0);
+    config_format(CONFIG_WIFI_PASS, text, 4);
+    CHECK(strcmp(text, "***") == 0);
+    CHECK(config_is_secret(CONFIG_WIFI_PASS) && !config_is_secret(CONFIG_WIFI_SSID));
+    CHECK(config_is_dirty(CONFIG_UART_BAUD) && !config_is_dirty(CONFIG_TIMEZONE));
+
+    CHECK_EQ(config_commit(), ESP_OK);
+    CHECK(!config_is_dirty(CONFIG_UART_BAUD));
+    CHECK_EQ(stored_int("uart_baud"), 230400);
+    CHECK(strcmp(stored_str("wifi_pass"), "secret123") == 0);
+    CHECK_EQ(strlen(stored_str("ntp_server")), 63);
+}
+
+static void test_subscribers(void)
+{
+    memset(notified, 0, sizeof(notified));
+    config_set_int(CONFIG_TIME_LOG_MS, 2000);
+    config_set_int(CONFIG_TIME_LOG_MS, 2000);              // Same value: no change, no callback
+    config_set_str(CONFIG_TIMEZONE, "UTC0");
+    CHECK_EQ(notified[CONFIG_TIME_LOG_MS], 1);
+    CHECK_EQ(notified[CONFIG_TIMEZONE], 0);                 // Not subscribed
+    CHECK_EQ(notified[CONFIG_KEY_COUNT], 2);
+    CHECK_EQ(config_set_int(CONFIG_TIME_LOG_MS, 1), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(notified[CONFIG_KEY_COUNT], 2);
+
+    // Quiet: the values and the commit work as usual, only nobody hears about it
+    config_set_quiet(true);
+    config_set_int(CONFIG_TIME_LOG_MS, 3000);
+    CHECK_EQ(config_get_int(CONFIG_TIME_LOG_MS), 3000);
+    CHECK(config_is_dirty(CONFIG_TIME_LOG_MS));
+    CHECK_EQ(config_commit(), ESP_OK);
+    config_set_quiet(false);
+    CHECK_EQ(notified[CONFIG_TIME_LOG_MS], 1);
+    CHECK_EQ(notified[CONFIG_KEY_COUNT], 2);
+    CHECK_EQ(stored_int("time_log_ms"), 3000);
+
+    for (int i = 0; i < CONFIG_MAX_SUBSCRIBERS - 2; i++) {
+        CHECK_EQ(config_subscribe(CONFIG_UART_BAUD, on_key, NULL), ESP_OK);
+    }
+    CHECK_EQ(config_subscribe(CONFIG_UART_BAUD, on_key, NULL), ESP_ERR_NO_MEM);
+    config_set_int(CONFIG_UART_BAUD, 9600);
+    CHECK_EQ(notified[CONFIG_UART_BAUD], CONFIG_MAX_SUBSCRIBERS - 2);
+    config_commit();
+}
+
+// Every change restarts the 2 s quiet period; a change is never kept waiting beyond 10 s
+static void test_debounce(void)
+{
+    config_stats_t before, after;
+    uint32_t start = attempts();
+    config_get_stats(&before);
+
+    config_set_int(CONFIG_TIME_LOG_MS, 4000);
+    advance_ms(1900);
+    config_set_str(CONFIG_TIMEZONE, "CET-1");
+    advance_ms(1999);
+    CHECK_EQ(attempts(), start);
+    advance_ms(1);
+    CHECK(wait_attempts(start + 1));
+    config_get_stats(&after);
+    CHECK_EQ(after.commits - before.commits, 1);
+    CHECK_EQ(after.keys_written - before.keys_written, 2);  // Both changes in one commit
+    CHECK_EQ(stored_int("time_log_ms"), 4000);
+    CHECK(strcmp(stored_str("timezone"), "CET-1") == 0);
+
+    // A slider: a new value every second
+    start = attempts();
+    for (int i = 0; i < 10; i++) {
+        CHECK_EQ(attempts(), start);
+        config_set_int(CONFIG_TIME_LOG_MS, 5000 + i);
+        advance_ms(1000);
+    }
+    CHECK(wait_attempts(start + 1));
+    CHECK_EQ(stored_int("time_log_ms"), 5009);
+
+    // Quiet after the last change, so 2 s later
+    advance_ms(2000);
+    CHECK_EQ(attempts(), start + 1);
+    CHECK(!config_is_dirty(CONFIG_TIME_LOG_MS));
+}
+
+// A failed commit keeps the changes and tries again after 2, 4, 8 .. at most 60 s
+static void test_commit_retry(void)
+{
+    static const int retry_s[] = { 2, 4, 8, 16, 32, 60, 60 };
+    const int failures = sizeof(retry_s) / sizeof(retry_s[0]);
+    config_stats_t before, after;
+
+    config_get_stats(&before);
+    uint32_t start = attempts();
+    host_nvs_fail_writes(ESP_ERR_NVS_NOT_ENOUGH_SPACE, failures);
+    config_set_int(CONFIG_UART_BAUD, 19200);
+    advance_ms(CONFIG_COMMIT_DELAY_MS);
+    CHECK(wait_attempts(start + 1));
+    CHECK(config_is_dirty(CONFIG_UART_BAUD));
+
+    for (int i = 0; i < failures; i++) {
+        if (i == 3) {
+            // A change while failing does not bring the retry forward
+            advance_ms(1000);
+            config_set_str(CONFIG_NTP_SERVER, "time.example.org");
+            advance_ms(retry_s[i] * 1000 - 1001);
+        } else {
+            advance_ms(retry_s[i] * 1000 - 1);
+        }
+        CHECK_EQ(attempts(), start + 1 + i);
+        advance_ms(1);
+        CHECK(wait_attempts(start + 2 + i));
+    }
+
+    config_get_stats(&after);
+    CHECK_EQ(after.failed_commits - before.failed_commits, failures);
+    CHECK_EQ(after.commits - before.commits, 1);
+    CHECK_EQ(after.keys_written - before.keys_written, 2);
+    CHECK(!config_is_dirty(CONFIG_UART_BAUD) && !config_is_dirty(CONFIG_NTP_SERVER));
+    CHECK_EQ(stored_int("uart_baud"), 19200);
+    CHECK(strcmp(stored_str("ntp_server"), "time.example.org") == 0);
+
+    // Success resets the backoff; config_commit() schedules the retry too
+    start = attempts();
+    host_nvs_fail_writes(ESP_ERR_NVS_NOT_ENOUGH_SPACE, 1);
+    config_set_int(CONFIG_UART_BAUD, 38400);
+    CHECK_EQ(config_commit(), ESP_ERR_NVS_NOT_ENOUGH_SPACE);
+    CHECK_EQ(attempts(), start + 1);
+    advance_ms(CONFIG_COMMIT_DELAY_MS - 1);
+    CHECK_EQ(attempts(), start + 1);
+    advance_ms(1);
+    CHECK(wait_attempts(start + 2));
+    CHECK_EQ(stored_int("uart_baud"), 38400);
+}
+
+static void test_console(void)
+{
+    config_stats_t before, after;
+
+    console_init(capture, NULL);
+    config_ui_register_console();
+
+    feed("config\r");
+    CHECK(strstr(out, "uart_baud") != NULL);
+    CHECK(strstr(out, "********") != NULL);
+    CHECK(strstr(out, "secret123") == NULL);
+    CHECK(strstr(out, "failed commits") != NULL);
+    feed("config set uart_baud 1\r");
+    CHECK(strstr(out, "Invalid value for uart_baud") != NULL);
+    feed("config set baud 9600\r");
+    CHECK(strstr(out, "Unknown setting 'baud'") != NULL);
+    feed("config set time_log_ms 2500\r");
+    CHECK(strstr(out, "time_log_ms = 2500, saved in 2 s") != NULL);
+    feed("config get time_log_ms\r");
+    CHECK(strstr(out, "time_log_ms = 2500") != NULL);
+    feed("config commit\r");
+    CHECK(!config_is_dirty(CONFIG_TIME_LOG_MS));
+
+    // The bench runs quiet: no subscriber inside the timed loops
+    memset(notified, 0, sizeof(notified));
+    config_get_stats(&before);
+    feed("config bench\r");
+    config_get_stats(&after);
+    CHECK(strstr(out, "commit after each") != NULL);
+    CHECK(strstr(out, "10 flash writes") != NULL);
+    CHECK(strstr(out, "1 flash writes") != NULL);
+    CHECK_EQ(notified[CONFIG_KEY_COUNT], 0);
+    CHECK_EQ(config_get_int(CONFIG_TIME_LOG_MS), 2500);
+    CHECK(!config_is_dirty(CONFIG_TIME_LOG_MS));
+    CHECK_EQ(stored_int("time_log_ms"), 2500);
+    CHECK_EQ(after.failed_commits, before.failed_commits);
+
+    // Not quiet any more
+    config_set_int(CONFIG_TIME_LOG_MS, 2600);
+    CHECK_EQ(notified[CONFIG_KEY_COUNT], 1);
+    config_commit();
+}
+
+static void test_http(void)
+{
+    static httpd_req_t req;
+    char text[CONFIG_STR_MAX + 1];
+
+    CHECK_EQ(config_ui_register_http(NULL), ESP_OK);
+
+    const char *body = "key=timezone&value=CET-1CEST%2CM3.5.0%2CM10.5.0%2F3";
+    host_http_request(&req, HTTP_POST, "/config", body, strlen(body));
+    CHECK_EQ(host_http_call(&req), ESP_OK);
+    CHECK_EQ(req.host_status, 303);
+    config_get_str(CONFIG_TIMEZONE, text, sizeof(text));
+    CHECK(strcmp(text, "CET-1CEST,M3.5.0,M10.5.0/3") == 0);
+
+    // An empty password field keeps the password
+    body = "key=wifi_pass&value=";
+    host_http_request(&req, HTTP_POST, "/config", body, strlen(body));
+    CHECK_EQ(host_http_call(&req), ESP_OK);
+    config_get_str(CONFIG_WIFI_PASS, text, sizeof(text));
+    CHECK(strcmp(text, "secret123") == 0);
+
+    body = "key=wifi_ssid&value=Caf%C3%A9+%3Cb%3E";
+    host_http_request(&req, HTTP_POST, "/config", body, strlen(body));
+    CHECK_EQ(host_http_call(&req), ESP_OK);
+    config_get_str(CONFIG_WIFI_SSID, text, sizeof(text));
+    CHECK(strcmp(text, "Caf\xc3\xa9 <b>") == 0);
+
+    body = "key=nope&value=1";
+    host_http_request(&req, HTTP_POST, "/config", body, strlen(body));
+    CHECK_EQ(host_http_call(&req), ESP_FAIL);
+    CHECK_EQ(req.host_status, 404);
+    body = "key=uart_baud&value=fast";
+    host_http_request(&req, HTTP_POST, "/config", body, strlen(body));
+    CHECK_EQ(host_http_call(&req), ESP_FAIL);
+    CHECK_EQ(req.host_status, 400);
+    body = "value=1";
+    host_http_request(&req, HTTP_POST, "/config", body, strlen(body));
+    CHECK_EQ(host_http_call(&req), ESP_FAIL);
+    CHECK_EQ(req.host_status, 400);
+
+    host_http_request(&req, HTTP_GET, "/config", NULL, 0);
+    CHECK_EQ(host_http_call(&req), ESP_OK);
+    CHECK(strstr(req.host_reply, "wifi_pass=********\n") != NULL);
+    CHECK(strstr(req.host_reply, "timezone=CET-1CEST,M3.5.0,M10.5.0/3\n") != NULL);
+
+    // The page escapes values and never sends the password back
+    host_http_request(&req, HTTP_GET, "/", NULL, 0);
+    CHECK_EQ(host_http_call(&req), ESP_OK);
+    CHECK(strstr(req.host_reply, "value='Caf\xc3\xa9 &lt;b&gt;'") != NULL);
+    CHECK(strstr(req.host_reply, "type='password' name='value' value=''") != NULL);
+    CHECK(strstr(req.host_reply, "secret123") == NULL);
+    config_commit();
+}
+
+static void test_reset(void)
+{
+    char text[CONFIG_STR_MAX + 1];
+    nvs_handle_t nvs;
+
+    config_set_int(CONFIG_TIME_LOG_MS, 7000);               // Pending, dropped by the reset
+    memset(notified, 0, sizeof(notified));
+    CHECK_EQ(config_reset(), ESP_OK);
+    CHECK_EQ(notified[CONFIG_KEY_COUNT], CONFIG_KEY_COUNT);
+    CHECK_EQ(config_get_int(CONFIG_TIME_LOG_MS), 5000);
+    config_get_str(CONFIG_WIFI_SSID, text, sizeof(text));
+    CHECK(strcmp(text, "Your SSID") == 0);
+    CHECK(!config_is_dirty(CONFIG_TIME_LOG_MS));
+    CHECK_EQ(nvs_open("config", NVS_READONLY, &nvs), ESP_ERR_NVS_NOT_FOUND);
+
+    // The reset stopped the timer: nothing is written later
+    uint32_t start = attempts();
+    advance_ms(CONFIG_COMMIT_MAX_MS);
+    CHECK_EQ(attempts(), start);
+
+    // A failed erase keeps everything as it was
+    config_set_int(CONFIG_TIME_LOG_MS, 8000);
+    config_commit();
+    host_nvs_fail_writes(ESP_ERR_NVS_NOT_ENOUGH_SPACE, 1);
+    CHECK_EQ(config_reset(), ESP_ERR_NVS_NOT_ENOUGH_SPACE);
+    CHECK_EQ(config_get_int(CONFIG_TIME_LOG_MS), 8000);
+    CHECK_EQ(stored_int("time_log_ms"), 8000);
+}
+
+// The point of the RAM cache: reads that cost nanoseconds, not a flash access
+static void bench(void)
+{
+    char text[CONFIG_STR_MAX + 1];
+    volatile int32_t sink = 0;
+
+    host_clock_set_real();
+    uint64_t start = host_now_ns();
+    for (int i = 0; i < BENCH_READS; i++) {
+        sink += config_get_int(CONFIG_TIME_LOG_MS);
+    }
+    uint64_t int_ns = host_now_ns() - start;
+
+    start = host_now_ns();
+    for (int i = 0; i < BENCH_READS; i++) {
+        config_get_str(CONFIG_TIMEZONE, text, sizeof(text));
+    }
+    uint64_t str_ns = host_now_ns() - start;
+
+    // Notifies the subscribers and restarts the timer
+    start = host_now_ns();
+    for (int i = 0; i < BENCH_READS; i++) {
+        config_set_int(CONFIG_TIME_LOG_MS, 1000 + i % 2);
+    }
+    uint64_t set_ns = host_now_ns() - start;
+
+    printf("Cached read: %.1f ns (int), %.1f ns (string); set in RAM: %.1f ns\n",
+           (double)int_ns / BENCH_READS, (double)str_ns / BENCH_READS, (double)set_ns / BENCH_READS);
+}
+
+int main(void)
+{
+    run_isolated("test_load_stored", test_load_stored);
+
+    host_nvs_erase();
+    host_clock_set_fake(1000000);
+    CHECK_EQ(config_init(), ESP_OK);
+    config_subscribe(CONFIG_TIME_LOG_MS, on_key, NULL);
+    config_subscribe(CONFIG_KEY_COUNT, on_any, NULL);
+
+    test_defaults();
+    test_set_and_text();
+    test_subscribers();
+    test_debounce();
+    test_commit_retry();
+    test_console();
+    test_http();
+    test_reset();
+    bench();
+    return HOST_TEST_RESULT();
+}
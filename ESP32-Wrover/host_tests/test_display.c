@@ -0,0 +1,299 @@
+// Lesson 35: a timing model of the multiplexed display. The LEDC channels are evaluated from
+// the duty and hpoint display.c programs, the refresh ISR runs a given latency after each
+// gptimer alarm, and every quarter microsecond the model checks which digit is lit and what
+// the segment pins show: one digit at a time, never the wrong pattern while the ISR stays
+// inside the dark gap, and ghosting (counted as "late" by the ISR) once it does not. Also the
+// font, frame latching, brightness, init errors, and the host cost of one refresh.
+
+#include <string.h>
+
+#include "host_idf.h"
+#include "host_test.h"
+#include "display.h"
+
+#define REFRESH_HZ  2000
+#define DIGITS      4
+#define STEPS_PER_US 4
+#define BENCH_REFRESHES 1000000
+
+// Same wiring as lesson_35 main.c
+static display_config_t config = {
+    .segment_pins = { GPIO_NUM_13, GPIO_NUM_14, GPIO_NUM_25, GPIO_NUM_26,
+                      GPIO_NUM_27, GPIO_NUM_32, GPIO_NUM_33, GPIO_NUM_23 },
+    .digit_pins = { GPIO_NUM_18, GPIO_NUM_19, GPIO_NUM_21, GPIO_NUM_22 },
+    .digit_count = DIGITS,
+    .refresh_hz = REFRESH_HZ,
+    .ledc_timer = LEDC_TIMER_0,
+    .ledc_channel = LEDC_CHANNEL_0,
+};
+
+typedef struct {
+    uint32_t overlap_steps;         // More than one digit lit
+    uint32_t ghost_steps;           // A digit lit with another digit's pattern
+    uint32_t lit_steps[DIGITS];
+    uint32_t scans;
+} observation_t;
+
+static uint32_t slot_us, scan_us;
+static uint64_t now_steps;          // Model time since the LEDC timer was reset
+static uint32_t alarms;
+
+static uint8_t segment_pins_byte(void)
+{
+    uint8_t byte = 0;
+    for (int i = 0; i < DISPLAY_SEGMENT_COUNT; i++) {
+        byte |= host_gpio_get_output(config.segment_pins[i]) << i;
+    }
+    return byte;
+}
+
+// LEDC output of a digit's channel: high from hpoint for duty ticks of every period
+static bool digit_lit(int digit, uint64_t steps)
+{
+    host_ledc_channel_t ch;
+    host_ledc_get_channel(LEDC_LOW_SPEED_MODE, config.ledc_channel + digit, &ch);
+    uint32_t period_ticks = 1u << host_ledc_get_resolution(LEDC_LOW_SPEED_MODE, config.ledc_timer);
+    uint64_t period_steps = (uint64_t)scan_us * STEPS_PER_US;
+    // Position in the period, in 1/STEPS_PER_US tick units to keep it exact
+    uint64_t pos = (steps % period_steps) * period_ticks * STEPS_PER_US / period_steps;
+    uint64_t from = (uint64_t)ch.hpoint * STEPS_PER_US;
+    uint64_t into = (pos + period_ticks * STEPS_PER_US - from) % (period_ticks * STEPS_PER_US);
+    return into < (uint64_t)ch.duty * STEPS_PER_US;
+}
+
+// Starts the display the way display_init() leaves it: LEDC timer and gptimer at 0
+static void start(void)
+{
+    for (int i = 0; i < DISPLAY_SEGMENT_COUNT; i++) {
+        gpio_set_level(config.segment_pins[i], 0);
+    }
+    CHECK_EQ(display_init(&config), ESP_OK);
+    slot_us = 1000000 / REFRESH_HZ;
+    scan_us = slot_us * DIGITS;
+    now_steps = 0;
+    alarms = 0;
+}
+
+// Advance the model by a number of slots. expected[] is what each digit should show; NULL
+// skips the checks (the first scan after init, whose slot 0 has no pattern yet).
+static void run_slots(uint32_t slots, uint32_t latency_us, const uint8_t *expected, observation_t *obs)
+{
+    uint64_t end = now_steps + (uint64_t)slots * slot_us * STEPS_PER_US;
+    for (; now_steps < end; now_steps++) {
+        // The alarm at the start of each slot runs the ISR latency_us later
+        uint64_t next_isr = ((uint64_t)(alarms + 1) * slot_us + latency_us) * STEPS_PER_US;
+        if (now_steps == next_isr) {
+            host_gptimer_alarm(latency_us);
+            alarms++;
+        }
+        if (expected == NULL) {
+            continue;
+        }
+        int lit = 0;
+        uint8_t shown = segment_pins_byte();
+        for (int d = 0; d < DIGITS; d++) {
+            if (digit_lit(d, now_steps)) {
+                lit++;
+                obs->lit_steps[d]++;
+                if (shown != expected[d]) {
+                    obs->ghost_steps++;
+                }
+            }
+        }
+        if (lit > 1) {
+            obs->overlap_steps++;
+        }
+    }
+    if (expected) {
+        obs->scans += slots / DIGITS;
+    }
+}
+
+static void run(uint32_t scans, uint32_t latency_us, const uint8_t *expected, observation_t *obs)
+{
+    run_slots(scans * DIGITS, latency_us, expected, obs);
+}
+
+// ---- Timing ----
+
+static void test_timing(void)
+{
+    static const uint8_t pattern[DIGITS] = { 0x06, 0x5B | DISPLAY_SEG_DP, 0x4F, 0x66 };    // "12.34"
+
+    start();
+    CHECK_EQ(host_ledc_get_freq(LEDC_LOW_SPEED_MODE, LEDC_TIMER_0), REFRESH_HZ / DIGITS);
+    display_print("12.34");
+    run(1, 2, NULL, NULL);
+
+    display_stats_t stats;
+    display_get_stats(&stats);
+    CHECK_EQ(stats.blank_us, 31);       // 1/16 of a 500 us slot, rounded down
+    uint32_t blank_steps = slot_us * STEPS_PER_US / 16;
+
+    static const uint32_t latencies[] = { 0, 2, 10, 30, 31, 32, 40, 100 };
+    printf("Latency  Ghost us/scan  Late  (dark gap %u us)\n", stats.blank_us);
+    for (size_t i = 0; i < sizeof(latencies) / sizeof(latencies[0]); i++) {
+        observation_t obs = { 0 };
+        display_get_stats(&stats);
+        uint32_t late_before = stats.late;
+        run(4, latencies[i], pattern, &obs);
+        display_get_stats(&stats);
+        uint32_t late = stats.late - late_before;
+        printf("%4u us %14.2f %5u\n", latencies[i],
+               (double)obs.ghost_steps / STEPS_PER_US / obs.scans, late);
+
+        // LEDC alone keeps the digits apart, whatever the ISR does
+        CHECK_EQ(obs.overlap_steps, 0);
+        // Inside the gap nothing ghosts; past it, every slot does for the overshoot
+        uint32_t latency_steps = latencies[i] * STEPS_PER_US;
+        uint32_t overshoot = latency_steps > blank_steps ? latency_steps - blank_steps : 0;
+        CHECK_EQ(obs.ghost_steps, overshoot * DIGITS * obs.scans);
+        // The ISR's own check agrees, erring on the safe side at the rounded-down boundary
+        CHECK_EQ(late, latencies[i] >= stats.blank_us ? 4 * DIGITS : 0);
+        CHECK(stats.max_latency_us >= latencies[i]);
+    }
+}
+
+// A new frame only shows from the next scan on, never half and half
+static void test_frame_latch(void)
+{
+    static const uint8_t old_frame[DIGITS] = { 0x06, 0x5B, 0x4F, 0x66 };    // "1234"
+    static const uint8_t new_frame[DIGITS] = { 0x6D, 0x7D, 0x07, 0x7F };    // "5678"
+
+    start();
+    display_print("1234");
+    run(1, 2, NULL, NULL);
+    observation_t obs = { 0 };
+    run(1, 2, old_frame, &obs);
+
+    // Half-way through a scan, after digits 0 and 1, the rest still shows the old frame
+    run_slots(2, 2, old_frame, &obs);
+    display_print("5678");
+    run_slots(2, 2, old_frame, &obs);
+    CHECK_EQ(obs.ghost_steps, 0);
+    run(2, 2, new_frame, &obs);
+    CHECK_EQ(obs.ghost_steps, 0);
+}
+
+static void test_brightness(void)
+{
+    static const uint8_t levels[DIGITS] = { 32, 96, 160, 255 };
+    static const uint8_t pattern[DIGITS] = { 0x7F, 0x7F, 0x7F, 0x7F };
+
+    start();
+    display_print("8888");
+    for (int d = 0; d < DIGITS; d++) {
+        display_set_brightness(d, levels[d]);
+    }
+    display_set_brightness(DIGITS, 1);      // Out of range: ignored
+    display_set_brightness(-1, 1);
+    run(1, 2, NULL, NULL);
+    observation_t obs = { 0 };
+    run(2, 2, pattern, &obs);
+    CHECK_EQ(obs.ghost_steps, 0);
+
+    // Each digit is lit for its share of the slot between the two dark gaps
+    uint32_t slot_ticks = 1024 / DIGITS, blank_ticks = slot_ticks / 16;
+    for (int d = 0; d < DIGITS; d++) {
+        uint32_t duty = levels[d] * (slot_ticks - 2 * blank_ticks) / 255;
+        uint32_t expected = duty * scan_us * STEPS_PER_US / 1024 * obs.scans;
+        uint32_t got = obs.lit_steps[d];
+        CHECK(got + STEPS_PER_US * obs.scans >= expected && got <= expected + STEPS_PER_US * obs.scans);
+    }
+    for (int d = 0; d < DIGITS; d++) {
+        display_set_brightness(d, 255);
+    }
+}
+
+// ---- Text, init ----
+
+static void expect_frame(const char *text, const uint8_t *segments)
+{
+    display_print(text);
+    observation_t obs = { 0 };
+    run(1, 2, NULL, NULL);
+    run(1, 2, segments, &obs);
+    if (obs.ghost_steps) {
+        fprintf(stderr, "\"%s\" shows the wrong segments\n", text);
+        host_test_failures++;
+    }
+}
+
+static void test_font(void)
+{
+    start();
+    expect_frame("8.8.8.8.", (const uint8_t[]){ 0xFF, 0xFF, 0xFF, 0xFF });
+    expect_frame("1.2", (const uint8_t[]){ 0x86, 0x5B, 0x00, 0x00 });
+    expect_frame("..", (const uint8_t[]){ 0x80, 0x80, 0x00, 0x00 });
+    expect_frame("-_ A", (const uint8_t[]){ 0x40, 0x08, 0x00, 0x77 });
+    expect_frame("kmvz", (const uint8_t[]){ 0x00, 0x00, 0x00, 0x00 });
+    expect_frame("123456", (const uint8_t[]){ 0x06, 0x5B, 0x4F, 0x66 });
+    display_printf("%3lu.%lu", 5ul, 7ul);
+    observation_t obs = { 0 };
+    run(1, 2, NULL, NULL);
+    run(1, 2, (const uint8_t[]){ 0x00, 0x00, 0x6D | DISPLAY_SEG_DP, 0x07 }, &obs);
+    CHECK_EQ(obs.ghost_steps, 0);
+
+    display_set_segments((const uint8_t[]){ 0x01, 0x02 }, 2);      // The rest goes blank
+    run(1, 2, NULL, NULL);
+    run(1, 2, (const uint8_t[]){ 0x01, 0x02, 0x00, 0x00 }, &obs);
+    CHECK_EQ(obs.ghost_steps, 0);
+}
+
+static void test_init_errors(void)
+{
+    display_config_t bad = config;
+    bad.digit_count = 0;
+    CHECK_EQ(display_init(&bad), ESP_ERR_INVALID_ARG);
+    bad.digit_count = DISPLAY_MAX_DIGITS + 1;
+    CHECK_EQ(display_init(&bad), ESP_ERR_INVALID_ARG);
+    bad = config;
+    bad.refresh_hz = 3000;              // Not a whole number of microseconds
+    CHECK_EQ(display_init(&bad), ESP_ERR_INVALID_ARG);
+    bad.refresh_hz = 0;
+    CHECK_EQ(display_init(&bad), ESP_ERR_INVALID_ARG);
+    bad = config;
+    bad.digit_count = 3;                // 2000 slots/s do not split into 3 digits
+    CHECK_EQ(display_init(&bad), ESP_ERR_INVALID_ARG);
+    bad = config;
+    bad.digit_pins[1] = GPIO_NUM_34;    // Input only: LEDC cannot drive it
+    CHECK_EQ(display_init(&bad), ESP_ERR_INVALID_ARG);
+
+    // A timer that does not start is reported, and no refresh runs
+    host_gptimer_fail_next_start(ESP_ERR_INVALID_STATE);
+    CHECK_EQ(display_init(&config), ESP_ERR_INVALID_STATE);
+    CHECK(!host_gptimer_alarm(0));
+}
+
+// ---- Cost ----
+
+static void bench(void)
+{
+    start();
+    display_print("8.8.8.8.");
+    display_stats_t before, after;
+    display_get_stats(&before);
+    uint64_t begin = host_now_ns();
+    for (uint32_t i = 0; i < BENCH_REFRESHES; i++) {
+        host_gptimer_alarm(2);
+    }
+    uint64_t elapsed = host_now_ns() - begin;
+    display_get_stats(&after);
+    CHECK_EQ(after.refreshes - before.refreshes, BENCH_REFRESHES);
+
+    double per_refresh = (double)elapsed / BENCH_REFRESHES;
+    printf("Host: %.1f ns per refresh (%u ns inside the ISR's counters on average, %u max), "
+           "%.3f%% of a core at %d/s\n", per_refresh, after.avg_cycles, after.max_cycles,
+           per_refresh * REFRESH_HZ / 1e7, REFRESH_HZ);
+}
+
+int main(void)
+{
+    test_init_errors();
+    test_timing();
+    test_frame_latch();
+    test_brightness();
+    test_font();
+    bench();
+    return HOST_TEST_RESULT();
+}
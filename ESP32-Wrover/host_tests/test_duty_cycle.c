@@ -0,0 +1,137 @@
+// Lesson 20: duty-cycle estimate for the lesson's job table and variations of it,
+// checked against numbers worked out by hand.
+
+#include <math.h>
+
+#include "host_idf.h"
+#include "host_test.h"
+
+// Included so each case can start from an empty job table
+#include "duty_cycle.c"
+
+#define CHECK_NEAR(actual, expected, tolerance) CHECK(fabs((double)(actual) - (expected)) <= (tolerance))
+
+// Same values as lesson_20 main.c
+static const duty_job_cost_t SAMPLE_COST = { .awake_ms = 2,    .current_ma = 40.0f };
+static const duty_job_cost_t UPLOAD_COST = { .awake_ms = 1500, .current_ma = 120.0f };
+static const duty_job_cost_t REPORT_COST = { .awake_ms = 1,    .current_ma = 40.0f };
+static const duty_power_model_t DEEP_SLEEP_MODEL  = { .wake_ms = 30, .wake_ma = 40.0f, .sleep_ma = 0.01f };
+static const duty_power_model_t LIGHT_SLEEP_MODEL = { .wake_ms = 1,  .wake_ma = 40.0f, .sleep_ma = 0.8f };
+
+static void nop_job(void *arg)
+{
+}
+
+static void lesson_table(uint32_t samples_per_upload)
+{
+    job_count = 0;
+    CHECK_EQ(duty_cycle_register("sample", 10000, SAMPLE_COST, nop_job, NULL), ESP_OK);
+    CHECK_EQ(duty_cycle_register("upload", 10000 * samples_per_upload, UPLOAD_COST, nop_job, NULL), ESP_OK);
+    CHECK_EQ(duty_cycle_register("report", 600000, REPORT_COST, nop_job, NULL), ESP_OK);
+}
+
+static void print_estimate(const char *label, const duty_estimate_t *e)
+{
+    printf("%-32s %5lu wakeups/h, %3lu uploads/h, awake %6.2f%%, %7.3f mA\n", label,
+           (unsigned long)e->wakeups_per_hour, (unsigned long)e->runs_per_hour[1],
+           e->awake_fraction * 100.0f, e->average_ma);
+}
+
+static void test_lesson_table(void)
+{
+    duty_estimate_t e;
+
+    // 360 wakeups: 360 samples, 60 uploads and 6 reports share them
+    lesson_table(6);
+    duty_cycle_estimate(&DEEP_SLEEP_MODEL, &e);
+    print_estimate("Deep sleep, upload every 6", &e);
+    CHECK_EQ(e.wakeups_per_hour, 360);
+    CHECK_EQ(e.runs_per_hour[0], 360);
+    CHECK_EQ(e.runs_per_hour[1], 60);
+    CHECK_EQ(e.runs_per_hour[2], 6);
+    // Awake: 360 * (30 + 2) + 60 * 1500 + 6 * 1 = 101526 ms
+    CHECK_NEAR(e.awake_fraction, 101526.0 / 3600000.0, 1e-6);
+    // Charge: 360 * 32 * 40 + 60 * 1500 * 120 + 6 * 40 + (3600000 - 101526) * 0.01 mA*ms
+    CHECK_NEAR(e.average_ma, (460800.0 + 10800000.0 + 240.0 + 34984.74) / 3600000.0, 1e-3);
+
+    lesson_table(6);
+    duty_cycle_estimate(&LIGHT_SLEEP_MODEL, &e);
+    print_estimate("Light sleep, upload every 6", &e);
+    CHECK_EQ(e.wakeups_per_hour, 360);
+    CHECK_NEAR(e.awake_fraction, (360.0 * 3 + 90000.0 + 6.0) / 3600000.0, 1e-6);
+}
+
+// Without batching the radio runs on every sample and dominates the budget
+static void test_batching(void)
+{
+    duty_estimate_t every, batched;
+
+    lesson_table(1);
+    duty_cycle_estimate(&DEEP_SLEEP_MODEL, &every);
+    print_estimate("Deep sleep, upload every sample", &every);
+    CHECK_EQ(every.runs_per_hour[1], 360);
+    CHECK_NEAR(every.awake_fraction, (360.0 * 1532 + 6.0) / 3600000.0, 1e-6);
+
+    lesson_table(30);
+    duty_cycle_estimate(&DEEP_SLEEP_MODEL, &batched);
+    print_estimate("Deep sleep, upload every 30", &batched);
+    CHECK_EQ(batched.runs_per_hour[1], 12);
+    CHECK(batched.average_ma * 10 < every.average_ma);
+}
+
+// A job that takes longer than its period: the missed slot is skipped and the next run is a
+// full period after the job ended, so the chip still sleeps 100 ms of every 280 ms cycle
+// (30 ms wake + 150 ms job + 100 ms asleep)
+static void test_saturation(void)
+{
+    duty_estimate_t e;
+
+    job_count = 0;
+    duty_cycle_register("busy", 100, (duty_job_cost_t){ .awake_ms = 150, .current_ma = 50.0f },
+                        nop_job, NULL);
+    duty_cycle_estimate(&DEEP_SLEEP_MODEL, &e);
+    print_estimate("Job longer than its period", &e);
+    CHECK_EQ(e.wakeups_per_hour, (3600000 + 279) / 280);
+    CHECK_EQ(e.runs_per_hour[0], e.wakeups_per_hour);
+    CHECK_NEAR(e.awake_fraction, 180.0 / 280.0, 1e-6);
+    CHECK_NEAR(e.average_ma, (30.0 * 40 + 150.0 * 50 + 100.0 * 0.01) / 280.0, 1e-3);
+}
+
+// The next run due within DUTY_CYCLE_SLACK_MS of the last one: no sleep and no wakeup in
+// between. Per 300 ms: one wakeup (30 ms), three 60 ms runs ending at 90, 150 and 210 ms
+// (sleep would be 10 and 50 ms), then 90 ms asleep.
+static void test_back_to_back(void)
+{
+    duty_estimate_t e;
+
+    job_count = 0;
+    duty_cycle_register("close", 100, (duty_job_cost_t){ .awake_ms = 60, .current_ma = 50.0f },
+                        nop_job, NULL);
+    duty_cycle_estimate(&DEEP_SLEEP_MODEL, &e);
+    print_estimate("Runs closer than the slack", &e);
+    CHECK_EQ(e.wakeups_per_hour, 3600000 / 300);
+    CHECK_EQ(e.runs_per_hour[0], 3 * 3600000 / 300);
+    CHECK_NEAR(e.awake_fraction, 210.0 / 300.0, 1e-6);
+    CHECK_NEAR(e.average_ma, (30.0 * 40 + 180.0 * 50 + 90.0 * 0.01) / 300.0, 1e-3);
+}
+
+static void test_register_limits(void)
+{
+    job_count = 0;
+    CHECK_EQ(duty_cycle_register("zero", 0, SAMPLE_COST, nop_job, NULL), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(duty_cycle_register("null", 10, SAMPLE_COST, NULL, NULL), ESP_ERR_INVALID_ARG);
+    for (int i = 0; i < DUTY_CYCLE_MAX_JOBS; i++) {
+        CHECK_EQ(duty_cycle_register("job", 1000, SAMPLE_COST, nop_job, NULL), ESP_OK);
+    }
+    CHECK_EQ(duty_cycle_register("one too many", 1000, SAMPLE_COST, nop_job, NULL), ESP_ERR_INVALID_ARG);
+}
+
+int main(void)
+{
+    test_lesson_table();
+    test_batching();
+    test_saturation();
+    test_back_to_back();
+    test_register_limits();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,236 @@
+// Lesson 32: the Q15 complex and real FFTs against a double-precision DFT for 8 .. 1024 points,
+// the Hann window, power, peaks and bands; time per transform at 256, 512 and 1024 points.
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_idf.h"
+#include "host_test.h"
+#include "fft_q15.h"
+#include "spectrum.h"
+
+#define SAMPLE_RATE_HZ 20000
+#define BENCH_ROUNDS   2000
+
+// Error bounds in LSB of the 1/n-scaled result. Each stage rounds down when it halves, so
+// the complex FFT at full scale loses about half an LSB per stage.
+#define COMPLEX_MAX_ERROR_LSB(n) (1 + log2(n) / 2)
+#define REAL_MAX_ERROR_LSB       4.0
+#define RMS_ERROR_LSB            1.0
+
+static int16_t buf[2 * FFT_MAX_POINTS];
+static double ref_re[FFT_MAX_POINTS], ref_im[FFT_MAX_POINTS];
+
+static int16_t random_sample(int32_t amplitude)
+{
+    return (int16_t)(rand() % (2 * amplitude + 1) - amplitude);
+}
+
+// X[k] / n of n complex points (im == NULL: real input)
+static void dft(const int16_t *re, const int16_t *im, size_t stride, size_t n)
+{
+    for (size_t k = 0; k < n; k++) {
+        double sr = 0, si = 0;
+        for (size_t t = 0; t < n; t++) {
+            double angle = -2 * M_PI * (double)((k * t) % n) / n;
+            double xr = re[t * stride], xi = im ? im[t * stride] : 0;
+            sr += xr * cos(angle) - xi * sin(angle);
+            si += xr * sin(angle) + xi * cos(angle);
+        }
+        ref_re[k] = sr / n;
+        ref_im[k] = si / n;
+    }
+}
+
+typedef struct {
+    double max;
+    double sum_sq;
+    size_t count;
+} fft_error_t;
+
+static void add_error(fft_error_t *e, double got, double expected)
+{
+    double d = fabs(got - expected);
+    e->max = d > e->max ? d : e->max;
+    e->sum_sq += d * d;
+    e->count++;
+}
+
+static void test_complex(void)
+{
+    static int16_t input[2 * FFT_MAX_POINTS];
+    for (size_t n = 2; n <= FFT_MAX_POINTS; n *= 2) {
+        fft_error_t e = { 0 };
+        for (int trial = 0; trial < 4; trial++) {
+            // Full scale works for the complex FFT: every stage halves
+            for (size_t i = 0; i < 2 * n; i++) {
+                input[i] = trial == 0 ? (i & 2 ? -32767 : 32767) : random_sample(trial == 1 ? 32767 : 16384);
+            }
+            dft(input, input + 1, 2, n);
+            memcpy(buf, input, 4 * n);
+            fft_q15_complex(buf, n);
+            for (size_t k = 0; k < n; k++) {
+                add_error(&e, buf[2 * k], ref_re[k]);
+                add_error(&e, buf[2 * k + 1], ref_im[k]);
+            }
+        }
+        if (n >= 8) {
+            printf("Complex %4zu points: max error %.2f LSB, rms %.2f LSB\n",
+                   n, e.max, sqrt(e.sum_sq / e.count));
+        }
+        CHECK(e.max <= COMPLEX_MAX_ERROR_LSB(n));
+        CHECK(sqrt(e.sum_sq / e.count) <= RMS_ERROR_LSB);
+    }
+}
+
+static void test_real(void)
+{
+    static int16_t input[FFT_MAX_POINTS];
+
+    for (size_t n = 4; n <= FFT_MAX_POINTS; n *= 2) {
+        fft_error_t e = { 0 };
+        for (int trial = 0; trial < 4; trial++) {
+            for (size_t i = 0; i < n; i++) {
+                input[i] = trial == 0 ? 16384 : trial == 1 ? (i & 1 ? -16384 : 16384) : random_sample(16384);
+            }
+            dft(input, NULL, 1, n);
+            memcpy(buf, input, 2 * n);
+            fft_q15_real(buf, n);
+
+            // DC and Nyquist share the first pair; the rest is X[1 .. n/2-1]
+            add_error(&e, buf[0], ref_re[0]);
+            add_error(&e, buf[1], ref_re[n / 2]);
+            for (size_t k = 1; k < n / 2; k++) {
+                add_error(&e, buf[2 * k], ref_re[k]);
+                add_error(&e, buf[2 * k + 1], ref_im[k]);
+            }
+        }
+        if (n >= 8) {
+            printf("Real    %4zu points: max error %.2f LSB, rms %.2f LSB\n",
+                   n, e.max, sqrt(e.sum_sq / e.count));
+        }
+        CHECK(e.max <= REAL_MAX_ERROR_LSB);
+        CHECK(sqrt(e.sum_sq / e.count) <= RMS_ERROR_LSB);
+    }
+}
+
+static void test_window_and_power(void)
+{
+    static uint32_t power[FFT_MAX_POINTS / 2];
+
+    for (size_t n = 8; n <= FFT_MAX_POINTS; n *= 2) {
+        double max_error = 0;
+        for (size_t i = 0; i < n; i++) {
+            buf[i] = 16384;
+        }
+        fft_q15_window_hann(buf, n);
+        for (size_t i = 0; i < n; i++) {
+            double w = 16384 * 0.5 * (1 - cos(2 * M_PI * i / n));
+            max_error = fmax(max_error, fabs(buf[i] - w));
+        }
+        CHECK(max_error <= 1.0);
+    }
+
+    for (size_t i = 0; i < 64; i++) {
+        buf[i] = random_sample(16384);
+    }
+    fft_q15_real(buf, 64);
+    fft_q15_power(buf, power, 64);
+    CHECK_EQ(power[0], buf[0] * buf[0]);
+    for (size_t k = 1; k < 32; k++) {
+        CHECK_EQ(power[k], buf[2 * k] * buf[2 * k] + buf[2 * k + 1] * buf[2 * k + 1]);
+    }
+}
+
+// The lesson's two-tone test signal, prepared like main.c: DC removed, scaled, windowed
+static void make_tones(int16_t *x, size_t n, double f1, double a1, double f2, double a2)
+{
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i / SAMPLE_RATE_HZ;
+        x[i] = (int16_t)lround(4 * (a1 * sin(2 * M_PI * f1 * t) + a2 * sin(2 * M_PI * f2 * t)));
+    }
+    fft_q15_window_hann(x, n);
+}
+
+static void test_peaks_and_bands(void)
+{
+    static uint32_t power[FFT_MAX_POINTS / 2];
+    static const spectrum_band_t bands[] = {
+        { "hum",   40,   140 },
+        { "tone1", 900,  1100 },
+        { "tone2", 3000, 3300 },
+    };
+    uint64_t energy[3];
+
+    for (size_t n = 256; n <= FFT_MAX_POINTS; n *= 2) {
+        make_tones(buf, n, 1000, 1200, 3150, 300);
+        fft_q15_real(buf, n);
+        fft_q15_power(buf, power, n);
+
+        spectrum_peak_t peaks[4];
+        size_t found = spectrum_find_peaks(power, n / 2, SAMPLE_RATE_HZ, 0, peaks, 4);
+        double bin_hz = (double)SAMPLE_RATE_HZ / n;
+        CHECK(found >= 2);
+        CHECK(fabs(peaks[0].freq_hz - 1000) < bin_hz / 4);
+        CHECK(fabs(peaks[1].freq_hz - 3150) < bin_hz / 4);
+        CHECK(peaks[0].power > peaks[1].power);
+        for (size_t i = 1; i < found; i++) {
+            CHECK(peaks[i - 1].power >= peaks[i].power);
+        }
+
+        spectrum_band_energy(power, n / 2, SAMPLE_RATE_HZ, bands, 3, energy);
+        // Amplitudes 1200 : 300 -> power 16 : 1
+        double ratio = (double)energy[1] / energy[2];
+        CHECK(ratio > 12 && ratio < 20);
+        CHECK(energy[0] * 1000 < energy[2]);
+    }
+
+    // Band edges: bin k at k * rate / n, low edge inclusive, high edge exclusive
+    for (size_t k = 0; k < 128; k++) {
+        power[k] = 1;
+    }
+    spectrum_band_t edges[] = { { "a", 0, 625 }, { "b", 625, 626 }, { "c", 39000, 50000 } };
+    spectrum_band_energy(power, 128, 40000, edges, 3, energy);
+    CHECK_EQ(energy[0], 4);     // Bins 0 .. 3 (0 .. 468.75 Hz)
+    CHECK_EQ(energy[1], 1);     // Bin 4 (625 Hz)
+    CHECK_EQ(energy[2], 0);     // Above the last bin
+}
+
+// Best time of many runs, as main.c reports the best of 10
+static void bench(void)
+{
+    static uint32_t power[FFT_MAX_POINTS / 2];
+    static int16_t signal[FFT_MAX_POINTS];
+
+    for (size_t n = 256; n <= FFT_MAX_POINTS; n *= 2) {
+        uint64_t best_fft = UINT64_MAX, best_total = UINT64_MAX;
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            make_tones(signal, n, 1000, 1200, 3150, 300);
+            uint64_t start = host_now_ns();
+            memcpy(buf, signal, 2 * n);
+            fft_q15_window_hann(buf, n);
+            uint64_t mid = host_now_ns();
+            fft_q15_real(buf, n);
+            fft_q15_power(buf, power, n);
+            uint64_t end = host_now_ns();
+            best_fft = end - mid < best_fft ? end - mid : best_fft;
+            best_total = end - start < best_total ? end - start : best_total;
+        }
+        size_t butterflies = (n / 4) * (size_t)log2(n / 2) + n / 4;
+        printf("%4zu points: FFT + power %6llu ns, with window %6llu ns (%.2f ns per butterfly)\n",
+               n, (unsigned long long)best_fft, (unsigned long long)best_total,
+               (double)best_fft / butterflies);
+    }
+}
+
+int main(void)
+{
+    srand(32);
+    test_complex();
+    test_real();
+    test_window_and_power();
+    test_peaks_and_bands();
+    bench();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""Lesson 29: checks of tools/gen_board.py (validation rules and generated tables).
+
+Run with ctest, or directly: python3 test_gen_board.py
+"""
+
+import copy
+import json
+import sys
+import tempfile
+import unittest
+from pathlib import Path
+
+LESSON = Path(__file__).resolve().parent.parent / "lesson_29_board_description"
+sys.dont_write_bytecode = True     # Keep __pycache__ out of the lesson folder
+sys.path.insert(0, str(LESSON / "tools"))
+
+import gen_board  # noqa: E402
+
+BOARD = json.loads((LESSON / "board.json").read_text())
+
+
+def board_with(*pins):
+    board = copy.deepcopy(BOARD)
+    board["pins"] = list(pins)
+    return board
+
+
+def errors_of(*pins):
+    return gen_board.validate(board_with(*pins))[0]
+
+
+def warnings_of(*pins):
+    return gen_board.validate(board_with(*pins))[1]
+
+
+class ValidateTest(unittest.TestCase):
+    def test_lesson_board_is_clean(self):
+        errors, warnings = gen_board.validate(BOARD)
+        self.assertEqual(errors, [])
+        self.assertEqual(warnings, [])
+
+    def test_duplicate_gpio_and_name(self):
+        errors = errors_of({"name": "A", "gpio": 13, "mode": "output"},
+                           {"name": "B", "gpio": 13, "mode": "input"},
+                           {"name": "A", "gpio": 14, "mode": "output"})
+        self.assertEqual(len(errors), 2)
+        self.assertIn("already used by A", errors[0])
+        self.assertIn("name used twice", errors[1])
+
+    def test_reserved_and_missing_gpios(self):
+        self.assertIn("reserved for SPI flash", errors_of({"name": "A", "gpio": 6, "mode": "output"})[0])
+        self.assertIn("reserved for PSRAM", errors_of({"name": "A", "gpio": 16, "mode": "input"})[0])
+        self.assertIn("does not exist", errors_of({"name": "A", "gpio": 24, "mode": "input"})[0])
+
+    def test_input_only_pins(self):
+        self.assertEqual(errors_of({"name": "IN", "gpio": 35, "mode": "input"}), [])
+        self.assertIn("input-only", errors_of({"name": "OUT", "gpio": 35, "mode": "output"})[0])
+        self.assertIn("input-only", errors_of({"name": "OD", "gpio": 36, "mode": "open_drain"})[0])
+        self.assertIn("no internal pull", errors_of({"name": "IN", "gpio": 39, "mode": "input", "pull": "up"})[0])
+
+    def test_input_only_pins_take_peripheral_inputs(self):
+        # UART RX and capture inputs are fine on GPIO 34-39, outputs are not
+        self.assertEqual(errors_of({"name": "RX", "gpio": 36, "mode": "peripheral", "direction": "input"}), [])
+        self.assertEqual(errors_of({"name": "CAP", "gpio": 39, "mode": "peripheral", "direction": "input"}), [])
+        self.assertIn("input-only", errors_of({"name": "TX", "gpio": 36, "mode": "peripheral"})[0])
+        self.assertIn("input-only", errors_of({"name": "SDA", "gpio": 37, "mode": "peripheral",
+                                               "direction": "bidirectional"})[0])
+        self.assertIn("unknown direction", errors_of({"name": "X", "gpio": 18, "mode": "peripheral",
+                                                      "direction": "in"})[0])
+
+    def test_adc_channel_matches_gpio(self):
+        for gpio, channel in gen_board.ADC_CHANNELS.items():
+            pin = {"name": "A", "gpio": gpio, "mode": "analog", "adc_channel": channel}
+            if gpio in BOARD["strapping"]:
+                pin["allow_strapping"] = True
+            self.assertEqual(errors_of(pin), [], channel)
+
+        errors = errors_of({"name": "A", "gpio": 34, "mode": "analog", "adc_channel": "ADC1_CHANNEL_0"})
+        self.assertIn("it is ADC1_CHANNEL_6", errors[0])
+        errors = errors_of({"name": "A", "gpio": 18, "mode": "analog"})
+        self.assertIn("has no ADC channel", errors[0])
+        errors = errors_of({"name": "A", "gpio": 23, "mode": "input", "adc_channel": "ADC1_CHANNEL_3"})
+        self.assertIn("has no ADC channel", errors[0])
+
+    def test_adc_channel_table_is_complete(self):
+        adc1 = sorted(c for c in gen_board.ADC_CHANNELS.values() if c.startswith("ADC1"))
+        adc2 = sorted(c for c in gen_board.ADC_CHANNELS.values() if c.startswith("ADC2"))
+        self.assertEqual(adc1, [f"ADC1_CHANNEL_{i}" for i in range(8)])
+        self.assertEqual(sorted(adc2, key=lambda c: int(c.rsplit("_", 1)[1])),
+                         [f"ADC2_CHANNEL_{i}" for i in range(10)])
+
+    def test_warnings(self):
+        warnings = warnings_of({"name": "A", "gpio": 25, "mode": "analog", "adc_channel": "ADC2_CHANNEL_8"})
+        self.assertIn("Wi-Fi", warnings[0])
+        warnings = warnings_of({"name": "B", "gpio": 12, "mode": "input"})
+        self.assertIn("strapping pin", warnings[0])
+
+
+class GenerateTest(unittest.TestCase):
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+        out = Path(self.tmp.name)
+        gen_board.generate(BOARD, out / "board_config.h", out / "board_config.c")
+        self.header = (out / "board_config.h").read_text()
+        self.source = (out / "board_config.c").read_text()
+
+    def tearDown(self):
+        self.tmp.cleanup()
+
+    def test_pin_defines(self):
+        for pin in BOARD["pins"]:
+            self.assertIn(f"#define BOARD_PIN_{pin['name']} GPIO_NUM_{pin['gpio']}\n", self.header)
+        self.assertIn("#define BOARD_ADC_ANALOG_IN ADC1_CHANNEL_6\n", self.header)
+        self.assertIn("#define BOARD_SEGMENT_COUNT 7\n", self.header)
+
+    def test_one_gpio_config_per_mode_and_pull(self):
+        # Outputs, the pulled-up input and the open-drain pin: three calls for ten pins
+        configured = [p for p in BOARD["pins"] if gen_board.MODES[p["mode"]][1]]
+        combos = {(p["mode"], p.get("pull", "none")) for p in configured}
+        self.assertEqual(len(configured), 10)
+        self.assertIn(f"#define BOARD_GPIO_CONFIG_COUNT {len(combos)}\n", self.header)
+        self.assertEqual(self.source.count(".pin_bit_mask"), len(combos))
+
+    def test_initial_level_masks(self):
+        high = sum(1 << p["gpio"] for p in BOARD["pins"]
+                   if p["mode"] in gen_board.OUTPUT_MODES and p.get("level", 0))
+        low = sum(1 << p["gpio"] for p in BOARD["pins"]
+                  if p["mode"] in gen_board.OUTPUT_MODES and not p.get("level", 0))
+        self.assertEqual(high & low, 0)
+        self.assertIn(f"BOARD_OUTPUT_HIGH_MASK {gen_board.mask_literal(high)}", self.header)
+        self.assertIn(f"BOARD_OUTPUT_LOW_MASK  {gen_board.mask_literal(low)}", self.header)
+
+    def test_peripheral_and_analog_pins_are_not_configured(self):
+        masks = [int(line.split("=")[1].strip().rstrip(",").removesuffix("ULL"), 16)
+                 for line in self.source.splitlines() if ".pin_bit_mask" in line]
+        configured = 0
+        for mask in masks:
+            self.assertEqual(configured & mask, 0)
+            configured |= mask
+        for pin in BOARD["pins"]:
+            expected = gen_board.MODES[pin["mode"]][1] is not None
+            self.assertEqual(bool(configured & (1 << pin["gpio"])), expected, pin["name"])
+
+
+if __name__ == "__main__":
+    unittest.main()
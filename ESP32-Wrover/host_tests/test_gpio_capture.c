@@ -0,0 +1,314 @@
+// Lesson 34: edge sequences replayed through the capture ISR on a fake 240 MHz cycle counter.
+// A small interrupt model decides when the ISR runs: it starts a fixed latency after the
+// edge, or after the previous ISR if that is still busy, and edges that happen before it
+// reads the pin are merged, as on the chip. Checks clean PWM, the counter wrap, missed edges
+// and ring overflows (no measurement across lost edges), and the highest edge rate the
+// model sustains; times the ISR and capture_measure() per edge on the host.
+
+#include <math.h>
+#include <string.h>
+
+#include "host_idf.h"
+#include "host_test.h"
+#include "capture.h"
+
+#define CPU_MHZ         240
+#define PIN             GPIO_NUM_18
+#define MAX_EDGES       4096
+#define BENCH_EDGES     2000000
+
+// Assumed cost of one GPIO interrupt on the ESP32 at 240 MHz: entry through the GPIO ISR
+// service until capture_isr() reads the counter, then the rest of the ISR and the exit.
+// The lesson's loopback self-test measures the real limit on the board.
+#define ISR_LATENCY_CYCLES (2 * CPU_MHZ)
+#define ISR_BUSY_CYCLES    (1 * CPU_MHZ)
+
+#define US(us) ((uint64_t)(us) * CPU_MHZ)
+
+typedef struct {
+    uint64_t t;             // Signal time in cycles
+    uint8_t level;
+} signal_edge_t;
+
+static signal_edge_t edges[MAX_EDGES];
+static size_t edge_count;
+static int channel;
+
+static struct {
+    uint32_t base;          // Cycle counter at signal time 0
+    uint64_t free_at;       // The previous ISR runs until then
+    uint64_t next_drain;
+    uint32_t latency, busy;
+    uint64_t drain;         // The reader runs capture_measure() this often; 0 = never
+    uint32_t high_ns, low_ns, tolerance_ns;
+    uint32_t measures, wrong;
+    capture_measurement_t last;
+} sim;
+
+static void begin(uint32_t base, uint32_t latency, uint32_t busy, uint64_t drain)
+{
+    host_gpio_set_input(PIN, 0);
+    capture_reset(channel);
+    memset(&sim, 0, sizeof(sim));
+    sim.base = base;
+    sim.latency = latency;
+    sim.busy = busy;
+    sim.drain = drain;
+    edge_count = 0;
+}
+
+static void add_edge(uint64_t t, int level)
+{
+    if (edge_count < MAX_EDGES) {
+        edges[edge_count++] = (signal_edge_t){ t, level };
+    }
+}
+
+// Starts low: rising edge at t0 + k * period, falling edge `high` later
+static uint64_t add_pwm(uint64_t t0, size_t periods, uint64_t period, uint64_t high)
+{
+    for (size_t k = 0; k < periods; k++) {
+        add_edge(t0 + k * period, 1);
+        add_edge(t0 + k * period + high, 0);
+    }
+    return t0 + periods * period;
+}
+
+static bool near(uint32_t got, uint32_t expected)
+{
+    return (got > expected ? got - expected : expected - got) <= sim.tolerance_ns;
+}
+
+static void measure(void)
+{
+    capture_measurement_t *m = &sim.last;
+    capture_measure(channel, m);
+    sim.measures++;
+    if ((m->high_ns && !near(m->high_ns, sim.high_ns)) || (m->low_ns && !near(m->low_ns, sim.low_ns)) ||
+        (m->period_ns && !near(m->period_ns, sim.high_ns + sim.low_ns))) {
+        if (sim.wrong++ == 0) {
+            printf("  wrong: high %u low %u period %u ns\n", m->high_ns, m->low_ns, m->period_ns);
+        }
+    }
+}
+
+// Runs the interrupts for all edges; edges before the ISR reads the pin share one interrupt
+static void replay(void)
+{
+    size_t i = 0;
+    while (i < edge_count) {
+        uint64_t start = (edges[i].t > sim.free_at ? edges[i].t : sim.free_at) + sim.latency;
+        uint8_t level = edges[i++].level;
+        while (i < edge_count && edges[i].t <= start) {
+            level = edges[i++].level;
+        }
+        host_cpu_set_cycles(sim.base + (uint32_t)start);
+        host_gpio_trigger(PIN, level);
+        sim.free_at = start + sim.busy;
+        if (sim.drain && start >= sim.next_drain) {
+            measure();
+            sim.next_drain = start + sim.drain;
+        }
+    }
+}
+
+static void expect_pulses(uint32_t high_ns, uint32_t low_ns, uint32_t tolerance_ns)
+{
+    sim.high_ns = high_ns;
+    sim.low_ns = low_ns;
+    sim.tolerance_ns = tolerance_ns;
+}
+
+// ---- Clean signals ----
+
+static void test_clean_pwm(void)
+{
+    static const struct {
+        uint32_t hz;
+        uint32_t duty_pct;
+        uint32_t base;
+    } cases[] = {
+        { 1000,  25, 12345 },
+        { 50,    50, 0 },
+        { 10000, 10, 0xFFFFFFFFu - 3 * 24000 },     // The counter wraps after 3 periods
+        { 20000, 90, 0x80000000u },
+    };
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        uint64_t period = US(1000000) / cases[c].hz;
+        uint64_t high = period * cases[c].duty_pct / 100;
+        size_t periods = cases[c].hz < 100 ? 20 : 100;
+
+        begin(cases[c].base, ISR_LATENCY_CYCLES, ISR_BUSY_CYCLES, US(500));
+        expect_pulses(high * 1000 / CPU_MHZ, (period - high) * 1000 / CPU_MHZ, 0);
+        add_pwm(US(100), periods, period, high);
+        replay();
+        measure();
+
+        capture_counters_t counters;
+        capture_get_counters(channel, &counters);
+        CHECK_EQ(counters.edges, 2 * periods);
+        CHECK_EQ(counters.missed, 0);
+        CHECK_EQ(counters.overflows, 0);
+        CHECK_EQ(sim.wrong, 0);
+        CHECK_EQ(sim.last.period_ns, period * 1000 / CPU_MHZ);
+        CHECK(fabsf(sim.last.frequency_hz - cases[c].hz) < cases[c].hz * 1e-4f);
+        CHECK(fabsf(sim.last.duty * 100 - cases[c].duty_pct) < 0.01f);
+    }
+
+    // Nothing new: the last values stay and no period is reported
+    capture_measurement_t m;
+    CHECK(!capture_measure(channel, &m));
+    CHECK_EQ(m.period_ns, sim.last.period_ns);
+}
+
+// ---- Lost edges ----
+
+// A 0.5 us glitch inside a pulse is over before the ISR reads the pin: two edges become
+// one interrupt that reads the level from before the glitch
+static void test_missed_edge(void)
+{
+    for (int in_high = 1; in_high >= 0; in_high--) {
+        uint64_t period = US(1000), high = US(250);
+        begin(0, ISR_LATENCY_CYCLES, ISR_BUSY_CYCLES, 1);     // Measure after every interrupt
+        expect_pulses(250000, 750000, 0);
+        uint64_t t = add_pwm(US(10), 5, period, high);
+        uint64_t glitch = in_high ? t + US(100) : t + high + US(300);
+        add_edge(t, 1);
+        if (!in_high) {
+            add_edge(t + high, 0);
+        }
+        add_edge(glitch, !in_high);
+        add_edge(glitch + US(1) / 2, in_high);
+        if (in_high) {
+            add_edge(t + high, 0);
+        }
+        add_pwm(t + period, 5, period, high);
+        replay();
+
+        capture_counters_t counters;
+        capture_get_counters(channel, &counters);
+        CHECK_EQ(counters.missed, 1);
+        CHECK_EQ(counters.edges, 2 * 11 + 1);
+        CHECK_EQ(sim.wrong, 0);             // No interval across the glitch
+        CHECK(sim.last.period_ns == 1000000);
+        CHECK(fabsf(sim.last.frequency_hz - 1000) < 0.1f);
+    }
+
+    // Raw edges carry the flag on the edge after the loss
+    begin(0, ISR_LATENCY_CYCLES, ISR_BUSY_CYCLES, 0);
+    add_edge(US(10), 1);
+    add_edge(US(20), 0);
+    add_edge(US(20) + 10, 1);
+    add_edge(US(30), 0);
+    replay();
+    capture_edge_t raw[8];
+    CHECK_EQ(capture_read(channel, raw, 8), 3);
+    CHECK(raw[0].level == 1 && !raw[0].gap);
+    CHECK(raw[1].level == 1 && raw[1].gap);
+    CHECK(raw[2].level == 0 && !raw[2].gap);
+    CHECK_EQ(raw[2].cycles - raw[0].cycles, US(20));
+}
+
+// The reader stalls: the ring fills and the edges after it are dropped
+static void test_overflow(void)
+{
+    uint64_t period = US(1000), high = US(300);
+    begin(0, ISR_LATENCY_CYCLES, ISR_BUSY_CYCLES, 0);
+    expect_pulses(300000, 700000, 0);
+    uint64_t t = add_pwm(US(10), 100, period, high);    // 200 edges, nobody reading
+    replay();
+
+    capture_counters_t counters;
+    capture_get_counters(channel, &counters);
+    CHECK_EQ(counters.overflows, 200 - CAPTURE_RING_SIZE);
+    measure();
+    CHECK_EQ(sim.wrong, 0);
+
+    // Reading again: the first edge after the drop is flagged, no interval spans the hole.
+    // The last edge kept was a falling one, so a low time across the hole would be wrong.
+    edge_count = 0;
+    sim.drain = 1;
+    add_edge(t + US(100), 1);
+    add_edge(t + US(100) + high, 0);
+    add_pwm(t + US(100) + period, 20, period, high);
+    replay();
+    measure();
+    CHECK_EQ(sim.wrong, 0);
+    CHECK_EQ(sim.last.low_ns, 700000);
+    CHECK(fabsf(sim.last.frequency_hz - 1000) < 0.1f);
+}
+
+// ---- Highest edge rate ----
+
+// main.c's sweep on the interrupt model: the reader drains every 100 us, like the busy loop
+// on the board; a rate is lossless when nothing was missed or dropped
+static void sweep(void)
+{
+    static const uint32_t sweep_hz[] = { 1000, 2000, 5000, 10000, 20000, 50000, 100000, 150000, 200000 };
+    uint32_t best = 0;
+
+    printf("Model: ISR starts %u us after the edge and runs %u us more\n",
+           ISR_LATENCY_CYCLES / CPU_MHZ, ISR_BUSY_CYCLES / CPU_MHZ);
+    printf("Signal Hz   Edges/s  Missed  Overflow  Measured Hz\n");
+    for (size_t i = 0; i < sizeof(sweep_hz) / sizeof(sweep_hz[0]); i++) {
+        uint64_t period = US(1000000) / sweep_hz[i];
+        begin(0, ISR_LATENCY_CYCLES, ISR_BUSY_CYCLES, US(100));
+        expect_pulses(period / 2 * 1000 / CPU_MHZ, (period - period / 2) * 1000 / CPU_MHZ, 1);
+        add_pwm(US(10), MAX_EDGES / 2, period, period / 2);
+        replay();
+        measure();
+
+        capture_counters_t c;
+        capture_get_counters(channel, &c);
+        bool lossless = c.missed == 0 && c.overflows == 0 && c.edges == MAX_EDGES;
+        printf("%9u %9u %7u %9u %12.1f %s\n", sweep_hz[i], 2 * sweep_hz[i], c.missed, c.overflows,
+               sim.last.frequency_hz, lossless ? "ok" : "LOSS");
+        if (lossless) {
+            CHECK_EQ(sim.wrong, 0);
+            CHECK(fabsf(sim.last.frequency_hz - sweep_hz[i]) < sweep_hz[i] * 1e-3f);
+            best = 2 * sweep_hz[i];
+        }
+    }
+    printf("Max edge rate without loss: %u edges/s\n", best);
+
+    // An edge every latency + busy cycles is the limit
+    CHECK_EQ(best, 2 * 150000);
+    CHECK(best <= CPU_MHZ * 1000000u / (ISR_LATENCY_CYCLES + ISR_BUSY_CYCLES));
+}
+
+// Host time per edge for the ISR and for capture_measure()
+static void bench(void)
+{
+    begin(0, 0, 0, 0);
+    uint64_t isr_ns = 0, measure_ns = 0;
+    capture_measurement_t m;
+    for (uint32_t i = 0; i < BENCH_EDGES; i += CAPTURE_RING_SIZE) {
+        uint64_t start = host_now_ns();
+        for (uint32_t j = 0; j < CAPTURE_RING_SIZE; j++) {
+            host_cpu_set_cycles((i + j) * 1000);
+            host_gpio_trigger(PIN, j & 1 ? 0 : 1);
+        }
+        uint64_t mid = host_now_ns();
+        capture_measure(channel, &m);
+        measure_ns += host_now_ns() - mid;
+        isr_ns += mid - start;
+    }
+    CHECK_EQ(m.period_ns, 2000 * 1000 / CPU_MHZ);
+    printf("Host: ISR %.1f ns per edge, capture_measure() %.1f ns per edge\n",
+           (double)isr_ns / BENCH_EDGES, (double)measure_ns / BENCH_EDGES);
+}
+
+int main(void)
+{
+    host_cpu_set_fake_cycles(CPU_MHZ);
+    CHECK_EQ(capture_init(), ESP_OK);
+    CHECK_EQ(capture_add_pin(PIN, GPIO_FLOATING, &channel), ESP_OK);
+
+    test_clean_pwm();
+    test_missed_edge();
+    test_overflow();
+    sweep();
+    bench();
+    return HOST_TEST_RESULT();
+}
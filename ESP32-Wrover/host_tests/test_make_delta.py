@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Lesson 24: checks of tools/make_delta.py and tools/sign_image.py.
+
+A reference applier in Python checks the patches, then the C applier from
+ota_update.c (through test_ota_update) applies one to file-backed partitions.
+
+Run with ctest, or directly: python3 test_make_delta.py [path/to/test_ota_update]
+"""
+
+import hashlib
+import hmac
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+import unittest
+from pathlib import Path
+
+LESSON = Path(__file__).resolve().parent.parent / "lesson_24_ota_updates"
+sys.dont_write_bytecode = True     # Keep __pycache__ out of the lesson folder
+sys.path.insert(0, str(LESSON / "tools"))
+
+import make_delta  # noqa: E402
+import sign_image  # noqa: E402
+
+OTA_TEST = str(Path(sys.argv.pop(1)).resolve()) if len(sys.argv) > 1 else None
+SECRET = b"host-test-secret"       # OTA_SECRET in test_ota_update.c
+
+
+def apply_delta(old, patch):
+    """Reference applier, written from the format description in ota_update.h."""
+    assert patch[:4] == b"DPT1"
+    (target_size,) = struct.unpack_from("<I", patch, 4)
+    out = bytearray()
+    pos = 8
+    while True:
+        op = patch[pos:pos + 1]
+        pos += 1
+        if op == b"C":
+            offset, length = struct.unpack_from("<II", patch, pos)
+            pos += 8
+            assert offset + length <= len(old)
+            out += old[offset:offset + length]
+        elif op == b"I":
+            (length,) = struct.unpack_from("<I", patch, pos)
+            pos += 4
+            out += patch[pos:pos + length]
+            pos += length
+        elif op == b"E":
+            break
+        else:
+            raise ValueError(f"bad opcode {op!r} at {pos - 1}")
+    assert pos == len(patch), "data after the end marker"
+    assert len(out) == target_size
+    return bytes(out)
+
+
+def firmware(size, seed):
+    image = bytearray(random.Random(seed).randbytes(size))
+    image[0] = 0xE9
+    return image
+
+
+def edited(old):
+    """A rebuild with a few changes: patched bytes, a grown function, a shifted tail."""
+    new = bytearray(old)
+    new[1000:1004] = b"\x01\x02\x03\x04"
+    new[100000:100000] = random.Random(7).randbytes(300)
+    del new[200000:200050]
+    new += b"version 1.1\0"
+    return bytes(new)
+
+
+class MakeDeltaTest(unittest.TestCase):
+    def test_round_trip(self):
+        old = firmware(256 * 1024, 1)
+        new = edited(old)
+        patch = make_delta.make_delta(bytes(old), new)
+        self.assertEqual(apply_delta(old, patch), new)
+        self.assertLess(len(patch), len(new) // 50)
+
+    def test_identical_and_unrelated_images(self):
+        old = firmware(64 * 1024, 2)
+        patch = make_delta.make_delta(bytes(old), bytes(old))
+        self.assertEqual(apply_delta(old, patch), old)
+        self.assertLess(len(patch), 32)
+
+        other = firmware(64 * 1024, 3)
+        patch = make_delta.make_delta(bytes(old), bytes(other))
+        self.assertEqual(apply_delta(old, patch), other)
+        self.assertLess(len(patch), len(other) + 32)    # One insert, no blow-up
+
+    def test_small_and_empty_images(self):
+        for old, new in [(b"", b"\xe9abc"), (b"\xe9abc", b""), (b"\xe9" * 10, b"\xe9" * 100)]:
+            self.assertEqual(apply_delta(old, make_delta.make_delta(old, new)), new)
+
+    def test_speed(self):
+        old = firmware(1024 * 1024, 4)
+        new = edited(old)
+        start = time.perf_counter()
+        patch = make_delta.make_delta(bytes(old), new)
+        seconds = time.perf_counter() - start
+        print(f"\nmake_delta: 1 MB image, patch {len(patch)} bytes "
+              f"({100 * len(patch) / len(new):.2f}%) in {seconds:.2f} s", file=sys.stderr)
+        self.assertEqual(apply_delta(old, patch), new)
+
+
+class SignImageTest(unittest.TestCase):
+    def test_headers(self):
+        image = firmware(4096, 5)
+        sha, signature = sign_image.sign(bytes(image), SECRET)
+        digest = hashlib.sha256(image).digest()
+        self.assertEqual(sha, digest.hex())
+        self.assertEqual(signature, hmac.new(SECRET, digest, "sha256").hexdigest())
+        self.assertNotEqual(signature, sign_image.sign(bytes(image), b"other")[1])
+
+
+@unittest.skipIf(OTA_TEST is None, "path to test_ota_update not given")
+class DeviceApplierTest(unittest.TestCase):
+    def test_patch_applied_by_ota_update_c(self):
+        old = firmware(300 * 1024, 6)
+        new = edited(old)
+        with tempfile.TemporaryDirectory() as tmp:
+            tmp = Path(tmp)
+            (tmp / "running.bin").write_bytes(old)
+            (tmp / "new.bin").write_bytes(new)
+            (tmp / "patch.bin").write_bytes(make_delta.make_delta(bytes(old), new))
+            result = subprocess.run([OTA_TEST, str(tmp / "running.bin"), str(tmp / "patch.bin"),
+                                     str(tmp / "new.bin")], cwd=tmp, capture_output=True, text=True)
+        self.assertEqual(result.returncode, 0, result.stdout + result.stderr)
+        self.assertIn("OK: received", result.stdout)
+
+
+if __name__ == "__main__":
+    unittest.main()
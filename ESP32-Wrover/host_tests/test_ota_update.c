@@ -0,0 +1,450 @@
+// Lesson 24: OTA updates through the HTTP handlers, on file-backed factory/ota_0/ota_1
+// partitions. Signature and hash checks, full and delta updates split at any byte, broken
+// patches; throughput and peak RAM of an update.
+//
+// With arguments it applies a patch made by tools/make_delta.py (test_make_delta.py does this):
+//   test_ota_update <running.bin> <patch.bin> <new.bin>
+
+#include <pthread.h>
+#include <string.h>
+
+#define OTA_SECRET "host-test-secret"
+#include "ota_update.c"       // For the static buffers and the session, to report their size
+
+#include "host_idf.h"
+#include "host_test.h"
+
+#define PARTITION_SIZE  (1024 * 1024)
+#define IMAGE_SIZE      (640 * 1024)
+#define TCP_SEGMENT     1460            // What one httpd_req_recv() typically returns
+#define STACK_SIZE      (64 * 1024)
+
+typedef struct {
+    char sha[65];
+    char signature[65];
+} update_headers_t;
+
+static const esp_partition_t *factory, *ota_0, *ota_1;
+static uint8_t old_image[IMAGE_SIZE], new_image[IMAGE_SIZE], check_buf[IMAGE_SIZE];
+static uint8_t patch[IMAGE_SIZE + 64];
+
+static void to_hex(const uint8_t *in, char out[65])
+{
+    for (int i = 0; i < 32; i++) {
+        sprintf(out + 2 * i, "%02x", in[i]);
+    }
+}
+
+// What tools/sign_image.py prints
+static void sign(const uint8_t *image, size_t len, const char *secret, update_headers_t *h)
+{
+    uint8_t digest[32], mac[32];
+    mbedtls_sha256(image, len, digest, 0);
+    mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), (const uint8_t *)secret,
+                    strlen(secret), digest, sizeof(digest), mac);
+    to_hex(digest, h->sha);
+    to_hex(mac, h->signature);
+}
+
+// Random bytes that start like an app image
+static void make_image(uint8_t *image, size_t len, uint32_t seed)
+{
+    for (size_t i = 0; i < len; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        image[i] = (uint8_t)seed;
+    }
+    image[0] = ESP_IMAGE_HEADER_MAGIC;
+}
+
+static void install_running(const uint8_t *image, size_t len)
+{
+    host_partition_wipe(factory);
+    CHECK_EQ(esp_partition_write(factory, 0, image, len), ESP_OK);
+    host_ota_set_running(factory);
+    host_partition_reset_stats(ota_0);
+}
+
+static void setup(void)
+{
+    host_clock_set_fake(0);     // The handler's vTaskDelay() before the restart costs nothing
+    factory = host_partition_add("factory", ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_FACTORY,
+                                 PARTITION_SIZE, "ota_factory.bin");
+    ota_0 = host_partition_add("ota_0", ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0,
+                               PARTITION_SIZE, "ota_0.bin");
+    ota_1 = host_partition_add("ota_1", ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1,
+                               PARTITION_SIZE, "ota_1.bin");
+    CHECK(factory && ota_0 && ota_1);
+    CHECK_EQ(ota_update_register(NULL), ESP_OK);
+
+    make_image(old_image, IMAGE_SIZE, 1);
+    memcpy(new_image, old_image, IMAGE_SIZE);
+    make_image(new_image + 200000, 3000, 2);     // A changed function...
+    make_image(new_image + 500000, 100, 3);      // ...and a changed constant
+    new_image[200000] = 0x55;
+    new_image[500000] = 0xAA;
+}
+
+static int post(httpd_req_t *req, const char *uri, const void *body, size_t len,
+                const update_headers_t *h, size_t chunk)
+{
+    host_http_request(req, HTTP_POST, uri, body, len);
+    req->host_chunk = chunk;
+    if (h && h->sha[0]) {
+        host_http_add_header(req, "X-SHA256", h->sha);
+    }
+    if (h && h->signature[0]) {
+        host_http_add_header(req, "X-Signature", h->signature);
+    }
+    CHECK_EQ(host_http_call(req), ESP_OK);
+    return req->host_status;
+}
+
+static bool partition_holds(const esp_partition_t *part, const uint8_t *image, size_t len)
+{
+    return esp_partition_read(part, 0, check_buf, len) == ESP_OK && memcmp(check_buf, image, len) == 0;
+}
+
+// ---- Delta patches, in the format of tools/make_delta.py ----
+
+static size_t patch_len;
+
+static void patch_u32(uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        patch[patch_len++] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static void patch_begin(uint32_t target_size)
+{
+    patch_len = 0;
+    memcpy(patch, "DPT1", 4);
+    patch_len = 4;
+    patch_u32(target_size);
+}
+
+static void patch_copy(uint32_t offset, uint32_t length)
+{
+    patch[patch_len++] = 'C';
+    patch_u32(offset);
+    patch_u32(length);
+}
+
+static void patch_insert(const uint8_t *data, uint32_t length)
+{
+    patch[patch_len++] = 'I';
+    patch_u32(length);
+    memcpy(patch + patch_len, data, length);
+    patch_len += length;
+}
+
+// Copy what is unchanged, insert the two changed ranges
+static void build_patch(void)
+{
+    patch_begin(IMAGE_SIZE);
+    patch_copy(0, 200000);
+    patch_insert(new_image + 200000, 3000);
+    patch_copy(203000, 297000);
+    patch_insert(new_image + 500000, 100);
+    patch_copy(500100, IMAGE_SIZE - 500100);
+    patch[patch_len++] = 'E';
+}
+
+// ---- Tests ----
+
+static void test_full_update(void)
+{
+    update_headers_t h;
+    httpd_req_t req;
+    host_partition_stats_t stats;
+
+    install_running(old_image, IMAGE_SIZE);
+    sign(new_image, IMAGE_SIZE, OTA_SECRET, &h);
+    int restarts = host_restart_count();
+
+    host_http_request(&req, HTTP_POST, "/update", new_image, IMAGE_SIZE);
+    req.host_chunk = TCP_SEGMENT;
+    req.host_timeout_every = 7;             // Slow network: the handler must keep going
+    host_http_add_header(&req, "X-SHA256", h.sha);
+    host_http_add_header(&req, "X-Signature", h.signature);
+    CHECK_EQ(host_http_call(&req), ESP_OK);
+
+    CHECK_EQ(req.host_status, 200);
+    CHECK(strncmp(req.host_reply, "OK:", 3) == 0);
+    CHECK(partition_holds(ota_0, new_image, IMAGE_SIZE));
+    CHECK(esp_ota_get_boot_partition() == ota_0);
+    CHECK_EQ(host_restart_count(), restarts + 1);
+
+    // Every byte programmed once, only the sectors the image needs erased
+    host_partition_get_stats(ota_0, &stats);
+    CHECK_EQ(stats.bytes_written, IMAGE_SIZE);
+    CHECK_EQ(stats.bytes_erased, (IMAGE_SIZE + 4095) / 4096 * 4096);
+}
+
+static void test_signature(void)
+{
+    update_headers_t good, other;
+    httpd_req_t req;
+    host_partition_stats_t stats;
+
+    install_running(old_image, IMAGE_SIZE);
+    host_ota_set_running(factory);
+    sign(new_image, IMAGE_SIZE, OTA_SECRET, &good);
+
+    // No signature: only integrity, anyone could have made it
+    update_headers_t h = good;
+    h.signature[0] = '\0';
+    CHECK_EQ(post(&req, "/update", new_image, IMAGE_SIZE, &h, 0), 403);
+
+    // Signed with another secret
+    sign(new_image, IMAGE_SIZE, "guessed-secret", &h);
+    CHECK_EQ(post(&req, "/update", new_image, IMAGE_SIZE, &h, 0), 403);
+
+    // A valid signature, but for another image's hash
+    sign(old_image, IMAGE_SIZE, OTA_SECRET, &other);
+    h = good;
+    memcpy(h.signature, other.signature, sizeof(h.signature));
+    CHECK_EQ(post(&req, "/update", new_image, IMAGE_SIZE, &h, 0), 403);
+
+    // Not a hex digest
+    h = good;
+    h.signature[10] = 'x';
+    CHECK_EQ(post(&req, "/update", new_image, IMAGE_SIZE, &h, 0), 403);
+
+    // strtoul() reads " 7" and "+7" as 0x07, so a valid signature with its leading zero
+    // replaced would still match
+    int zero = -1;
+    for (int i = 0; i < 64 && zero < 0; i += 2) {
+        if (good.signature[i] == '0') {
+            zero = i;
+        }
+    }
+    CHECK(zero >= 0);
+    h = good;
+    h.signature[zero] = ' ';
+    CHECK_EQ(post(&req, "/update", new_image, IMAGE_SIZE, &h, 0), 403);
+    h.signature[zero] = '+';
+    CHECK_EQ(post(&req, "/update", new_image, IMAGE_SIZE, &h, 0), 403);
+
+    // Rejected before flash was touched
+    host_partition_get_stats(ota_0, &stats);
+    CHECK_EQ(stats.bytes_written, 0);
+    CHECK_EQ(stats.erase_calls, 0);
+    CHECK_EQ(req.host_recv_calls, 0);
+
+    // Signed hash, but the body was changed on the way: the SHA-256 check catches it
+    new_image[IMAGE_SIZE / 2] ^= 1;
+    CHECK_EQ(post(&req, "/update", new_image, IMAGE_SIZE, &good, TCP_SEGMENT), 400);
+    new_image[IMAGE_SIZE / 2] ^= 1;
+    CHECK(esp_ota_get_boot_partition() != ota_1);
+
+    // Missing hash
+    h = good;
+    h.sha[0] = '\0';
+    CHECK_EQ(post(&req, "/update", new_image, IMAGE_SIZE, &h, 0), 400);
+}
+
+static void test_not_an_image(void)
+{
+    static uint8_t junk[8192];
+    update_headers_t h;
+    httpd_req_t req;
+
+    install_running(old_image, IMAGE_SIZE);
+    memset(junk, 0x42, sizeof(junk));
+    sign(junk, sizeof(junk), OTA_SECRET, &h);
+    CHECK_EQ(post(&req, "/update", junk, sizeof(junk), &h, 0), 400);
+}
+
+static void test_delta_update(void)
+{
+    static const size_t chunks[] = { 1, 3, 9, TCP_SEGMENT, OTA_CHUNK_SIZE };
+    update_headers_t h;
+    httpd_req_t req;
+
+    build_patch();
+    sign(new_image, IMAGE_SIZE, OTA_SECRET, &h);
+    CHECK(patch_len < IMAGE_SIZE / 100);
+
+    // Operations split at every possible place between two receives
+    for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        install_running(old_image, IMAGE_SIZE);
+        host_partition_wipe(ota_0);
+        CHECK_EQ(post(&req, "/update/delta", patch, patch_len, &h, chunks[i]), 200);
+        CHECK(partition_holds(ota_0, new_image, IMAGE_SIZE));
+    }
+}
+
+static void test_broken_patches(void)
+{
+    update_headers_t h;
+    httpd_req_t req;
+
+    install_running(old_image, IMAGE_SIZE);
+    sign(new_image, IMAGE_SIZE, OTA_SECRET, &h);
+
+    // Copy from beyond the running partition
+    patch_begin(IMAGE_SIZE);
+    patch_copy(PARTITION_SIZE - 10, 100);
+    patch[patch_len++] = 'E';
+    CHECK_EQ(post(&req, "/update/delta", patch, patch_len, &h, 0), 400);
+
+    // No end marker
+    build_patch();
+    CHECK_EQ(post(&req, "/update/delta", patch, patch_len - 1, &h, TCP_SEGMENT), 400);
+
+    // Data after the end marker
+    build_patch();
+    patch[patch_len++] = 'I';
+    CHECK_EQ(post(&req, "/update/delta", patch, patch_len, &h, TCP_SEGMENT), 400);
+
+    // Target size that does not match the result
+    build_patch();
+    patch[4] ^= 1;
+    CHECK_EQ(post(&req, "/update/delta", patch, patch_len, &h, TCP_SEGMENT), 400);
+
+    // Unknown opcode and wrong magic
+    build_patch();
+    patch[8] = 'X';
+    CHECK_EQ(post(&req, "/update/delta", patch, patch_len, &h, TCP_SEGMENT), 400);
+    build_patch();
+    patch[3] = '2';
+    CHECK_EQ(post(&req, "/update/delta", patch, patch_len, &h, TCP_SEGMENT), 400);
+
+    // Larger than the target partition
+    patch_begin(2 * PARTITION_SIZE);
+    patch_copy(0, IMAGE_SIZE);
+    patch_copy(0, IMAGE_SIZE);
+    patch[patch_len++] = 'E';
+    CHECK_EQ(post(&req, "/update/delta", patch, patch_len, &h, 0), 400);
+
+    CHECK(esp_ota_get_boot_partition() != ota_1);
+}
+
+// ---- Benchmark: throughput and peak RAM ----
+
+typedef struct {
+    const char *uri;
+    const void *body;
+    size_t len;
+    update_headers_t h;
+    int status;
+    size_t heap_before;
+    double seconds;
+} bench_run_t;
+
+static void *bench_thread(void *arg)
+{
+    bench_run_t *run = arg;
+    httpd_req_t req;
+    run->heap_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    uint64_t start = host_now_ns();
+    run->status = post(&req, run->uri, run->body, run->len, &run->h, OTA_CHUNK_SIZE);
+    run->seconds = (host_now_ns() - start) / 1e9;
+    return NULL;
+}
+
+// The handler runs on its own thread with a painted stack, to see how much of it is used
+static size_t run_on_painted_stack(bench_run_t *run)
+{
+    static uint8_t stack[STACK_SIZE] __attribute__((aligned(64)));
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    memset(stack, 0xA5, sizeof(stack));
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, sizeof(stack));
+    CHECK_EQ(pthread_create(&thread, &attr, bench_thread, run), 0);
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+
+    size_t untouched = 0;
+    while (untouched < sizeof(stack) && stack[untouched] == 0xA5) {
+        untouched++;
+    }
+    return sizeof(stack) - untouched;
+}
+
+static void bench(void)
+{
+    bench_run_t full = { .uri = "/update", .body = new_image, .len = IMAGE_SIZE };
+    bench_run_t delta = { .uri = "/update/delta", .body = patch };
+
+    install_running(old_image, IMAGE_SIZE);
+    sign(new_image, IMAGE_SIZE, OTA_SECRET, &full.h);
+    size_t full_stack = run_on_painted_stack(&full);
+    CHECK_EQ(full.status, 200);
+    size_t full_heap = full.heap_before - session.min_free_heap;
+
+    build_patch();
+    delta.len = patch_len;
+    delta.h = full.h;
+    size_t delta_stack = run_on_painted_stack(&delta);
+    CHECK_EQ(delta.status, 200);
+    size_t delta_heap = delta.heap_before - session.min_free_heap;
+
+    printf("Full image: %u bytes in %.1f ms, %.1f MB/s (SHA-256 + emulated flash)\n",
+           IMAGE_SIZE, full.seconds * 1e3, IMAGE_SIZE / full.seconds / 1e6);
+    printf("Delta patch: %u bytes (%.2f%% of the image), applied in %.1f ms, %.1f MB/s of image\n",
+           (unsigned)patch_len, 100.0 * patch_len / IMAGE_SIZE, delta.seconds * 1e3,
+           IMAGE_SIZE / delta.seconds / 1e6);
+    printf("Peak RAM: %u bytes static (receive + copy buffer + session), heap +%u/+%u bytes, "
+           "stack %u/%u bytes (full/delta, host x86-64)\n",
+           (unsigned)(sizeof(recv_buf) + sizeof(copy_buf) + sizeof(session)),
+           (unsigned)full_heap, (unsigned)delta_heap, (unsigned)full_stack, (unsigned)delta_stack);
+
+    // Nothing is allocated per update, and the image is never held in RAM
+    CHECK_EQ(full_heap, 0);
+    CHECK_EQ(delta_heap, 0);
+}
+
+// ---- Patch from tools/make_delta.py ----
+
+static size_t read_file(const char *path, uint8_t *buf, size_t size)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        exit(2);
+    }
+    size_t len = fread(buf, 1, size, f);
+    CHECK(len < size);
+    fclose(f);
+    return len;
+}
+
+static int apply_patch_file(const char *running_path, const char *patch_path, const char *new_path)
+{
+    update_headers_t h;
+    httpd_req_t req;
+
+    size_t running_len = read_file(running_path, old_image, sizeof(old_image));
+    size_t new_len = read_file(new_path, new_image, sizeof(new_image));
+    patch_len = read_file(patch_path, patch, sizeof(patch));
+
+    install_running(old_image, running_len);
+    host_partition_wipe(ota_0);
+    sign(new_image, new_len, OTA_SECRET, &h);
+    CHECK_EQ(post(&req, "/update/delta", patch, patch_len, &h, TCP_SEGMENT), 200);
+    CHECK(partition_holds(ota_0, new_image, new_len));
+    printf("%s\n", req.host_reply);
+    return HOST_TEST_RESULT();
+}
+
+int main(int argc, char **argv)
+{
+    setup();
+    if (argc == 4) {
+        return apply_patch_file(argv[1], argv[2], argv[3]);
+    }
+
+    test_full_update();
+    test_signature();
+    test_not_an_image();
+    test_delta_update();
+    test_broken_patches();
+    bench();
+    return HOST_TEST_RESULT();
+}
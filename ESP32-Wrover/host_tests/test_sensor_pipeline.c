@@ -0,0 +1,386 @@
+// Lesson 30: the sensor pipeline with the lesson's drivers on emulated GPIO/ADC/DHT11, the
+// stages and the UART frame sink, the lock-free queue between two threads, and the
+// throughput/latency benchmark of RUN_BENCHMARK. Tasks are threads, so the scheduler and the
+// processing task run concurrently as on the ESP32; each run gets its own process.
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "host_idf.h"
+#include "host_test.h"
+#include "drivers.h"
+#include "pipeline.h"
+#include "sample_ring.h"
+#include "stages.h"
+
+#define BENCH_SAMPLES 1000000
+
+// Same channels as lesson_30 main.c
+enum {
+    CH_LIGHT,
+    CH_TEMPERATURE,
+    CH_HUMIDITY,
+    CH_BUTTON,
+    CH_SIM,
+    CH_COUNT
+};
+
+// Runs one test in a child process: the pipeline can only be started once per program
+static void run_isolated(const char *name, void (*fn)(void))
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        fn();
+        exit(HOST_TEST_RESULT());
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "%s failed\n", name);
+        host_test_failures++;
+    }
+}
+
+static sample_t make_sample(uint8_t channel, int32_t value)
+{
+    return (sample_t){ .channel = channel, .value = value };
+}
+
+// ---- Stages ----
+
+static void test_decimator_per_channel(void)
+{
+    decimator_t d = { .factor = { [CH_LIGHT] = 25 } };
+    sample_t batch[PIPELINE_BATCH_SIZE];
+    int light = 0, button = 0;
+
+    // 50 Hz ADC and 20 Hz button interleaved, as the scheduler produces them
+    for (int round = 0; round < 100; round++) {
+        size_t n = 0;
+        for (int i = 0; i < 5; i++) {
+            batch[n++] = make_sample(CH_LIGHT, round * 5 + i);
+        }
+        batch[n++] = make_sample(CH_BUTTON, round % 2);
+        batch[n++] = make_sample(CH_BUTTON, 1);
+        n = decimator_stage(&d, batch, n);
+        for (size_t i = 0; i < n; i++) {
+            if (batch[i].channel == CH_LIGHT) {
+                CHECK_EQ(batch[i].value % 25, 0);
+                light++;
+            } else {
+                button++;
+            }
+        }
+    }
+    CHECK_EQ(light, 500 / 25);
+    CHECK_EQ(button, 200);      // Not thinned with the ADC
+}
+
+static void test_change_filter(void)
+{
+    change_filter_t f = { .channel_mask = CHANNEL_BIT(CH_BUTTON) };
+    static const int32_t levels[] = { 0, 0, 0, 1, 1, 0, 0, 1, 1, 1, 0, 0 };
+    static const int32_t changes[] = { 0, 1, 0, 1, 0 };
+    sample_t batch[8];
+    int kept_button = 0, kept_sim = 0;
+
+    // Split over several batches: the last value is remembered between calls
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i += 4) {
+        size_t n = 0;
+        for (size_t k = i; k < i + 4; k++) {
+            batch[n++] = make_sample(CH_BUTTON, levels[k]);
+            batch[n++] = make_sample(CH_SIM, 7);    // Not in channel_mask
+        }
+        n = change_filter_stage(&f, batch, n);
+        for (size_t k = 0; k < n; k++) {
+            if (batch[k].channel == CH_SIM) {
+                kept_sim++;
+            } else if (kept_button < 5) {
+                CHECK_EQ(batch[k].value, changes[kept_button++]);
+            } else {
+                kept_button++;
+            }
+        }
+    }
+    CHECK_EQ(kept_button, 5);
+    CHECK_EQ(kept_sim, 12);
+
+    // Errors always pass and do not count as the last value
+    batch[0] = make_sample(CH_BUTTON, 0);
+    batch[0].flags = SAMPLE_FLAG_ERROR;
+    batch[1] = make_sample(CH_BUTTON, 0);
+    CHECK_EQ(change_filter_stage(&f, batch, 2), 1);
+    CHECK_EQ(batch[0].flags, SAMPLE_FLAG_ERROR);
+}
+
+static void test_ema_and_calibration(void)
+{
+    ema_filter_t ema = { .channel_mask = CHANNEL_BIT(CH_LIGHT), .shift = 3 };
+    calibration_t cal = { .mul = { [CH_LIGHT] = 3300 }, .div = { [CH_LIGHT] = 4095 } };
+    sample_t s = make_sample(CH_LIGHT, 4095);
+
+    ema_filter_stage(&ema, &s, 1);
+    CHECK_EQ(s.value, 4095);                    // Primed with the first reading
+    for (int i = 0; i < 200; i++) {
+        s = make_sample(CH_LIGHT, 0);
+        ema_filter_stage(&ema, &s, 1);
+    }
+    CHECK_EQ(s.value, 0);
+
+    s = make_sample(CH_LIGHT, 2048);
+    calibration_stage(&cal, &s, 1);
+    CHECK_EQ(s.value, 1650);
+    s = make_sample(CH_SIM, 2048);
+    calibration_stage(&cal, &s, 1);
+    CHECK_EQ(s.value, 2048);                    // div == 0: unchanged
+}
+
+static void test_uart_frame(void)
+{
+    uart_port_t port = UART_NUM_1;
+    sample_t batch[2] = {
+        { .timestamp_us = 1234567, .value = -2, .channel = 3, .flags = 0 },
+        { .timestamp_us = 2000000, .value = 0x01020304, .channel = 1, .flags = SAMPLE_FLAG_ERROR },
+    };
+    uint8_t frame[64];
+
+    uart_frame_sink(&port, batch, 2);
+    size_t len = host_uart_take_output(port, frame, sizeof(frame));
+    CHECK_EQ(len, 3 + 2 * 10 + 1);
+    CHECK_EQ(frame[0], 0xA5);
+    CHECK_EQ(frame[1], 0x5A);
+    CHECK_EQ(frame[2], 2);
+    CHECK_EQ(frame[3], 3);
+    CHECK_EQ(frame[5], 0xFE);                   // -2, little-endian
+    CHECK_EQ(frame[8], 0xFF);
+    CHECK_EQ(frame[9] | frame[10] << 8 | frame[11] << 16, 1234);   // Milliseconds
+    CHECK_EQ(frame[14], SAMPLE_FLAG_ERROR);
+    CHECK_EQ(frame[15], 0x04);
+    uint8_t checksum = 0;
+    for (size_t i = 2; i < len; i++) {
+        checksum ^= frame[i];
+    }
+    CHECK_EQ(checksum, 0);                      // XOR including the checksum itself
+}
+
+// ---- The queue between two threads ----
+
+#define RING_ITEMS 2000000
+
+static sample_ring_t test_ring;
+
+static void *ring_producer(void *arg)
+{
+    for (int32_t i = 0; i < RING_ITEMS; i++) {
+        sample_t s = make_sample(0, i);
+        while (!sample_ring_push(&test_ring, &s)) {
+            sched_yield();      // The CI machine may have a single core
+        }
+    }
+    return NULL;
+}
+
+static void test_ring_threads(void)
+{
+    static sample_t out[PIPELINE_BATCH_SIZE];
+    pthread_t producer;
+    int32_t expected = 0;
+    bool in_order = true;
+
+    uint64_t start = host_now_ns();
+    pthread_create(&producer, NULL, ring_producer, NULL);
+    while (expected < RING_ITEMS) {
+        size_t n = sample_ring_pop(&test_ring, out, PIPELINE_BATCH_SIZE);
+        if (n == 0) {
+            sched_yield();
+        }
+        for (size_t i = 0; i < n; i++) {
+            in_order &= out[i].value == expected++;
+        }
+    }
+    pthread_join(producer, NULL);
+    double seconds = (host_now_ns() - start) / 1e9;
+
+    CHECK(in_order);
+    CHECK_EQ(sample_ring_count(&test_ring), 0);
+    printf("Queue: %d samples between two threads in %.1f ms, %.1f M samples/s, none lost or reordered\n",
+           RING_ITEMS, seconds * 1e3, RING_ITEMS / seconds / 1e6);
+}
+
+// ---- The lesson's drivers and stages, running ----
+
+static struct {
+    pthread_mutex_t lock;
+    sample_t samples[2048];
+    size_t count;
+} recorded = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static void recording_sink(void *ctx, const sample_t *batch, size_t count)
+{
+    pthread_mutex_lock(&recorded.lock);
+    for (size_t i = 0; i < count && recorded.count < 2048; i++) {
+        recorded.samples[recorded.count++] = batch[i];
+    }
+    pthread_mutex_unlock(&recorded.lock);
+}
+
+static adc_sensor_t light = { .channel = ADC1_CHANNEL_6 };
+static dht_sensor_t dht = { .gpio = GPIO_NUM_4 };
+static button_sensor_t button = { .gpio = GPIO_NUM_0 };
+static sim_sensor_t sim = { .offset = 1000, .amplitude = 500, .period_ms = 5000, .noise = 40 };
+
+static const sensor_driver_t drivers[] = {
+    { .name = "adc",    .first_channel = CH_LIGHT,       .period_ms = 20,
+      .init = adc_sensor_init,    .read = adc_sensor_read,    .ctx = &light },
+    { .name = "dht11",  .first_channel = CH_TEMPERATURE, .period_ms = 2000,
+      .read = dht_sensor_read,    .ctx = &dht },
+    { .name = "button", .first_channel = CH_BUTTON,      .period_ms = 50,
+      .init = button_sensor_init, .read = button_sensor_read, .ctx = &button },
+    { .name = "sim",    .first_channel = CH_SIM,         .period_ms = 100,
+      .read = sim_sensor_read,    .ctx = &sim },
+};
+
+static ema_filter_t smoothing = { .channel_mask = CHANNEL_BIT(CH_LIGHT) | CHANNEL_BIT(CH_SIM), .shift = 3 };
+static decimator_t thinning = { .factor = { [CH_LIGHT] = 25 } };
+static change_filter_t button_edges = { .channel_mask = CHANNEL_BIT(CH_BUTTON) };
+static calibration_t to_units = { .mul = { [CH_LIGHT] = 3300 }, .div = { [CH_LIGHT] = 4095 } };
+
+static void press(int ms)
+{
+    host_gpio_set_input(GPIO_NUM_0, 1);
+    vTaskDelay(pdMS_TO_TICKS(ms));
+    host_gpio_set_input(GPIO_NUM_0, 0);
+    vTaskDelay(pdMS_TO_TICKS(250));
+}
+
+static void test_live_pipeline(void)
+{
+    host_adc_set_raw(ADC1_CHANNEL_6, 2048);
+    host_dht_set(23.5f, 41.0f, ESP_OK);
+    for (size_t i = 0; i < sizeof(drivers) / sizeof(drivers[0]); i++) {
+        CHECK_EQ(pipeline_register_driver(&drivers[i]), ESP_OK);
+    }
+    CHECK_EQ(pipeline_add_stage(ema_filter_stage, &smoothing), ESP_OK);
+    CHECK_EQ(pipeline_add_stage(decimator_stage, &thinning), ESP_OK);
+    CHECK_EQ(pipeline_add_stage(change_filter_stage, &button_edges), ESP_OK);
+    CHECK_EQ(pipeline_add_stage(calibration_stage, &to_units), ESP_OK);
+    CHECK_EQ(pipeline_add_sink(recording_sink, NULL), ESP_OK);
+    CHECK_EQ(pipeline_start(), ESP_OK);
+    CHECK_EQ(pipeline_add_stage(ema_filter_stage, &smoothing), ESP_ERR_INVALID_STATE);
+
+    // Three presses, the shortest only a little longer than the 50 ms button period
+    uint64_t start = host_now_ns();
+    vTaskDelay(pdMS_TO_TICKS(250));
+    press(300);
+    press(120);
+    press(70);
+    vTaskDelay(pdMS_TO_TICKS(PIPELINE_MAX_WAIT_MS * 2));    // Let the last partial batch through
+    double seconds = (host_now_ns() - start) / 1e9;
+
+    pthread_mutex_lock(&recorded.lock);
+    int per_channel[CH_COUNT] = { 0 };
+    int32_t button_values[16];
+    int button_events = 0;
+    for (size_t i = 0; i < recorded.count; i++) {
+        const sample_t *s = &recorded.samples[i];
+        per_channel[s->channel]++;
+        if (s->channel == CH_BUTTON && button_events < 16) {
+            button_values[button_events++] = s->value;
+        }
+        if (s->channel == CH_LIGHT) {
+            CHECK_EQ(s->value, 1650);           // 2048 of 4095 -> mV
+        }
+        if (s->channel == CH_TEMPERATURE) {
+            CHECK_EQ(s->value, 23500);
+        }
+    }
+    pthread_mutex_unlock(&recorded.lock);
+
+    // Released, then each press and release exactly once
+    CHECK_EQ(button_events, 7);
+    for (int i = 0; i < button_events; i++) {
+        CHECK_EQ(button_values[i], i % 2);
+    }
+    // 2 Hz after thinning, 10 Hz simulated sensor, DHT11 read once at the start
+    CHECK(per_channel[CH_LIGHT] >= (int)(seconds * 2) - 1 && per_channel[CH_LIGHT] <= (int)(seconds * 2) + 2);
+    CHECK(per_channel[CH_SIM] >= (int)(seconds * 10) - 2 && per_channel[CH_SIM] <= (int)(seconds * 10) + 2);
+    CHECK_EQ(per_channel[CH_TEMPERATURE], 1);
+    CHECK_EQ(per_channel[CH_HUMIDITY], 1);
+
+    pipeline_stats_t stats;
+    pipeline_get_stats(&stats);
+    CHECK_EQ(stats.dropped, 0);
+    CHECK_EQ(stats.delivered, recorded.count);
+    printf("Live: %.2f s, %lu produced, %lu delivered in %lu batches, latency avg %lu us / max %lu us, "
+           "queue peak %lu\n", seconds, (unsigned long)stats.produced, (unsigned long)stats.delivered,
+           (unsigned long)stats.batches, (unsigned long)stats.avg_latency_us,
+           (unsigned long)stats.max_latency_us, (unsigned long)stats.max_queue_depth);
+}
+
+// ---- Benchmark: RUN_BENCHMARK of main.c, with more samples ----
+
+static void bench(void)
+{
+    static uint32_t counted;
+    static sample_t block[PIPELINE_BATCH_SIZE];
+
+    CHECK_EQ(pipeline_add_stage(ema_filter_stage, &smoothing), ESP_OK);
+    CHECK_EQ(pipeline_add_stage(calibration_stage, &to_units), ESP_OK);
+    CHECK_EQ(pipeline_add_sink(counting_sink, &counted), ESP_OK);
+    CHECK_EQ(pipeline_start(), ESP_OK);
+
+    int64_t start = esp_timer_get_time();
+    uint32_t sent = 0;
+    while (sent < BENCH_SAMPLES) {
+        size_t n = 0;
+        int64_t now = esp_timer_get_time();
+        while (n < PIPELINE_BATCH_SIZE && sent + n < BENCH_SAMPLES) {
+            block[n].timestamp_us = now;
+            sim_sensor_read(&sim, n % 2 ? CH_SIM : CH_LIGHT, &block[n], 1);
+            n++;
+        }
+        size_t pushed = 0;
+        while (pushed < n) {
+            pushed += pipeline_inject(&block[pushed], n - pushed);
+            if (pushed < n) {
+                vTaskDelay(0);  // Queue full: let the processing task catch up
+            }
+        }
+        sent += n;
+    }
+    pipeline_stats_t stats;
+    do {
+        vTaskDelay(1);
+        pipeline_get_stats(&stats);
+    } while (stats.delivered < BENCH_SAMPLES);
+    int64_t elapsed_us = esp_timer_get_time() - start;
+
+    CHECK_EQ(stats.dropped, 0);
+    CHECK_EQ(counted, BENCH_SAMPLES);
+    printf("Benchmark: %d samples in %lld ms = %lld samples/s, batch size %d, %.1f samples per batch, "
+           "latency avg %lu us / max %lu us, queue peak %lu/%d\n",
+           BENCH_SAMPLES, (long long)elapsed_us / 1000, (long long)BENCH_SAMPLES * 1000000 / elapsed_us,
+           PIPELINE_BATCH_SIZE, (double)stats.delivered / stats.batches,
+           (unsigned long)stats.avg_latency_us, (unsigned long)stats.max_latency_us,
+           (unsigned long)stats.max_queue_depth, PIPELINE_RING_SIZE);
+}
+
+int main(void)
+{
+    test_decimator_per_channel();
+    test_change_filter();
+    test_ema_and_calibration();
+    test_uart_frame();
+    test_ring_threads();
+    run_isolated("test_live_pipeline", test_live_pipeline);
+    run_isolated("bench", bench);
+    return HOST_TEST_RESULT();
+}
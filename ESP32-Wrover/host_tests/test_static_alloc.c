@@ -0,0 +1,146 @@
+// Lesson 28: the memory pools and the allocation guard. malloc() and friends are replaced
+// for this program, so every allocation (also those inside libc) reaches the guard's hook.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "alloc_guard.h"
+#include "esp_heap_caps.h"
+#include "mem_pool.h"
+#include "messages.h"
+
+// ---- malloc() shim: glibc's allocator plus the ESP-IDF hook ----
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    void *ptr = __libc_malloc(size);
+    esp_heap_trace_alloc_hook(ptr, size, MALLOC_CAP_DEFAULT);
+    return ptr;
+}
+
+void *calloc(size_t n, size_t size)
+{
+    void *ptr = __libc_calloc(n, size);
+    esp_heap_trace_alloc_hook(ptr, n * size, MALLOC_CAP_DEFAULT);
+    return ptr;
+}
+
+void *realloc(void *old, size_t size)
+{
+    void *ptr = __libc_realloc(old, size);
+    esp_heap_trace_alloc_hook(ptr, size, MALLOC_CAP_DEFAULT);
+    return ptr;
+}
+
+MEM_POOL_DEFINE(event_pool, button_event_t, 8);
+
+static void test_pool(void)
+{
+    void *blocks[8];
+
+    mem_pool_init(&event_pool);
+    CHECK_EQ(mem_pool_free_count(&event_pool), 8);
+    for (int i = 0; i < 8; i++) {
+        blocks[i] = mem_pool_alloc(&event_pool);
+        CHECK(blocks[i] != NULL);
+        // Blocks come from the static storage and do not overlap
+        CHECK((uint8_t *)blocks[i] >= event_pool.storage);
+        CHECK((uint8_t *)blocks[i] + event_pool.block_size <=
+              event_pool.storage + event_pool.block_count * event_pool.block_size);
+        for (int j = 0; j < i; j++) {
+            CHECK(blocks[i] != blocks[j]);
+        }
+    }
+    CHECK(mem_pool_alloc(&event_pool) == NULL);
+    CHECK_EQ(mem_pool_min_free_count(&event_pool), 0);
+
+    mem_pool_free(&event_pool, blocks[3]);
+    mem_pool_free(&event_pool, NULL);
+    CHECK_EQ(mem_pool_free_count(&event_pool), 1);
+    CHECK(mem_pool_alloc(&event_pool) == blocks[3]);
+    for (int i = 0; i < 8; i++) {
+        mem_pool_free(&event_pool, blocks[i]);
+    }
+    CHECK_EQ(mem_pool_free_count(&event_pool), 8);
+    CHECK_EQ(mem_pool_min_free_count(&event_pool), 0);    // The low watermark stays
+}
+
+// The lesson's messages.c as the ISR, the sensor task and the UART task call it; the
+// FreeRTOS queue between them is left out
+static void hot_path(uint32_t iterations)
+{
+    static char line[128];
+    queue_item_t event, frame;
+    for (uint32_t i = 0; i < iterations; i++) {
+        CHECK(messages_new_button_event(&event, i, i & 1));
+        CHECK(messages_new_sensor_frame(&frame, i));
+        for (int s = 0; s < FRAME_SAMPLES; s++) {
+            ((sensor_frame_t *)frame.block)->samples[s] = 4095 - (int)(i * 7 + s) % 4096;
+        }
+
+        int len = messages_format(&event, line, sizeof(line));
+        CHECK(len > 0 && len < (int)sizeof(line));
+        if (i % 100 == 0) {
+            messages_drop(&frame);          // The queue was full
+        } else {
+            len = messages_format(&frame, line, sizeof(line));
+            CHECK(len > 0 && len < (int)sizeof(line));
+        }
+    }
+
+    // An empty pool drops the message instead of allocating
+    queue_item_t frames[4];
+    for (int i = 0; i < 4; i++) {
+        CHECK(messages_new_sensor_frame(&frames[i], i));
+    }
+    CHECK(!messages_new_sensor_frame(&frame, 4));
+    for (int i = 0; i < 4; i++) {
+        messages_format(&frames[i], line, sizeof(line));
+    }
+}
+
+static void test_guard(void)
+{
+    // Init may allocate
+    free(malloc(64));
+    CHECK(!alloc_guard_is_armed());
+    CHECK_EQ(alloc_guard_violations(), 0);
+
+    messages_init();
+    alloc_guard_arm();
+
+    hot_path(10000);
+    CHECK_EQ(alloc_guard_violations(), 0);
+    CHECK_EQ(messages_dropped(), 101);
+    CHECK_EQ(mem_pool_free_count(messages_event_pool()), 8);
+    CHECK_EQ(mem_pool_free_count(messages_frame_pool()), 4);
+
+    static char line[128];
+    queue_item_t item;
+    messages_new_button_event(&item, 42, true);
+    messages_format(&item, line, sizeof(line));
+    CHECK(strcmp(line, "[42] Button: LED is ON\n") == 0);
+
+    // A malloc/free pair leaves the heap unchanged but is still caught
+    free(malloc(24));
+    CHECK_EQ(alloc_guard_violations(), 1);
+    CHECK_EQ(alloc_guard_last_size(), 24);
+
+    char *copy = strdup("hidden allocation");
+    free(copy);
+    CHECK_EQ(alloc_guard_violations(), 2);
+}
+
+int main(void)
+{
+    printf("Allocation guard host test\n");     // stdout allocates its buffer here, before arming
+    test_pool();
+    test_guard();
+    return HOST_TEST_RESULT();
+}
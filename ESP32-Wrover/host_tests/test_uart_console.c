@@ -0,0 +1,441 @@
+// Lesson 33: the console's line editor, tokenizer and dispatch fed byte by byte, number
+// parsing, the gpio command's pin table (module pins, read-only pins, the spare output),
+// trace/heap/bench/tasks on the host, key sequences typed into a pseudo-terminal, and the
+// time to parse and dispatch one line. malloc() is replaced to count calls, so parsing and
+// dispatch can be checked to allocate nothing.
+
+#include <poll.h>
+#include <pty.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "esp_timer.h"
+
+#include "host_idf.h"
+#include "host_test.h"
+#include "commands.h"
+#include "console.h"
+#include "trace.h"
+
+#define BENCH_LINES 200000
+
+// ---- malloc() shim: glibc's allocator plus a call counter ----
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static size_t heap_calls;
+
+void *malloc(size_t size)
+{
+    heap_calls++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    heap_calls++;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *old, size_t size)
+{
+    heap_calls++;
+    return __libc_realloc(old, size);
+}
+
+static char out[8192];
+static size_t out_len;
+static int last_argc;
+static char last_args[CONSOLE_MAX_ARGS][CONSOLE_LINE_MAX];
+
+static void capture(void *ctx, const char *data, size_t len)
+{
+    if (out_len + len < sizeof(out)) {
+        memcpy(out + out_len, data, len);
+        out_len += len;
+        out[out_len] = '\0';
+    }
+}
+
+static const char *feed(const char *input)
+{
+    out_len = 0;
+    out[0] = '\0';
+    console_feed(input, strlen(input));
+    return out;
+}
+
+static int args_cmd(int argc, char **argv)
+{
+    last_argc = argc;
+    for (int i = 0; i < argc; i++) {
+        snprintf(last_args[i], sizeof(last_args[i]), "%s", argv[i]);
+    }
+    return argc > 1 && strcmp(argv[1], "bad") == 0 ? CONSOLE_ERR_USAGE
+         : argc > 1 && strcmp(argv[1], "fail") == 0 ? CONSOLE_ERR_FAIL : CONSOLE_OK;
+}
+
+static const console_cmd_t args_command = {
+    .name = "args",
+    .usage = "<words>",
+    .help = "Record the arguments",
+    .fn = args_cmd,
+};
+
+// Same table as lesson_33 main.c
+static const commands_gpio_t gpio_pins[] = {
+    { GPIO_NUM_0,  "button",          false },
+    { GPIO_NUM_2,  "LED (pwm)",       false },
+    { GPIO_NUM_4,  "console UART TX", false },
+    { GPIO_NUM_5,  "console UART RX", false },
+    { GPIO_NUM_13, "spare",           true },
+};
+
+static void setup_with(console_write_fn write, void *ctx)
+{
+    console_init(write, ctx);
+    commands_register_system();
+    commands_set_gpio_table(gpio_pins, sizeof(gpio_pins) / sizeof(gpio_pins[0]));
+    console_register(&args_command);
+}
+
+static void setup(void)
+{
+    setup_with(capture, NULL);
+}
+
+// ---- Line editor ----
+
+static void test_line_editing(void)
+{
+    CHECK(strcmp(feed("args a b\r"), "args a b\r\n" CONSOLE_PROMPT) == 0);
+    CHECK_EQ(last_argc, 3);
+
+    // A line can arrive in pieces; nothing runs before the end of line
+    last_argc = 0;
+    feed("ar");
+    feed("gs x");
+    CHECK_EQ(last_argc, 0);
+    feed("\n");
+    CHECK_EQ(last_argc, 2);
+    CHECK(strcmp(last_args[1], "x") == 0);
+
+    // CRLF runs the line once, a lone LF after a CR-terminated line too
+    int runs = 0;
+    last_argc = 0;
+    feed("args\r\n");
+    runs += last_argc;
+    last_argc = 0;
+    feed("\n");
+    runs += last_argc;
+    CHECK_EQ(runs, 1);
+    feed("\nargs\n");
+    CHECK_EQ(last_argc, 1);
+
+    // Backspace and DEL erase, and on an empty line do nothing
+    CHECK(strstr(feed("args abx\b\x7f" "c\r"), "\b \b\b \b") != NULL);
+    CHECK(strcmp(last_args[1], "ac") == 0);
+    CHECK(strcmp(feed("\b\x7f"), "") == 0);
+
+    // Ctrl-C drops the line, Ctrl-U erases it on screen
+    last_argc = 0;
+    CHECK(strcmp(feed("args zz\x03"), "args zz^C\r\n" CONSOLE_PROMPT) == 0);
+    CHECK(strcmp(feed("\r"), "\r\n" CONSOLE_PROMPT) == 0);
+    CHECK_EQ(last_argc, 0);
+    feed("junk\x15" "args u\r");
+    CHECK_EQ(last_argc, 2);
+    CHECK(strcmp(last_args[1], "u") == 0);
+
+    // Arrow keys (ESC [ A) and ESC + one byte are skipped; control bytes are ignored
+    feed("args \x1b[A\x1b[1;5Cq\x1bOw\x01\r");
+    CHECK_EQ(last_argc, 2);
+    CHECK(strcmp(last_args[1], "qw") == 0);
+}
+
+static void test_overlong_line(void)
+{
+    char input[CONSOLE_LINE_MAX + 16];
+    memset(input, 'y', sizeof(input) - 1);
+    memcpy(input, "args ", 5);
+    input[sizeof(input) - 1] = '\0';
+
+    const char *echo = feed(input);
+    // The line keeps CONSOLE_LINE_MAX - 1 characters, the rest ring the bell
+    CHECK_EQ(strchr(echo, '\a') - echo, CONSOLE_LINE_MAX - 1);
+    feed("\r");
+    CHECK_EQ(last_argc, 2);
+    CHECK_EQ(strlen(last_args[1]), CONSOLE_LINE_MAX - 1 - 5);
+}
+
+// ---- Tokenizer and dispatch ----
+
+static void test_execute(void)
+{
+    char line[CONSOLE_LINE_MAX];
+
+    strcpy(line, "  args\t\"two words\"  \"\" end  ");
+    CHECK_EQ(console_execute(line), CONSOLE_OK);
+    CHECK_EQ(last_argc, 4);
+    CHECK(strcmp(last_args[1], "two words") == 0);
+    CHECK(strcmp(last_args[2], "") == 0);
+    CHECK(strcmp(last_args[3], "end") == 0);
+
+    // An unterminated quote runs to the end of the line
+    strcpy(line, "args \"open quote");
+    console_execute(line);
+    CHECK_EQ(last_argc, 2);
+    CHECK(strcmp(last_args[1], "open quote") == 0);
+
+    strcpy(line, "   ");
+    CHECK_EQ(console_execute(line), CONSOLE_OK);
+
+    last_argc = 0;
+    CHECK(strstr(feed("args 1 2 3 4 5 6 7 8\r"), "Too many arguments (max 8)\r\n") != NULL);
+    CHECK_EQ(last_argc, 0);
+    feed("args 1 2 3 4 5 6 7\r");
+    CHECK_EQ(last_argc, CONSOLE_MAX_ARGS);
+
+    CHECK(strstr(feed("nope\r"), "Unknown command 'nope', try 'help'\r\n") != NULL);
+    CHECK(strstr(feed("args bad\r"), "Usage: args <words>\r\n") != NULL);
+    CHECK(strstr(feed("args fail\r"), "args failed (-2)\r\n") != NULL);
+
+    const char *help = feed("help\r");
+    CHECK(strstr(help, "  help ") != NULL);
+    CHECK(strstr(help, "  gpio [<pin> [0|1]]") != NULL);
+    CHECK(strstr(help, "Record the arguments\r\n") != NULL);
+
+    // Output "\n" becomes "\r\n"; the table is full at CONSOLE_MAX_COMMANDS
+    feed("");
+    console_printf("a\nb\n");
+    CHECK(strcmp(out, "a\r\nb\r\n") == 0);
+    int registered = 0;
+    while (console_register(&args_command) == ESP_OK) {
+        registered++;
+    }
+    CHECK_EQ(registered, CONSOLE_MAX_COMMANDS - 7);
+    setup();
+}
+
+static void test_parse_int(void)
+{
+    long value = 42;
+    CHECK(console_parse_int("0", 0, 10, &value) && value == 0);
+    CHECK(console_parse_int("0x1F", 0, 100, &value) && value == 31);
+    CHECK(console_parse_int("-5", -10, 10, &value) && value == -5);
+    CHECK(console_parse_int("010", 0, 100, &value) && value == 8);    // strtol base 0: octal
+    CHECK(console_parse_int("39", 0, 39, &value) && value == 39);
+    value = 42;
+    CHECK(!console_parse_int("40", 0, 39, &value));
+    CHECK(!console_parse_int("-1", 0, 39, &value));
+    CHECK(!console_parse_int("", 0, 39, &value));
+    CHECK(!console_parse_int("12a", 0, 39, &value));
+    CHECK(!console_parse_int("0x", 0, 39, &value));
+    CHECK(!console_parse_int(" 1 ", 0, 39, &value));
+    CHECK(!console_parse_int("99999999999999999999", 0, 39, &value));
+    CHECK_EQ(value, 42);
+}
+
+// ---- gpio ----
+
+static void test_gpio(void)
+{
+    const char *list = feed("gpio\r");
+    CHECK(strstr(list, "GPIO0  r    button\r\n") != NULL);
+    CHECK(strstr(list, "GPIO4  r    console UART TX\r\n") != NULL);
+    CHECK(strstr(list, "GPIO13 r/w  spare\r\n") != NULL);
+
+    host_gpio_set_input(GPIO_NUM_0, 1);
+    CHECK(strstr(feed("gpio 0\r"), "GPIO0 (button) = 1\r\n") != NULL);
+    host_gpio_set_input(GPIO_NUM_0, 0);
+    CHECK(strstr(feed("gpio 0\r"), "GPIO0 (button) = 0\r\n") != NULL);
+
+    // The module's own pins: touching them crashes or corrupts flash and PSRAM
+    for (long pin = 6; pin <= 11; pin++) {
+        char line[16];
+        snprintf(line, sizeof(line), "gpio %ld 1\r", pin);
+        CHECK(strstr(feed(line), "is used by the SPI flash\r\n") != NULL);
+    }
+    CHECK(strstr(feed("gpio 16\r"), "GPIO16 is used by the PSRAM\r\n") != NULL);
+    CHECK(strstr(feed("gpio 17 0\r"), "GPIO17 is used by the PSRAM\r\n") != NULL);
+    CHECK(strstr(feed("gpio 17 0\r"), "gpio failed (-2)") != NULL);
+    CHECK(strstr(feed("gpio 12 1\r"), "GPIO12 is not one of this project's pins, see 'gpio'\r\n") != NULL);
+    CHECK(strstr(feed("gpio 36\r"), "not one of this project's pins") != NULL);
+
+    // In the table but read only: the console's UART pins, and the LED that LEDC drives
+    CHECK(strstr(feed("gpio 4 0\r"), "GPIO4 (console UART TX) is read only\r\n") != NULL);
+    CHECK(strstr(feed("gpio 5 1\r"), "GPIO5 (console UART RX) is read only\r\n") != NULL);
+    CHECK(strstr(feed("gpio 2 1\r"), "GPIO2 (LED (pwm)) is read only\r\n") != NULL);
+    CHECK(strstr(feed("gpio 0 1\r"), "is read only") != NULL);
+
+    CHECK(strstr(feed("gpio 13 1\r"), "GPIO13 (spare) = 1\r\n") != NULL);
+    CHECK_EQ(host_gpio_get_output(GPIO_NUM_13), 1);
+    CHECK(strstr(feed("gpio 0x0d 0\r"), "GPIO13 (spare) = 0\r\n") != NULL);
+    CHECK_EQ(host_gpio_get_output(GPIO_NUM_13), 0);
+
+    // Bad numbers and non-existent pins are usage errors
+    CHECK(strstr(feed("gpio 13 2\r"), "Usage: gpio [<pin> [0|1]]") != NULL);
+    CHECK(strstr(feed("gpio 40\r"), "Usage: gpio") != NULL);
+    CHECK(strstr(feed("gpio 24\r"), "Usage: gpio") != NULL);
+    CHECK(strstr(feed("gpio x\r"), "Usage: gpio") != NULL);
+    CHECK(strstr(feed("gpio 13 1 1\r"), "Usage: gpio") != NULL);
+
+    // Until the application sets a table, every pin is refused
+    commands_set_gpio_table(NULL, 0);
+    CHECK(strcmp(feed("gpio\r"), "gpio\r\n" CONSOLE_PROMPT) == 0);
+    CHECK(strstr(feed("gpio 13 1\r"), "not one of this project's pins") != NULL);
+    commands_set_gpio_table(gpio_pins, sizeof(gpio_pins) / sizeof(gpio_pins[0]));
+}
+
+// ---- trace, heap, bench, tasks ----
+
+static void test_system_commands(void)
+{
+    host_clock_set_fake(1000000);
+    CHECK(strstr(feed("trace start\r"), "Tracing, up to 128 events\r\n") != NULL);
+    trace_record("first", 1);
+    host_clock_advance_us(250);
+    trace_record("second", -2);
+    const char *trace = feed("trace stop\r");
+    CHECK(strstr(trace, "   1000000 us         +0  first          1\r\n") != NULL);
+    CHECK(strstr(trace, "   1000250 us       +250  second         -2\r\n") != NULL);
+    CHECK(strstr(trace, "2 events, 0 overwritten\r\n") != NULL);
+    CHECK(strstr(feed("trace\r"), "Usage: trace start|stop") != NULL);
+    CHECK(strstr(feed("trace go\r"), "Usage: trace start|stop") != NULL);
+
+    CHECK(strstr(feed("heap\r"), "Free: ") != NULL);
+    CHECK(strstr(out, "DMA-capable free ") != NULL);
+
+    const char *cases = feed("bench\r");
+    CHECK(strstr(cases, "Cases: memcpy int float malloc gpio\r\n") != NULL);
+    CHECK(strstr(cases, "Usage: bench <case>") != NULL);
+    CHECK(strstr(feed("bench sort\r"), "Unknown case 'sort'") != NULL);
+
+    // A 10 ms window on the fake clock
+    const char *tasks = feed("tasks 10\r");
+    CHECK(strstr(tasks, "Task             State  Prio    CPU% Stack free\r\n") != NULL);
+    CHECK(strstr(tasks, "main             run       1") != NULL);
+    CHECK(strstr(feed("tasks 5\r"), "Usage: tasks [window_ms]") != NULL);
+
+    host_clock_set_real();
+    CHECK(strstr(feed("bench int\r"), "int: 100000 iterations in ") != NULL);
+    CHECK(strstr(feed("bench memcpy\r"), " KB/s\r\n") != NULL);
+}
+
+// ---- On a terminal ----
+
+static void pty_write(void *ctx, const char *data, size_t len)
+{
+    CHECK_EQ(write(*(int *)ctx, data, len), (ssize_t)len);
+}
+
+// The read-and-feed loop of lesson_33 main.c's console_task, reading the pty slave
+// instead of UART1 until nothing has arrived for 20 ms
+static void pump(int fd)
+{
+    char data[64];
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    while (poll(&pfd, 1, 20) > 0) {
+        ssize_t len = read(fd, data, sizeof(data));
+        if (len <= 0) {
+            break;
+        }
+        console_feed(data, len);
+    }
+}
+
+// What the terminal shows: everything the console wrote to the slave
+static const char *screen(int master)
+{
+    struct pollfd pfd = { .fd = master, .events = POLLIN };
+    out_len = 0;
+    while (out_len < sizeof(out) - 1 && poll(&pfd, 1, 20) > 0) {
+        ssize_t len = read(master, out + out_len, sizeof(out) - 1 - out_len);
+        if (len <= 0) {
+            break;
+        }
+        out_len += len;
+    }
+    out[out_len] = '\0';
+    return out;
+}
+
+static void test_pty(void)
+{
+    int master, slave;
+    if (openpty(&master, &slave, NULL, NULL, NULL) != 0) {
+        CHECK(!"openpty() failed");
+        return;
+    }
+    // A UART passes every byte through; without raw mode the tty would handle
+    // backspace, Ctrl-C and Ctrl-U itself and hold input back until Enter
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    setup_with(pty_write, &slave);
+
+    // Keys as a terminal sends them: a typo, arrow and Delete keys, Ctrl-U, Ctrl-C, commands
+    static const char keys[] =
+        "args onx\x7f" "e two\r"
+        "args \x1b[A\x1b[D\x1b[3~k\r\n"
+        "junk\x15" "gpio 13 1\r"
+        "args dropped\x03"
+        "help\r"
+        "heap\r";
+    CHECK_EQ(write(master, keys, sizeof(keys) - 1), (ssize_t)sizeof(keys) - 1);
+
+    heap_calls = 0;
+    pump(slave);
+    size_t calls = heap_calls;
+    CHECK_EQ(calls, 0);
+
+    const char *shown = screen(master);
+    CHECK(strstr(shown, "args onx\b \be two\r\n") != NULL);
+    CHECK(strstr(shown, "GPIO13 (spare) = 1\r\n") != NULL);
+    CHECK(strstr(shown, "args dropped^C\r\n" CONSOLE_PROMPT "help\r\n") != NULL);
+    CHECK(strstr(shown, "Record the arguments\r\n") != NULL);
+    CHECK(strstr(shown, "Free: ") != NULL);
+    CHECK_EQ(host_gpio_get_output(GPIO_NUM_13), 1);
+    CHECK_EQ(last_argc, 2);
+    CHECK(strcmp(last_args[1], "k") == 0);
+
+    close(slave);
+    close(master);
+    setup();
+}
+
+// ---- Parse and dispatch cost ----
+
+static void bench(void)
+{
+    static const char line[] = "args \"quoted word\" 0x1F -5 abc\r";
+    heap_calls = 0;
+    uint64_t start = host_now_ns();
+    for (int i = 0; i < BENCH_LINES; i++) {
+        out_len = 0;
+        console_feed(line, sizeof(line) - 1);
+    }
+    uint64_t elapsed = host_now_ns() - start;
+    size_t calls = heap_calls;
+    CHECK_EQ(calls, 0);
+    CHECK_EQ(last_argc, 5);
+    printf("Echo, tokenize and dispatch: %.0f ns per %zu-byte line\n",
+           (double)elapsed / BENCH_LINES, sizeof(line) - 1);
+}
+
+int main(void)
+{
+    setup();
+    test_line_editing();
+    test_overlong_line();
+    test_execute();
+    test_parse_int();
+    test_gpio();
+    test_system_commands();
+    test_pty();
+    bench();
+    return HOST_TEST_RESULT();
+}
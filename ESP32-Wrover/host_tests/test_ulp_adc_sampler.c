@@ -0,0 +1,232 @@
+// Lesson 27: the ULP program's logic, through the C model in ulp_adc_sampler_model.c,
+// plus one simulated hour of ULP sampling against the Lesson 5 loop.
+
+#include <string.h>
+
+#include "host_test.h"
+#include "ulp_adc_sampler_model.h"
+
+#define ULP_PERIOD_MS       100     // Same as lesson_27 main.c
+#define LOOP_PERIOD_MS      500
+#define DELTA_THRESHOLD     200
+#define BOOT_MS             30      // Deep sleep wakeup until process_samples() runs
+#define RTC_TICKS_PER_MS    150     // 150 kHz RTC slow clock
+#define HOUR_MS             3600000
+
+static ulp_model_t ulp;
+
+// What init_ulp_program() and process_samples() in main.c do to the shared memory
+static void cpu_init(void)
+{
+    memset(&ulp, 0, sizeof(ulp));
+    ulp.delta_threshold = DELTA_THRESHOLD;
+    ulp.rdy_for_wakeup = true;
+    ulp.timer_enabled = true;
+}
+
+static void cpu_process(void)
+{
+    ulp.reference = ulp.last_result;
+    ulp.sample_count = 0;
+    ulp.wake_pending = 0;
+    ulp.timer_enabled = true;
+}
+
+static void run_at(uint32_t t_ms, uint16_t level)
+{
+    const uint16_t adc[ULP_OVERSAMPLING] = { [0 ... ULP_OVERSAMPLING - 1] = level };
+    ulp.rtc_time = t_ms * RTC_TICKS_PER_MS;
+    ulp_model_run(&ulp, adc);
+}
+
+static uint32_t wake_time(void)
+{
+    return (uint32_t)ulp.wake_time_hi << 16 | ulp.wake_time_lo;
+}
+
+// A steady signal wakes the CPU once per full buffer, with every sample kept
+static void test_full_buffer(void)
+{
+    cpu_init();
+    ulp.reference = 1000;
+    for (int i = 0; i < ULP_BUFFER_SIZE - 1; i++) {
+        run_at(i, 1000 + i % 3);
+        CHECK(!ulp.woke);
+    }
+    run_at(ULP_BUFFER_SIZE - 1, 1000);
+    CHECK(ulp.woke);
+    CHECK(!ulp.timer_enabled);
+    CHECK_EQ(ulp.sample_count, ULP_BUFFER_SIZE);
+    CHECK_EQ(ulp.samples[1], 1001);
+    CHECK_EQ(ulp.sample_total, ULP_BUFFER_SIZE);
+}
+
+// Oversampling: the average of the conversions, truncated
+static void test_average(void)
+{
+    const uint16_t adc[ULP_OVERSAMPLING] = { 100, 101, 102, 104 };
+    cpu_init();
+    ulp_model_run(&ulp, adc);
+    CHECK_EQ(ulp.last_result, (100 + 101 + 102 + 104) / 4);
+}
+
+// A change of more than the threshold, up or down, wakes at once; exactly the threshold does not
+static void test_delta(void)
+{
+    cpu_init();
+    ulp.reference = 1000;
+    run_at(0, 1000 + DELTA_THRESHOLD);
+    CHECK(!ulp.woke);
+    run_at(1, 1000 - DELTA_THRESHOLD);
+    CHECK(!ulp.woke);
+    run_at(2, 1000 + DELTA_THRESHOLD + 1);
+    CHECK(ulp.woke);
+    CHECK_EQ(wake_time(), 2 * RTC_TICKS_PER_MS);
+
+    cpu_init();
+    ulp.reference = 1000;
+    run_at(0, 1000 - DELTA_THRESHOLD - 1);
+    CHECK(ulp.woke);
+
+    // Near zero: the unsigned subtraction must not wrap into a huge difference
+    cpu_init();
+    ulp.reference = 5;
+    run_at(0, 0);
+    CHECK(!ulp.woke);
+}
+
+// Full buffer while the CPU cannot be woken: retried every run, samples kept, first time recorded
+static void test_retry_when_not_ready(void)
+{
+    cpu_init();
+    ulp.reference = 1000;
+    ulp.rdy_for_wakeup = false;
+    for (int i = 0; i < ULP_BUFFER_SIZE; i++) {
+        run_at(i, 1000);
+    }
+    CHECK(!ulp.woke);
+    CHECK_EQ(ulp.wake_pending, 1);
+    CHECK_EQ(wake_time(), (ULP_BUFFER_SIZE - 1) * RTC_TICKS_PER_MS);
+
+    for (int i = 0; i < 5; i++) {
+        run_at(ULP_BUFFER_SIZE + i, 1000);
+        CHECK(!ulp.woke);
+        CHECK(ulp.timer_enabled);
+    }
+    CHECK_EQ(ulp.sample_count, ULP_BUFFER_SIZE);
+    CHECK_EQ(ulp.sample_total, ULP_BUFFER_SIZE + 5);
+
+    ulp.rdy_for_wakeup = true;
+    run_at(ULP_BUFFER_SIZE + 5, 1000);
+    CHECK(ulp.woke);
+    CHECK(!ulp.timer_enabled);
+    // The latency seen by the CPU includes the retries
+    CHECK_EQ(wake_time(), (ULP_BUFFER_SIZE - 1) * RTC_TICKS_PER_MS);
+}
+
+// A spike that went away before the CPU was ready does not leave a stale request time
+static void test_request_cleared(void)
+{
+    cpu_init();
+    ulp.reference = 1000;
+    ulp.rdy_for_wakeup = false;
+    run_at(10, 1500);
+    CHECK_EQ(ulp.wake_pending, 1);
+    run_at(11, 1000);
+    CHECK_EQ(ulp.wake_pending, 0);
+
+    ulp.rdy_for_wakeup = true;
+    run_at(12, 1500);
+    CHECK(ulp.woke);
+    CHECK_EQ(wake_time(), 12 * RTC_TICKS_PER_MS);
+}
+
+// ---- One hour: a signal that steps by 400 counts every ~5 minutes ----
+
+#define STEP_MS 317257     // Not a multiple of either period, so the step phase varies
+
+static uint16_t signal_at(uint32_t t)
+{
+    return (t / STEP_MS) % 2 ? 1400 : 1000;
+}
+
+typedef struct {
+    uint32_t wakeups;
+    uint32_t steps;
+    uint64_t latency_sum;
+    uint32_t latency_max;
+} sim_result_t;
+
+static void seen(sim_result_t *r, uint32_t now, uint32_t *last_seen_step)
+{
+    uint32_t step = now / STEP_MS;
+    if (step != *last_seen_step) {
+        uint32_t latency = now - step * STEP_MS;
+        r->steps++;
+        r->latency_sum += latency;
+        if (latency > r->latency_max) {
+            r->latency_max = latency;
+        }
+        *last_seen_step = step;
+    }
+}
+
+static void simulate_ulp(sim_result_t *r)
+{
+    uint32_t last_seen_step = 0;
+    memset(r, 0, sizeof(*r));
+    cpu_init();
+    ulp.reference = signal_at(0);
+
+    for (uint32_t t = ULP_PERIOD_MS; t < HOUR_MS; t += ULP_PERIOD_MS) {
+        run_at(t, signal_at(t));
+        if (ulp.woke) {
+            r->wakeups++;
+            t += BOOT_MS;
+            seen(r, t, &last_seen_step);
+            cpu_process();
+        }
+    }
+}
+
+// Lesson 5: the CPU reads every LOOP_PERIOD_MS, and each read is a task wakeup
+static void simulate_loop(sim_result_t *r)
+{
+    uint32_t last_seen_step = 0;
+    memset(r, 0, sizeof(*r));
+    for (uint32_t t = 0; t < HOUR_MS; t += LOOP_PERIOD_MS) {
+        r->wakeups++;
+        seen(r, t, &last_seen_step);
+    }
+}
+
+static void compare(void)
+{
+    sim_result_t u, l;
+    simulate_ulp(&u);
+    simulate_loop(&l);
+
+    printf("Per hour             CPU wakeups   step latency avg / max\n");
+    printf("Lesson 5 loop        %11lu   %6.0f / %lu ms\n", (unsigned long)l.wakeups,
+           (double)l.latency_sum / l.steps, (unsigned long)l.latency_max);
+    printf("ULP, %3d ms period   %11lu   %6.0f / %lu ms\n", ULP_PERIOD_MS, (unsigned long)u.wakeups,
+           (double)u.latency_sum / u.steps, (unsigned long)u.latency_max);
+
+    CHECK_EQ(u.steps, HOUR_MS / STEP_MS);
+    CHECK_EQ(l.steps, HOUR_MS / STEP_MS);
+    // About one wakeup per full buffer, plus one per step
+    CHECK(u.wakeups <= HOUR_MS / ULP_PERIOD_MS / ULP_BUFFER_SIZE + u.steps + 2);
+    CHECK(u.latency_max <= ULP_PERIOD_MS + BOOT_MS);
+    CHECK(l.latency_max < LOOP_PERIOD_MS);
+}
+
+int main(void)
+{
+    test_full_buffer();
+    test_average();
+    test_delta();
+    test_retry_when_not_ready();
+    test_request_cleared();
+    compare();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,69 @@
+#include "ulp_adc_sampler_model.h"
+
+// ULP `sub` is 16 bits wide and sets the overflow flag when it borrows
+static uint16_t sub16(uint16_t a, uint16_t b, bool *ov)
+{
+    *ov = a < b;
+    return (uint16_t)(a - b);
+}
+
+static void wake_up(ulp_model_t *ulp)
+{
+    // wake_up: remember when the wakeup was first requested
+    if (ulp->wake_pending < 1) {
+        ulp->wake_pending = 1;
+        ulp->wake_time_lo = ulp->rtc_time & UINT16_MAX;
+        ulp->wake_time_hi = ulp->rtc_time >> 16;
+    }
+
+    // ready_check: not ready means halt and try again next run
+    if (!ulp->rdy_for_wakeup) {
+        return;
+    }
+    ulp->woke = true;
+    ulp->timer_enabled = false;
+}
+
+void ulp_model_run(ulp_model_t *ulp, const uint16_t adc[ULP_OVERSAMPLING])
+{
+    bool ov;
+    ulp->woke = false;
+
+    // entry
+    ulp->sample_total++;
+
+    // measure: add the conversions, then shift
+    uint16_t sum = 0;
+    for (int stage = 0; stage < ULP_OVERSAMPLING; stage++) {
+        sum += adc[stage];
+    }
+    ulp->last_result = sum >> ULP_OVERSAMPLING_LOG;
+
+    // Buffer still full from an earlier run: retry the wakeup
+    if (ulp->sample_count >= ULP_BUFFER_SIZE) {
+        wake_up(ulp);
+        return;
+    }
+    ulp->samples[ulp->sample_count] = ulp->last_result;
+    ulp->sample_count++;
+    if (ulp->sample_count >= ULP_BUFFER_SIZE) {
+        wake_up(ulp);
+        return;
+    }
+
+    // check_delta / below_reference
+    uint16_t diff = sub16(ulp->last_result, ulp->reference, &ov);
+    if (ov) {
+        diff = sub16(ulp->reference, ulp->last_result, &ov);
+    }
+
+    // compare_delta
+    sub16(ulp->delta_threshold, diff, &ov);
+    if (ov) {
+        wake_up(ulp);
+        return;
+    }
+
+    // No wakeup needed: forget an earlier request
+    ulp->wake_pending = 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// C model of lesson_27 main/ulp/adc_sampler.S, one function per ULP run.
+// Keep the two in step: every block below names the label it mirrors.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ulp_config.h"
+
+typedef struct {
+    // RTC slow memory shared with the main CPU (the ULP only uses the low 16 bits)
+    uint16_t reference;
+    uint16_t delta_threshold;
+    uint16_t last_result;
+    uint16_t sample_total;
+    uint16_t sample_count;
+    uint16_t wake_pending;
+    uint16_t wake_time_lo;
+    uint16_t wake_time_hi;
+    uint16_t samples[ULP_BUFFER_SIZE];
+
+    // Hardware seen by the program
+    bool rdy_for_wakeup;        // RTC_CNTL_RDY_FOR_WAKEUP
+    bool timer_enabled;         // RTC_CNTL_ULP_CP_SLP_TIMER_EN
+    bool woke;                  // The program executed `wake` in this run
+    uint32_t rtc_time;          // Low 32 bits of the RTC timer
+} ulp_model_t;
+
+// One run of the program; adc[] are the ULP_OVERSAMPLING conversions it reads
+void ulp_model_run(ulp_model_t *ulp, const uint16_t adc[ULP_OVERSAMPLING]);
@@ -0,0 +1,202 @@
+#include <stdbool.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+
+#include "duty_cycle.h"
+
+#define RTC_STATE_MAGIC 0x44555459  // "DUTY"
+#define US_PER_MS 1000LL
+#define MS_PER_HOUR 3600000LL
+
+static const char *TAG = "duty_cycle";
+
+typedef struct {
+    const char *name;
+    uint32_t period_ms;
+    duty_job_cost_t cost;
+    duty_job_fn_t fn;
+    void *arg;
+} duty_job_t;
+
+// Everything that has to survive deep sleep lives here
+typedef struct {
+    uint32_t magic;
+    uint32_t job_count;
+    int64_t next_due_us[DUTY_CYCLE_MAX_JOBS];
+    int64_t start_us;        // Time of the first cold boot
+    int64_t awake_us;        // Total time spent awake since start_us
+    uint32_t wakeups;
+} duty_rtc_state_t;
+
+static duty_job_t jobs[DUTY_CYCLE_MAX_JOBS];
+static size_t job_count = 0;
+static RTC_DATA_ATTR duty_rtc_state_t rtc_state;
+
+// Wall-clock time in microseconds; the RTC keeps it running through deep sleep
+static int64_t now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+esp_err_t duty_cycle_register(const char *name, uint32_t period_ms, duty_job_cost_t cost,
+                              duty_job_fn_t fn, void *arg)
+{
+    if (job_count >= DUTY_CYCLE_MAX_JOBS || period_ms == 0 || fn == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    jobs[job_count++] = (duty_job_t) {
+        .name = name,
+        .period_ms = period_ms,
+        .cost = cost,
+        .fn = fn,
+        .arg = arg,
+    };
+    return ESP_OK;
+}
+
+// Reuse the RTC schedule after a timer wakeup, otherwise start fresh with every job due now
+static void restore_state(void)
+{
+    bool resumed = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER &&
+                   rtc_state.magic == RTC_STATE_MAGIC &&
+                   rtc_state.job_count == job_count;
+    if (resumed) {
+        return;
+    }
+
+    int64_t now = now_us();
+    rtc_state.magic = RTC_STATE_MAGIC;
+    rtc_state.job_count = job_count;
+    rtc_state.start_us = now;
+    rtc_state.awake_us = 0;
+    rtc_state.wakeups = 0;
+    for (size_t i = 0; i < job_count; i++) {
+        rtc_state.next_due_us[i] = now;
+    }
+    ESP_LOGI(TAG, "Cold start with %u jobs", (unsigned)job_count);
+}
+
+// Run every job that is due (or nearly due) and return the earliest next due time
+static int64_t run_due_jobs(void)
+{
+    int64_t now = now_us();
+    int64_t window = now + DUTY_CYCLE_SLACK_MS * US_PER_MS;
+    int64_t earliest = INT64_MAX;
+
+    for (size_t i = 0; i < job_count; i++) {
+        if (rtc_state.next_due_us[i] <= window) {
+            jobs[i].fn(jobs[i].arg);
+
+            // Read the clock again: the job itself may have taken longer than its period
+            int64_t done = now_us();
+            int64_t period_us = jobs[i].period_ms * US_PER_MS;
+            rtc_state.next_due_us[i] += period_us;
+            // A long job or a clock jump made us miss slots: skip them instead of bursting
+            if (rtc_state.next_due_us[i] < done) {
+                rtc_state.next_due_us[i] = done + period_us;
+            }
+        }
+        if (rtc_state.next_due_us[i] < earliest) {
+            earliest = rtc_state.next_due_us[i];
+        }
+    }
+    return earliest;
+}
+
+void duty_cycle_start(duty_sleep_mode_t mode)
+{
+    restore_state();
+
+    // After a reset esp_timer starts at 0, so the first interval also counts the boot time
+    int64_t wake_start = 0;
+    rtc_state.wakeups++;
+
+    while (1) {
+        int64_t next_due = run_due_jobs();
+
+        int64_t sleep_us = next_due - now_us();
+        rtc_state.awake_us += esp_timer_get_time() - wake_start;
+        if (sleep_us <= DUTY_CYCLE_SLACK_MS * US_PER_MS) {
+            wake_start = esp_timer_get_time();
+            continue;
+        }
+
+        esp_sleep_enable_timer_wakeup(sleep_us);
+        if (mode == DUTY_SLEEP_DEEP) {
+            esp_deep_sleep_start();  // Does not return; app_main() runs again on wakeup
+        }
+        esp_light_sleep_start();
+        wake_start = esp_timer_get_time();
+        rtc_state.wakeups++;
+    }
+}
+
+// Same steps as duty_cycle_start() and run_due_jobs(), with each job taking its awake_ms
+void duty_cycle_estimate(const duty_power_model_t *model, duty_estimate_t *out)
+{
+    int64_t next_due[DUTY_CYCLE_MAX_JOBS] = {0};
+    int64_t t = 0;            // ms since the cold boot
+    int64_t awake = 0;
+    double charge = 0.0;      // mA * ms
+    bool woke = true;         // The cold boot is the first wakeup
+
+    memset(out, 0, sizeof(*out));
+    while (t < MS_PER_HOUR) {
+        if (woke) {
+            t += model->wake_ms;
+            awake += model->wake_ms;
+            charge += (double)model->wake_ms * model->wake_ma;
+            out->wakeups_per_hour++;
+        }
+
+        int64_t window = t + DUTY_CYCLE_SLACK_MS;
+        int64_t earliest = INT64_MAX;
+        for (size_t i = 0; i < job_count; i++) {
+            if (next_due[i] <= window) {
+                t += jobs[i].cost.awake_ms;
+                awake += jobs[i].cost.awake_ms;
+                charge += (double)jobs[i].cost.awake_ms * jobs[i].cost.current_ma;
+                out->runs_per_hour[i]++;
+
+                next_due[i] += jobs[i].period_ms;
+                if (next_due[i] < t) {
+                    next_due[i] = t + jobs[i].period_ms;
+                }
+            }
+            if (next_due[i] < earliest) {
+                earliest = next_due[i];
+            }
+        }
+
+        // Too close to sleep: the loop goes round again without a wakeup to pay for
+        woke = earliest - t > DUTY_CYCLE_SLACK_MS;
+        if (woke) {
+            charge += (double)(earliest - t) * model->sleep_ma;
+            t = earliest;
+        }
+    }
+
+    out->awake_fraction = (float)awake / (float)t;
+    out->average_ma = (float)(charge / (double)t);
+}
+
+void duty_cycle_report(void)
+{
+    int64_t elapsed = now_us() - rtc_state.start_us;
+    if (elapsed <= 0) {
+        return;
+    }
+    float awake_fraction = (float)rtc_state.awake_us / (float)elapsed;
+    float wakeups_per_hour = (float)rtc_state.wakeups * (MS_PER_HOUR * US_PER_MS) / (float)elapsed;
+
+    ESP_LOGI(TAG, "Running %lld s: %lu wakeups (%.1f/h), awake %.2f%% of the time",
+             elapsed / (1000 * US_PER_MS), (unsigned long)rtc_state.wakeups,
+             wakeups_per_hour, awake_fraction * 100.0f);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define DUTY_CYCLE_MAX_JOBS 8
+#define DUTY_CYCLE_SLACK_MS 50   // Jobs due this close to a wakeup run in the same wakeup
+
+typedef void (*duty_job_fn_t)(void *arg);
+
+typedef enum {
+    DUTY_SLEEP_LIGHT,  // RAM and task state kept, wakeup in ~1 ms
+    DUTY_SLEEP_DEEP,   // Only RTC memory kept, app_main() runs again on every wakeup
+} duty_sleep_mode_t;
+
+// What one run of a job costs, used by duty_cycle_estimate()
+typedef struct {
+    uint32_t awake_ms;        // Typical time the job keeps the chip awake
+    float current_ma;         // Average current while it runs
+} duty_job_cost_t;
+
+// Cost of waking up at all, and of sleeping, for the chosen sleep mode
+typedef struct {
+    uint32_t wake_ms;         // Boot (deep sleep) or resume (light sleep) time per wakeup
+    float wake_ma;            // Current during wake_ms
+    float sleep_ma;           // Current while asleep
+} duty_power_model_t;
+
+// Result of duty_cycle_estimate()
+typedef struct {
+    uint32_t wakeups_per_hour;
+    uint32_t runs_per_hour[DUTY_CYCLE_MAX_JOBS];  // Per job, in registration order
+    float awake_fraction;     // 0.0 - 1.0
+    float average_ma;         // Average current over the hour
+} duty_estimate_t;
+
+// Register a periodic job. Jobs must be registered in the same order on every boot,
+// because their next due times are kept in RTC memory by index.
+esp_err_t duty_cycle_register(const char *name, uint32_t period_ms, duty_job_cost_t cost,
+                              duty_job_fn_t fn, void *arg);
+
+// Run due jobs, sleep until the next one, repeat. Never returns.
+void duty_cycle_start(duty_sleep_mode_t mode);
+
+// Simulate the registered job table for one hour without sleeping, step by step like
+// duty_cycle_start(). Every wakeup costs model->wake_ms, and each job that runs in it its
+// awake_ms. Missed slots are skipped, and when the next job is due within
+// DUTY_CYCLE_SLACK_MS the chip stays awake and pays no wakeup.
+void duty_cycle_estimate(const duty_power_model_t *model, duty_estimate_t *out);
+
+// Print the measured awake fraction and wakeups per hour since the first cold boot
+void duty_cycle_report(void);
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+
+#include "esp_wifi.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_sleep.h"
+#include "esp_http_client.h"
+#include "nvs_flash.h"
+#include "driver/adc.h"
+
+#include "duty_cycle.h"
+
+#define WIFI_SSID "Your SSID"
+#define WIFI_PASS "Your Password"
+#define UPLOAD_URL "http://192.168.1.100:8080/readings"  // Your collector endpoint
+
+#define ADC_PIN ADC1_CHANNEL_6          // GPIO34
+#define SLEEP_MODE DUTY_SLEEP_DEEP      // or DUTY_SLEEP_LIGHT
+
+#define SAMPLE_PERIOD_MS 10000          // Read the ADC every 10 s
+#define SAMPLES_PER_UPLOAD 6            // Wake the radio once per 6 samples (1 minute)
+#define REPORT_PERIOD_MS (10 * 60 * 1000)
+#define WIFI_TIMEOUT_MS 10000
+
+#define WIFI_CONNECTED_BIT BIT0
+
+static const char *TAG = "duty";
+
+// Typical cost of each job, for the schedule estimate (measure yours with a USB power meter)
+static const duty_job_cost_t SAMPLE_COST = { .awake_ms = 2,    .current_ma = 40.0f };
+static const duty_job_cost_t UPLOAD_COST = { .awake_ms = 1500, .current_ma = 120.0f };  // Connect + POST
+static const duty_job_cost_t REPORT_COST = { .awake_ms = 1,    .current_ma = 40.0f };
+
+// Fixed cost of a wakeup in each sleep mode
+static const duty_power_model_t DEEP_SLEEP_MODEL  = { .wake_ms = 30, .wake_ma = 40.0f, .sleep_ma = 0.01f };
+static const duty_power_model_t LIGHT_SLEEP_MODEL = { .wake_ms = 1,  .wake_ma = 40.0f, .sleep_ma = 0.8f };
+
+// Samples wait in RTC memory until the next radio window, so they survive deep sleep
+static RTC_DATA_ATTR int samples[SAMPLES_PER_UPLOAD * 4];
+static RTC_DATA_ATTR uint32_t sample_count = 0;
+
+static EventGroupHandle_t wifi_events;
+static bool wifi_initialized = false;
+
+static void on_wifi_event(void* arg, esp_event_base_t event_base,
+                          int32_t event_id, void* event_data)
+{
+    if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        xEventGroupSetBits(wifi_events, WIFI_CONNECTED_BIT);
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        xEventGroupClearBits(wifi_events, WIFI_CONNECTED_BIT);
+    }
+}
+
+// Wi-Fi is only initialized when the first upload actually needs it
+static void wifi_init_once(void)
+{
+    if (wifi_initialized) {
+        return;
+    }
+    ESP_ERROR_CHECK(nvs_flash_init());
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    esp_netif_create_default_wifi_sta();
+
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+
+    wifi_config_t wifi_config = {
+        .sta = {
+            .ssid = WIFI_SSID,
+            .password = WIFI_PASS,
+        },
+    };
+
+    wifi_events = xEventGroupCreate();
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &on_wifi_event, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &on_wifi_event, NULL));
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    wifi_initialized = true;
+}
+
+static esp_err_t post_samples(void)
+{
+    char body[SAMPLES_PER_UPLOAD * 4 * 6 + 4];
+    size_t len = 0;
+
+    body[len++] = '[';
+    for (uint32_t i = 0; i < sample_count; i++) {
+        len += snprintf(body + len, sizeof(body) - len, "%s%d", i ? "," : "", samples[i]);
+    }
+    body[len++] = ']';
+
+    esp_http_client_config_t config = {
+        .url = UPLOAD_URL,
+        .method = HTTP_METHOD_POST,
+        .timeout_ms = 5000,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    esp_http_client_set_header(client, "Content-Type", "application/json");
+    esp_http_client_set_post_field(client, body, len);
+    esp_err_t err = esp_http_client_perform(client);
+    esp_http_client_cleanup(client);
+    return err;
+}
+
+// Job 1: take one ADC reading and keep it in RTC memory
+static void sample_job(void *arg)
+{
+    if (sample_count < sizeof(samples) / sizeof(samples[0])) {
+        samples[sample_count++] = adc1_get_raw(ADC_PIN);
+    } else {
+        ESP_LOGW(TAG, "Sample buffer full, reading dropped");
+    }
+}
+
+// Job 2: bring the radio up once, send everything collected, and shut it down again
+static void upload_job(void *arg)
+{
+    if (sample_count == 0) {
+        return;
+    }
+
+    wifi_init_once();
+    ESP_ERROR_CHECK(esp_wifi_start());
+    esp_wifi_connect();
+
+    EventBits_t bits = xEventGroupWaitBits(wifi_events, WIFI_CONNECTED_BIT, pdFALSE, pdTRUE,
+                                           pdMS_TO_TICKS(WIFI_TIMEOUT_MS));
+    if ((bits & WIFI_CONNECTED_BIT) && post_samples() == ESP_OK) {
+        ESP_LOGI(TAG, "Uploaded %lu samples", (unsigned long)sample_count);
+        sample_count = 0;
+    } else {
+        ESP_LOGW(TAG, "Upload failed, keeping %lu samples for the next window",
+                 (unsigned long)sample_count);
+    }
+
+    esp_wifi_disconnect();
+    esp_wifi_stop();
+}
+
+// Job 3: print measured power statistics
+static void report_job(void *arg)
+{
+    duty_cycle_report();
+}
+
+void app_main(void)
+{
+    // app_main() runs after every deep sleep wakeup, so keep this short
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    adc1_config_channel_atten(ADC_PIN, ADC_ATTEN_DB_11);
+
+    duty_cycle_register("sample", SAMPLE_PERIOD_MS, SAMPLE_COST, sample_job, NULL);
+    duty_cycle_register("upload", SAMPLE_PERIOD_MS * SAMPLES_PER_UPLOAD, UPLOAD_COST, upload_job, NULL);
+    duty_cycle_register("report", REPORT_PERIOD_MS, REPORT_COST, report_job, NULL);
+
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER) {
+        duty_estimate_t estimate;
+        duty_cycle_estimate(SLEEP_MODE == DUTY_SLEEP_DEEP ? &DEEP_SLEEP_MODEL : &LIGHT_SLEEP_MODEL,
+                            &estimate);
+        ESP_LOGI(TAG, "Estimated schedule: %lu wakeups/h (%lu with Wi-Fi), awake %.2f%% of the time, "
+                 "%.2f mA average", (unsigned long)estimate.wakeups_per_hour,
+                 (unsigned long)estimate.runs_per_hour[1] /* upload */, estimate.awake_fraction * 100.0f,
+                 estimate.average_ma);
+    }
+
+    duty_cycle_start(SLEEP_MODE);
+}
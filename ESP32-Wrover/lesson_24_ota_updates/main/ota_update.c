@@ -0,0 +1,340 @@
+#include <ctype.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/param.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include "mbedtls/md.h"
+#include "mbedtls/sha256.h"
+
+#include "ota_update.h"
+
+#define DELTA_MAGIC "DPT1"
+
+static const char *TAG = "ota";
+
+typedef enum {
+    DELTA_HEADER,       // magic + target size
+    DELTA_OP,           // one opcode byte
+    DELTA_COPY_ARGS,    // offset + length
+    DELTA_INSERT_LEN,   // length
+    DELTA_INSERT_DATA,  // literal bytes, streamed straight to flash
+    DELTA_DONE,
+} delta_state_t;
+
+typedef struct {
+    const esp_partition_t *target;
+    esp_ota_handle_t handle;
+    mbedtls_sha256_context sha;
+    size_t written;
+    size_t min_free_heap;
+
+    // Delta patch parser
+    const esp_partition_t *source;
+    delta_state_t delta_state;
+    uint8_t field[8];
+    size_t field_len;
+    uint32_t delta_remaining;
+    uint32_t target_size;
+} ota_session_t;
+
+// One update at a time (the HTTP server runs handlers on a single task),
+// so the buffers can be static instead of living on the handler's stack
+static uint8_t recv_buf[OTA_CHUNK_SIZE];
+static uint8_t copy_buf[OTA_CHUNK_SIZE];
+static ota_session_t session;
+
+static inline uint32_t read_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static esp_err_t parse_hex_header(httpd_req_t *req, const char *field, uint8_t expected[32])
+{
+    char hex[65];
+    if (httpd_req_get_hdr_value_str(req, field, hex, sizeof(hex)) != ESP_OK || strlen(hex) != 64) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < 32; i++) {
+        // strtoul() alone would also accept " f" or "+f"
+        if (!isxdigit((unsigned char)hex[2 * i]) || !isxdigit((unsigned char)hex[2 * i + 1])) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        char byte[3] = { hex[2 * i], hex[2 * i + 1], 0 };
+        expected[i] = strtoul(byte, NULL, 16);
+    }
+    return ESP_OK;
+}
+
+// The SHA-256 only proves the image arrived intact: anyone can compute it. The HMAC of
+// that digest can only be made with OTA_SECRET, so it is checked before flash is touched.
+static bool signature_valid(const uint8_t digest[32], const uint8_t signature[32])
+{
+    uint8_t mac[32];
+    if (mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                        (const uint8_t *)OTA_SECRET, strlen(OTA_SECRET), digest, 32, mac) != 0) {
+        return false;
+    }
+    // Constant time, so the response time does not tell how many bytes matched
+    uint8_t diff = 0;
+    for (int i = 0; i < 32; i++) {
+        diff |= mac[i] ^ signature[i];
+    }
+    return diff == 0;
+}
+
+static esp_err_t session_begin(ota_session_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->source = esp_ota_get_running_partition();
+    s->target = esp_ota_get_next_update_partition(NULL);
+    if (s->target == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    // Sequential writes: sectors are erased as the data arrives instead of all up front
+    esp_err_t err = esp_ota_begin(s->target, OTA_WITH_SEQUENTIAL_WRITES, &s->handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    mbedtls_sha256_init(&s->sha);
+    mbedtls_sha256_starts(&s->sha, 0);
+    s->min_free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    return ESP_OK;
+}
+
+// Every byte of the new image goes through here: hash it and write it to flash
+static esp_err_t session_write(ota_session_t *s, const uint8_t *data, size_t len)
+{
+    mbedtls_sha256_update(&s->sha, data, len);
+    esp_err_t err = esp_ota_write(s->handle, data, len);
+    if (err == ESP_OK) {
+        s->written += len;
+    }
+    return err;
+}
+
+static esp_err_t delta_copy(ota_session_t *s, uint32_t offset, uint32_t length)
+{
+    if (offset > s->source->size || length > s->source->size - offset) {
+        ESP_LOGE(TAG, "Copy outside running image: %lu+%lu", (unsigned long)offset, (unsigned long)length);
+        return ESP_ERR_INVALID_ARG;
+    }
+    while (length > 0) {
+        size_t n = MIN(length, sizeof(copy_buf));
+        esp_err_t err = esp_partition_read(s->source, offset, copy_buf, n);
+        if (err == ESP_OK) {
+            err = session_write(s, copy_buf, n);
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+        offset += n;
+        length -= n;
+    }
+    return ESP_OK;
+}
+
+static size_t delta_field_size(delta_state_t state)
+{
+    switch (state) {
+    case DELTA_HEADER:     return 8;
+    case DELTA_COPY_ARGS:  return 8;
+    case DELTA_INSERT_LEN: return 4;
+    default:               return 1;
+    }
+}
+
+// Patch data may be split anywhere between two HTTP chunks, so the parser keeps its state
+static esp_err_t consume_delta(ota_session_t *s, const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        if (s->delta_state == DELTA_INSERT_DATA) {
+            size_t n = MIN(len, s->delta_remaining);
+            esp_err_t err = session_write(s, data, n);
+            if (err != ESP_OK) {
+                return err;
+            }
+            data += n;
+            len -= n;
+            s->delta_remaining -= n;
+            if (s->delta_remaining == 0) {
+                s->delta_state = DELTA_OP;
+            }
+            continue;
+        }
+
+        s->field[s->field_len++] = *data++;
+        len--;
+        if (s->field_len < delta_field_size(s->delta_state)) {
+            continue;
+        }
+        s->field_len = 0;
+
+        esp_err_t err = ESP_OK;
+        switch (s->delta_state) {
+        case DELTA_HEADER:
+            if (memcmp(s->field, DELTA_MAGIC, 4) != 0) {
+                return ESP_ERR_INVALID_VERSION;
+            }
+            s->target_size = read_le32(s->field + 4);
+            s->delta_state = DELTA_OP;
+            break;
+        case DELTA_OP:
+            if (s->field[0] == 'C') {
+                s->delta_state = DELTA_COPY_ARGS;
+            } else if (s->field[0] == 'I') {
+                s->delta_state = DELTA_INSERT_LEN;
+            } else if (s->field[0] == 'E') {
+                s->delta_state = DELTA_DONE;
+            } else {
+                return ESP_ERR_INVALID_ARG;
+            }
+            break;
+        case DELTA_COPY_ARGS:
+            err = delta_copy(s, read_le32(s->field), read_le32(s->field + 4));
+            s->delta_state = DELTA_OP;
+            break;
+        case DELTA_INSERT_LEN:
+            s->delta_remaining = read_le32(s->field);
+            s->delta_state = s->delta_remaining ? DELTA_INSERT_DATA : DELTA_OP;
+            break;
+        default:
+            // Data after the end marker
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (s->written > s->target->size) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+    return ESP_OK;
+}
+
+// Shared by both endpoints: receive in OTA_CHUNK_SIZE pieces, write (or patch) each one,
+// then verify the hash and switch the boot partition
+static esp_err_t receive_update(httpd_req_t *req, bool is_delta)
+{
+    ota_session_t *s = &session;
+    uint8_t expected[32], actual[32], signature[32];
+    if (parse_hex_header(req, "X-SHA256", expected) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing or invalid X-SHA256 header");
+    }
+    if (parse_hex_header(req, "X-Signature", signature) != ESP_OK || !signature_valid(expected, signature)) {
+        ESP_LOGW(TAG, "Update rejected: bad or missing X-Signature");
+        return httpd_resp_send_err(req, HTTPD_403_FORBIDDEN, "Bad or missing X-Signature");
+    }
+
+    esp_err_t err = session_begin(s);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_begin failed: %s", esp_err_to_name(err));
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Cannot start update");
+    }
+    ESP_LOGI(TAG, "Writing to partition %s, %u bytes incoming", s->target->label,
+             (unsigned)req->content_len);
+
+    int64_t start = esp_timer_get_time();
+    size_t remaining = req->content_len;
+    while (remaining > 0) {
+        int received = httpd_req_recv(req, (char *)recv_buf, MIN(remaining, sizeof(recv_buf)));
+        if (received == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (received <= 0) {
+            err = ESP_FAIL;
+            break;
+        }
+        err = is_delta ? consume_delta(s, recv_buf, received)
+                       : session_write(s, recv_buf, received);
+        if (err != ESP_OK) {
+            break;
+        }
+        remaining -= received;
+
+        size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        if (free_heap < s->min_free_heap) {
+            s->min_free_heap = free_heap;
+        }
+    }
+
+    mbedtls_sha256_finish(&s->sha, actual);
+    mbedtls_sha256_free(&s->sha);
+
+    if (err == ESP_OK && is_delta &&
+        (s->delta_state != DELTA_DONE || s->written != s->target_size)) {
+        ESP_LOGE(TAG, "Incomplete patch: %u of %lu bytes", (unsigned)s->written,
+                 (unsigned long)s->target_size);
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    if (err == ESP_OK && memcmp(actual, expected, sizeof(actual)) != 0) {
+        ESP_LOGE(TAG, "SHA-256 mismatch");
+        err = ESP_ERR_INVALID_CRC;
+    }
+    if (err != ESP_OK) {
+        esp_ota_abort(s->handle);
+        ESP_LOGE(TAG, "Update failed: %s", esp_err_to_name(err));
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Update failed");
+    }
+
+    // esp_ota_end() also checks the image header and segment checksums
+    err = esp_ota_end(s->handle);
+    if (err == ESP_OK) {
+        err = esp_ota_set_boot_partition(s->target);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Image rejected: %s", esp_err_to_name(err));
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Image rejected");
+    }
+
+    int64_t elapsed_us = esp_timer_get_time() - start;
+    char reply[160];
+    snprintf(reply, sizeof(reply),
+             "OK: received %u bytes, wrote %u bytes in %lld ms (%lld KB/s), lowest free heap %u bytes. Rebooting.\n",
+             (unsigned)req->content_len, (unsigned)s->written, elapsed_us / 1000,
+             elapsed_us ? (int64_t)s->written * 1000000 / 1024 / elapsed_us : 0,
+             (unsigned)s->min_free_heap);
+    ESP_LOGI(TAG, "%s", reply);
+    httpd_resp_sendstr(req, reply);
+
+    vTaskDelay(pdMS_TO_TICKS(500));  // Let the response go out
+    esp_restart();
+    return ESP_OK;
+}
+
+static esp_err_t update_handler(httpd_req_t *req)
+{
+    return receive_update(req, false);
+}
+
+static esp_err_t update_delta_handler(httpd_req_t *req)
+{
+    return receive_update(req, true);
+}
+
+esp_err_t ota_update_register(httpd_handle_t server)
+{
+    httpd_uri_t update = {
+        .uri      = "/update",
+        .method   = HTTP_POST,
+        .handler  = update_handler
+    };
+    httpd_uri_t update_delta = {
+        .uri      = "/update/delta",
+        .method   = HTTP_POST,
+        .handler  = update_delta_handler
+    };
+
+    esp_err_t err = httpd_register_uri_handler(server, &update);
+    if (err == ESP_OK) {
+        err = httpd_register_uri_handler(server, &update_delta);
+    }
+    return err;
+}
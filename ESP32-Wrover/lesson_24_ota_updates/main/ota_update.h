@@ -0,0 +1,33 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+// Size of the receive buffer; the image is never held in RAM as a whole
+#define OTA_CHUNK_SIZE 4096
+
+// Shared secret for the X-Signature header. Anyone who knows it can install firmware, so
+// there is no default: main/CMakeLists.txt takes it from the OTA_SECRET environment variable
+// at configure time, which keeps it out of version control.
+#ifndef OTA_SECRET
+#error "Define OTA_SECRET: OTA_SECRET=<long random string> idf.py reconfigure build"
+#endif
+
+// Registers two endpoints on an existing server:
+//
+//   POST /update        body = full application image (build/<project>.bin)
+//   POST /update/delta  body = delta patch against the running image (tools/make_delta.py)
+//
+// Both require two headers (tools/sign_image.py prints them):
+//   X-SHA256     hex SHA-256 of the final image (integrity: checked after the last byte)
+//   X-Signature  hex HMAC-SHA256 of that digest, keyed with OTA_SECRET (authenticity:
+//                checked before anything is written to flash)
+// On success the new image is marked bootable and the device restarts.
+//
+// Delta patch format (all integers little-endian):
+//   "DPT1" u32 target_size
+//   then a list of operations:
+//     'C' u32 offset u32 length   copy bytes from the running image
+//     'I' u32 length <bytes>      insert literal bytes
+//     'E'                         end of patch
+esp_err_t ota_update_register(httpd_handle_t server);
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""Create a delta patch for POST /update/delta.
+
+Usage: make_delta.py <running.bin> <new.bin> <patch.bin>
+
+<running.bin> must be exactly the image currently running on the device.
+Prints the SHA-256 of <new.bin>, which goes into the X-SHA256 header.
+
+Patch format (little-endian):
+  "DPT1" u32 target_size
+  'C' u32 offset u32 length    copy from the running image
+  'I' u32 length <bytes>       literal bytes
+  'E'                          end
+"""
+
+import hashlib
+import struct
+import sys
+from pathlib import Path
+
+BLOCK = 32           # Match granularity: blocks of the old image are indexed at this stride
+MIN_COPY = 2 * BLOCK  # Shorter matches are cheaper as literal bytes
+
+
+def build_index(old):
+    index = {}
+    for offset in range(0, len(old) - BLOCK + 1, BLOCK):
+        index.setdefault(old[offset:offset + BLOCK], offset)
+    return index
+
+
+def make_delta(old, new):
+    index = build_index(old)
+    out = bytearray(b"DPT1" + struct.pack("<I", len(new)))
+    literal = bytearray()
+
+    def flush_literal():
+        if literal:
+            out.extend(b"I" + struct.pack("<I", len(literal)) + literal)
+            literal.clear()
+
+    i = 0
+    while i < len(new):
+        src = index.get(new[i:i + BLOCK])
+        if src is None:
+            literal.append(new[i])
+            i += 1
+            continue
+
+        # Extend the match backwards into pending literals, then forwards
+        while literal and src > 0 and old[src - 1] == literal[-1]:
+            literal.pop()
+            src -= 1
+            i -= 1
+        length = 0
+        while i + length < len(new) and src + length < len(old) and new[i + length] == old[src + length]:
+            length += 1
+
+        if length < MIN_COPY:
+            literal.extend(new[i:i + length])
+            i += length
+            continue
+
+        flush_literal()
+        out.extend(b"C" + struct.pack("<II", src, length))
+        i += length
+
+    flush_literal()
+    out.extend(b"E")
+    return bytes(out)
+
+
+def main():
+    if len(sys.argv) != 4:
+        print(__doc__, file=sys.stderr)
+        return 1
+
+    old = Path(sys.argv[1]).read_bytes()
+    new = Path(sys.argv[2]).read_bytes()
+    patch = make_delta(old, new)
+    Path(sys.argv[3]).write_bytes(patch)
+
+    print(f"image {len(new)} bytes, patch {len(patch)} bytes ({100 * len(patch) / len(new):.1f}%)",
+          file=sys.stderr)
+    print(hashlib.sha256(new).hexdigest())
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,37 @@
+#!/usr/bin/env python3
+"""Print the headers for POST /update and /update/delta.
+
+Usage: sign_image.py <new.bin> <secret>
+
+<new.bin> is the final image (also for a delta update: the image the patch
+produces). <secret> must match the OTA_SECRET the firmware was built with. The output
+can be passed to curl with -H @headers.txt:
+
+  X-SHA256: <hex SHA-256 of the image>
+  X-Signature: <hex HMAC-SHA256 of that digest, keyed with the secret>
+"""
+
+import hashlib
+import hmac
+import sys
+from pathlib import Path
+
+
+def sign(image, secret):
+    digest = hashlib.sha256(image).digest()
+    return digest.hex(), hmac.new(secret, digest, hashlib.sha256).hexdigest()
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__, file=sys.stderr)
+        return 1
+
+    sha, signature = sign(Path(sys.argv[1]).read_bytes(), sys.argv[2].encode())
+    print(f"X-SHA256: {sha}")
+    print(f"X-Signature: {signature}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,360 @@
+#include <string.h>
+#include <stddef.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+
+#include "flash_log.h"
+
+#define SEGMENT_MAGIC  0x474F4C46  // "FLOG"
+#define PAGE_MAGIC     0x45474150  // "PAGE"
+#define ERASED_WORD    0xFFFFFFFF
+
+static const char *TAG = "flash_log";
+
+// Header written into page 0 of a segment right after it is erased
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;   // Increases by one every time a new segment is opened
+    uint32_t crc;   // CRC32 of magic and seq
+} segment_header_t;
+
+static inline size_t page_offset(uint32_t seg, uint32_t page)
+{
+    return (size_t)seg * FLASH_LOG_SEGMENT_SIZE + (size_t)page * FLASH_LOG_PAGE_SIZE;
+}
+
+static inline uint32_t next_segment(const flash_log_t *log, uint32_t seg)
+{
+    return (seg + 1) % log->segment_count;
+}
+
+// Returns true and fills *seq if the segment carries a valid header
+static bool read_segment_header(const flash_log_t *log, uint32_t seg, uint32_t *seq)
+{
+    segment_header_t hdr;
+    if (esp_partition_read(log->part, page_offset(seg, 0), &hdr, sizeof(hdr)) != ESP_OK) {
+        return false;
+    }
+    if (hdr.magic != SEGMENT_MAGIC ||
+        hdr.crc != esp_rom_crc32_le(0, (const uint8_t *)&hdr, offsetof(segment_header_t, crc))) {
+        return false;
+    }
+    *seq = hdr.seq;
+    return true;
+}
+
+// A page is free only if every byte is still erased; a torn write leaves it unusable
+static bool page_is_erased(const flash_log_t *log, uint32_t seg, uint32_t page)
+{
+    uint32_t words[FLASH_LOG_PAGE_SIZE / sizeof(uint32_t)];
+    if (esp_partition_read(log->part, page_offset(seg, page), words, sizeof(words)) != ESP_OK) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        if (words[i] != ERASED_WORD) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool page_is_pending(const flash_log_page_header_t *hdr)
+{
+    return hdr->magic == PAGE_MAGIC &&
+           hdr->count <= FLASH_LOG_RECORDS_PER_PAGE &&
+           hdr->consumed == ERASED_WORD;
+}
+
+// Erase a segment and stamp it with a new sequence number
+static esp_err_t open_segment(flash_log_t *log, uint32_t seg, uint32_t seq)
+{
+    esp_err_t err = esp_partition_erase_range(log->part, page_offset(seg, 0), FLASH_LOG_SEGMENT_SIZE);
+    if (err != ESP_OK) {
+        return err;
+    }
+    log->stats.segments_erased++;
+
+    segment_header_t hdr = { .magic = SEGMENT_MAGIC, .seq = seq };
+    hdr.crc = esp_rom_crc32_le(0, (const uint8_t *)&hdr, offsetof(segment_header_t, crc));
+    err = esp_partition_write(log->part, page_offset(seg, 0), &hdr, sizeof(hdr));
+    if (err != ESP_OK) {
+        return err;
+    }
+    log->stats.flash_bytes += sizeof(hdr);
+
+    log->head_seg = seg;
+    log->head_page = 1;
+    log->head_seq = seq;
+    return ESP_OK;
+}
+
+// Move the head to the next segment, dropping the oldest data if the log is full
+static esp_err_t advance_head(flash_log_t *log)
+{
+    uint32_t next = next_segment(log, log->head_seg);
+
+    if (next == log->tail_seg && log->tail_seg != log->head_seg) {
+        for (uint32_t page = log->tail_page; page < FLASH_LOG_PAGES_PER_SEG; page++) {
+            flash_log_page_header_t hdr;
+            if (esp_partition_read(log->part, page_offset(next, page), &hdr, sizeof(hdr)) == ESP_OK &&
+                page_is_pending(&hdr)) {
+                log->stats.records_dropped += hdr.count;
+            }
+        }
+        log->tail_seg = next_segment(log, next);
+        log->tail_page = 1;
+        log->peek_valid = false;
+        ESP_LOGW(TAG, "Log full, dropped oldest segment %lu", (unsigned long)next);
+    }
+
+    return open_segment(log, next, log->head_seq + 1);
+}
+
+// Program the RAM batch as one full page (unused record slots stay erased)
+static esp_err_t write_batch(flash_log_t *log)
+{
+    if (log->batch_count == 0) {
+        return ESP_OK;
+    }
+    if (log->head_page >= FLASH_LOG_PAGES_PER_SEG) {
+        esp_err_t err = advance_head(log);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    uint8_t page[FLASH_LOG_PAGE_SIZE];
+    memset(page, 0xFF, sizeof(page));
+
+    flash_log_page_header_t hdr = {
+        .magic = PAGE_MAGIC,
+        .count = log->batch_count,
+        .reserved = 0,
+        .crc = esp_rom_crc32_le(0, (const uint8_t *)log->batch,
+                                log->batch_count * sizeof(flash_log_record_t)),
+        .consumed = ERASED_WORD,
+    };
+    memcpy(page, &hdr, sizeof(hdr));
+    memcpy(page + sizeof(hdr), log->batch, log->batch_count * sizeof(flash_log_record_t));
+
+    size_t offset = page_offset(log->head_seg, log->head_page);
+    esp_err_t err = esp_partition_write(log->part, offset, page, sizeof(page));
+    if (err != ESP_OK) {
+        // The page may be half programmed and cannot be written again without an erase.
+        // Mark it as sent so it never looks pending, and keep the batch for the next page.
+        uint32_t zero = 0;
+        esp_partition_write(log->part, offset + offsetof(flash_log_page_header_t, consumed),
+                            &zero, sizeof(zero));
+        log->head_page++;
+        log->stats.bad_pages++;
+        ESP_LOGE(TAG, "Page %lu/%lu write failed: %s", (unsigned long)log->head_seg,
+                 (unsigned long)(log->head_page - 1), esp_err_to_name(err));
+        return err;
+    }
+
+    log->head_page++;
+    log->batch_count = 0;
+    log->stats.pages_written++;
+    log->stats.flash_bytes += sizeof(page);
+    return ESP_OK;
+}
+
+// Walk from the oldest segment towards the head and stop at the first unsent page
+static void recover_tail(flash_log_t *log, uint32_t oldest_seg)
+{
+    uint32_t seg = oldest_seg;
+    while (1) {
+        uint32_t end = (seg == log->head_seg) ? log->head_page : FLASH_LOG_PAGES_PER_SEG;
+        for (uint32_t page = 1; page < end; page++) {
+            flash_log_page_header_t hdr;
+            if (esp_partition_read(log->part, page_offset(seg, page), &hdr, sizeof(hdr)) == ESP_OK &&
+                page_is_pending(&hdr)) {
+                log->tail_seg = seg;
+                log->tail_page = page;
+                return;
+            }
+        }
+        if (seg == log->head_seg) {
+            break;
+        }
+        seg = next_segment(log, seg);
+    }
+
+    log->tail_seg = log->head_seg;
+    log->tail_page = log->head_page;
+}
+
+esp_err_t flash_log_open(flash_log_t *log, const char *partition_label)
+{
+    memset(log, 0, sizeof(*log));
+
+    log->part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                         partition_label);
+    if (log->part == NULL) {
+        ESP_LOGE(TAG, "Partition '%s' not found", partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+    log->segment_count = log->part->size / FLASH_LOG_SEGMENT_SIZE;
+    if (log->segment_count < 2) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    log->lock = xSemaphoreCreateMutex();
+    if (log->lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    int64_t start = esp_timer_get_time();
+
+    // Newest valid segment becomes the head, oldest valid segment the tail
+    bool found = false;
+    uint32_t oldest_seg = 0;
+    uint32_t oldest_seq = UINT32_MAX;
+    for (uint32_t seg = 0; seg < log->segment_count; seg++) {
+        uint32_t seq;
+        if (!read_segment_header(log, seg, &seq)) {
+            continue;
+        }
+        if (!found || seq > log->head_seq) {
+            log->head_seg = seg;
+            log->head_seq = seq;
+        }
+        if (seq < oldest_seq) {
+            oldest_seg = seg;
+            oldest_seq = seq;
+        }
+        found = true;
+    }
+
+    esp_err_t err = ESP_OK;
+    if (!found) {
+        err = open_segment(log, 0, 1);
+        log->tail_seg = 0;
+        log->tail_page = 1;
+    } else {
+        // Writing continues after the last programmed page. A page skipped after a failed
+        // write can still be erased, so the search starts from the end of the segment.
+        log->head_page = FLASH_LOG_PAGES_PER_SEG;
+        while (log->head_page > 1 && page_is_erased(log, log->head_seg, log->head_page - 1)) {
+            log->head_page--;
+        }
+        recover_tail(log, oldest_seg);
+    }
+
+    log->stats.recovery_us = esp_timer_get_time() - start;
+    ESP_LOGI(TAG, "Opened %lu segments in %lu us: head %lu/%lu (seq %lu), tail %lu/%lu",
+             (unsigned long)log->segment_count, (unsigned long)log->stats.recovery_us,
+             (unsigned long)log->head_seg, (unsigned long)log->head_page,
+             (unsigned long)log->head_seq,
+             (unsigned long)log->tail_seg, (unsigned long)log->tail_page);
+    return err;
+}
+
+esp_err_t flash_log_append(flash_log_t *log, const flash_log_record_t *record)
+{
+    esp_err_t err = ESP_OK;
+
+    xSemaphoreTake(log->lock, portMAX_DELAY);
+    // Still full: the last page write failed. Retry it on the next page before taking more.
+    if (log->batch_count == FLASH_LOG_RECORDS_PER_PAGE) {
+        err = write_batch(log);
+    }
+    if (err == ESP_OK) {
+        log->batch[log->batch_count++] = *record;
+        log->stats.records_appended++;
+        log->stats.payload_bytes += sizeof(*record);
+        if (log->batch_count == FLASH_LOG_RECORDS_PER_PAGE) {
+            err = write_batch(log);
+        }
+    }
+    xSemaphoreGive(log->lock);
+
+    return err;
+}
+
+esp_err_t flash_log_flush(flash_log_t *log)
+{
+    xSemaphoreTake(log->lock, portMAX_DELAY);
+    esp_err_t err = write_batch(log);
+    xSemaphoreGive(log->lock);
+    return err;
+}
+
+esp_err_t flash_log_peek(flash_log_t *log, flash_log_record_t *out, size_t max, size_t *count)
+{
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    *count = 0;
+
+    xSemaphoreTake(log->lock, portMAX_DELAY);
+    log->peek_valid = false;
+
+    while (!(log->tail_seg == log->head_seg && log->tail_page >= log->head_page)) {
+        if (log->tail_page >= FLASH_LOG_PAGES_PER_SEG) {
+            log->tail_seg = next_segment(log, log->tail_seg);
+            log->tail_page = 1;
+            continue;
+        }
+
+        uint8_t page[FLASH_LOG_PAGE_SIZE];
+        flash_log_page_header_t hdr;
+        if (esp_partition_read(log->part, page_offset(log->tail_seg, log->tail_page),
+                               page, sizeof(page)) != ESP_OK) {
+            err = ESP_FAIL;
+            break;
+        }
+        memcpy(&hdr, page, sizeof(hdr));
+
+        const uint8_t *records = page + sizeof(hdr);
+        if (page_is_pending(&hdr) &&
+            hdr.crc == esp_rom_crc32_le(0, records, hdr.count * sizeof(flash_log_record_t))) {
+            // A valid page that does not fit stays pending; *count tells the caller what is needed
+            *count = hdr.count;
+            if (hdr.count > max) {
+                err = ESP_ERR_INVALID_SIZE;
+                break;
+            }
+            memcpy(out, records, hdr.count * sizeof(flash_log_record_t));
+            log->peek_valid = true;
+            err = ESP_OK;
+            break;
+        }
+
+        // Already uploaded, torn or corrupted: skip it
+        log->tail_page++;
+    }
+
+    xSemaphoreGive(log->lock);
+    return err;
+}
+
+esp_err_t flash_log_consume(flash_log_t *log)
+{
+    esp_err_t err = ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(log->lock, portMAX_DELAY);
+    if (log->peek_valid) {
+        // Clearing bits needs no erase, so marking a page as sent costs one 4-byte write
+        uint32_t zero = 0;
+        err = esp_partition_write(log->part,
+                                  page_offset(log->tail_seg, log->tail_page) +
+                                      offsetof(flash_log_page_header_t, consumed),
+                                  &zero, sizeof(zero));
+        if (err == ESP_OK) {
+            log->stats.flash_bytes += sizeof(zero);
+            log->tail_page++;
+            log->peek_valid = false;
+        }
+    }
+    xSemaphoreGive(log->lock);
+
+    return err;
+}
+
+void flash_log_get_stats(flash_log_t *log, flash_log_stats_t *stats)
+{
+    xSemaphoreTake(log->lock, portMAX_DELAY);
+    *stats = log->stats;
+    xSemaphoreGive(log->lock);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "esp_partition.h"
+
+// Flash geometry: one segment is one erase sector, one page is one program page.
+// Page 0 of every segment holds the segment header, pages 1..15 hold records.
+#define FLASH_LOG_SEGMENT_SIZE   4096
+#define FLASH_LOG_PAGE_SIZE      256
+#define FLASH_LOG_PAGES_PER_SEG  (FLASH_LOG_SEGMENT_SIZE / FLASH_LOG_PAGE_SIZE)
+
+// One sensor reading as stored in flash (8 bytes)
+typedef struct {
+    uint32_t timestamp;  // Seconds since epoch (or since boot before SNTP sync)
+    int32_t value;       // Raw sensor value
+} flash_log_record_t;
+
+// Header written at the start of every data page
+typedef struct {
+    uint32_t magic;
+    uint16_t count;      // Number of valid records in this page
+    uint16_t reserved;
+    uint32_t crc;        // CRC32 of the records
+    uint32_t consumed;   // 0xFFFFFFFF while pending, cleared to 0 once uploaded
+} flash_log_page_header_t;
+
+#define FLASH_LOG_RECORDS_PER_PAGE \
+    ((FLASH_LOG_PAGE_SIZE - sizeof(flash_log_page_header_t)) / sizeof(flash_log_record_t))
+
+// Counters used to judge throughput and flash wear
+typedef struct {
+    uint32_t records_appended;
+    uint32_t records_dropped;    // Lost because the log wrapped onto unsent data
+    uint32_t pages_written;
+    uint32_t bad_pages;          // Page writes that failed; the page is skipped
+    uint32_t segments_erased;
+    uint64_t payload_bytes;      // Bytes of record data handed to the log
+    uint64_t flash_bytes;        // Bytes actually programmed (headers, padding, markers)
+    uint32_t recovery_us;        // Time spent scanning flash in flash_log_open()
+} flash_log_stats_t;
+
+typedef struct {
+    const esp_partition_t *part;
+    uint32_t segment_count;
+
+    uint32_t head_seg;           // Segment currently being filled
+    uint32_t head_page;          // Next free page in head_seg
+    uint32_t head_seq;           // Sequence number of head_seg
+
+    uint32_t tail_seg;           // Oldest segment that may hold unsent pages
+    uint32_t tail_page;          // Next page to upload in tail_seg
+    bool peek_valid;             // Set by flash_log_peek(), cleared if the tail is dropped
+
+    flash_log_record_t batch[FLASH_LOG_RECORDS_PER_PAGE];  // RAM page buffer
+    size_t batch_count;
+
+    SemaphoreHandle_t lock;
+    flash_log_stats_t stats;
+} flash_log_t;
+
+// Find the data partition by label and rebuild head/tail by scanning segment headers
+esp_err_t flash_log_open(flash_log_t *log, const char *partition_label);
+
+// Add one record to the RAM batch; a full batch is written to flash as one page.
+// If that write fails, the record is kept and the error returned; the batch is retried on
+// the next page by the next call, which returns an error without taking its record if the
+// retry fails too.
+esp_err_t flash_log_append(flash_log_t *log, const flash_log_record_t *record);
+
+// Write the partially filled RAM batch to flash (e.g. before upload or reboot)
+esp_err_t flash_log_flush(flash_log_t *log);
+
+// Copy the oldest unsent page into out[]; returns ESP_ERR_NOT_FOUND if nothing is pending.
+// If the page holds more than max records, nothing is copied, *count is set to the page's
+// record count and ESP_ERR_INVALID_SIZE is returned (the page stays pending).
+esp_err_t flash_log_peek(flash_log_t *log, flash_log_record_t *out, size_t max, size_t *count);
+
+// Mark the page returned by flash_log_peek() as uploaded
+esp_err_t flash_log_consume(flash_log_t *log);
+
+// Snapshot of the counters
+void flash_log_get_stats(flash_log_t *log, flash_log_stats_t *stats);
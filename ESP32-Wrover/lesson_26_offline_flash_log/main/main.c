@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_wifi.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_log.h"
+#include "esp_http_client.h"
+#include "nvs_flash.h"
+#include "driver/adc.h"
+
+#include "flash_log.h"
+
+#define WIFI_SSID "Your SSID"
+#define WIFI_PASS "Your Password"
+#define UPLOAD_URL "http://192.168.1.100:8080/readings"  // Your collector endpoint
+
+#define ADC_PIN ADC1_CHANNEL_6      // GPIO34
+#define SAMPLE_PERIOD_MS 1000       // One reading per second
+#define STATS_PERIOD_S 60           // Print log statistics once a minute
+
+static const char *TAG = "offline_log";
+static volatile bool wifi_connected = false;
+static flash_log_t sample_log;
+
+// Wi-Fi events: track connection state and keep retrying after a drop
+static void on_wifi_event(void* arg, esp_event_base_t event_base,
+                          int32_t event_id, void* event_data)
+{
+    if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
+        ESP_LOGI(TAG, "Connected! IP Address: " IPSTR, IP2STR(&event->ip_info.ip));
+        wifi_connected = true;
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        if (wifi_connected) {
+            ESP_LOGW(TAG, "Wi-Fi lost, buffering readings in flash");
+        }
+        wifi_connected = false;
+        esp_wifi_connect();
+    }
+}
+
+// Function to initialize Wi-Fi and attempt connection
+void wifi_connect()
+{
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    esp_netif_create_default_wifi_sta();
+
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+
+    wifi_config_t wifi_config = {
+        .sta = {
+            .ssid = WIFI_SSID,
+            .password = WIFI_PASS,
+        },
+    };
+
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &on_wifi_event, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &on_wifi_event, NULL));
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    ESP_ERROR_CHECK(esp_wifi_start());
+    ESP_ERROR_CHECK(esp_wifi_connect());
+
+    ESP_LOGI(TAG, "Connecting to %s...", WIFI_SSID);
+}
+
+// POST one page of readings as a JSON array; returns ESP_OK on a 2xx reply
+static esp_err_t upload_records(const flash_log_record_t *records, size_t count)
+{
+    // 30 records of up to ~40 characters each fit comfortably
+    static char body[FLASH_LOG_RECORDS_PER_PAGE * 40 + 4];
+    size_t len = 0;
+
+    body[len++] = '[';
+    for (size_t i = 0; i < count; i++) {
+        len += snprintf(body + len, sizeof(body) - len, "%s{\"t\":%lu,\"v\":%ld}",
+                        i ? "," : "", (unsigned long)records[i].timestamp, (long)records[i].value);
+    }
+    body[len++] = ']';
+
+    esp_http_client_config_t config = {
+        .url = UPLOAD_URL,
+        .method = HTTP_METHOD_POST,
+        .timeout_ms = 5000,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    esp_http_client_set_header(client, "Content-Type", "application/json");
+    esp_http_client_set_post_field(client, body, len);
+
+    esp_err_t err = esp_http_client_perform(client);
+    if (err == ESP_OK) {
+        int status = esp_http_client_get_status_code(client);
+        if (status < 200 || status >= 300) {
+            err = ESP_FAIL;
+        }
+    }
+    esp_http_client_cleanup(client);
+    return err;
+}
+
+// Task 1: sample the ADC and append to the log (RAM batch, written a page at a time)
+void sample_task(void *pvParameter)
+{
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    adc1_config_channel_atten(ADC_PIN, ADC_ATTEN_DB_11);
+
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1) {
+        flash_log_record_t record = {
+            .timestamp = (uint32_t)time(NULL),
+            .value = adc1_get_raw(ADC_PIN),
+        };
+        if (flash_log_append(&sample_log, &record) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to append reading");
+        }
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(SAMPLE_PERIOD_MS));
+    }
+}
+
+// Task 2: drain the log to the server whenever Wi-Fi is up
+void upload_task(void *pvParameter)
+{
+    static flash_log_record_t records[FLASH_LOG_RECORDS_PER_PAGE];
+    size_t count;
+
+    while (1) {
+        if (!wifi_connected) {
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            continue;
+        }
+
+        // Push the partial RAM batch out so the newest readings are sent too
+        flash_log_flush(&sample_log);
+
+        while (wifi_connected &&
+               flash_log_peek(&sample_log, records, FLASH_LOG_RECORDS_PER_PAGE, &count) == ESP_OK) {
+            if (upload_records(records, count) != ESP_OK) {
+                ESP_LOGW(TAG, "Upload failed, will retry");
+                break;
+            }
+            flash_log_consume(&sample_log);
+        }
+
+        // Collect a few full pages before the next upload round
+        vTaskDelay(pdMS_TO_TICKS(SAMPLE_PERIOD_MS * FLASH_LOG_RECORDS_PER_PAGE));
+    }
+}
+
+// Task 3: report throughput and flash wear
+void stats_task(void *pvParameter)
+{
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(STATS_PERIOD_S * 1000));
+
+        flash_log_stats_t stats;
+        flash_log_get_stats(&sample_log, &stats);
+
+        float amplification = stats.payload_bytes ?
+            (float)stats.flash_bytes / (float)stats.payload_bytes : 0.0f;
+        ESP_LOGI(TAG, "records %lu, dropped %lu, pages %lu (%lu bad), erases %lu, write amplification %.2f",
+                 (unsigned long)stats.records_appended, (unsigned long)stats.records_dropped,
+                 (unsigned long)stats.pages_written, (unsigned long)stats.bad_pages,
+                 (unsigned long)stats.segments_erased, amplification);
+    }
+}
+
+void app_main(void)
+{
+    ESP_ERROR_CHECK(nvs_flash_init());
+
+    // Recover head and tail from flash before any new reading is taken
+    ESP_ERROR_CHECK(flash_log_open(&sample_log, "datalog"));
+
+    wifi_connect();
+
+    xTaskCreate(sample_task, "sample_task", 3072, NULL, 6, NULL);
+    xTaskCreate(upload_task, "upload_task", 6144, NULL, 5, NULL);
+    xTaskCreate(stats_task, "stats_task", 3072, NULL, 1, NULL);
+}
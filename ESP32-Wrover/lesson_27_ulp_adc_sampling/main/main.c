@@ -0,0 +1,178 @@
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_adc/adc_oneshot.h"
+#include "driver/rtc_io.h"
+#include "soc/rtc_cntl_reg.h"
+#include "soc/rtc.h"
+#include "esp_private/esp_clk.h"
+#include "ulp.h"
+#include "ulp_adc.h"
+
+#include "ulp_main.h"     // Generated: exposes ULP variables as ulp_<name>
+#include "ulp_config.h"
+
+#define USE_ULP_SAMPLING 1        // 0 = Lesson 5 style loop on the main CPU, for comparison
+#define ULP_PERIOD_MS 100         // ULP sampling period
+#define DELTA_THRESHOLD 200       // Wake the CPU when the signal moves by more than this (raw counts)
+#define LOOP_PERIOD_MS 500        // Sampling period of the Lesson 5 loop
+#define LOOP_REPORT_SAMPLES 20    // Loop statistics every 20 samples
+
+extern const uint8_t ulp_main_bin_start[] asm("_binary_ulp_main_bin_start");
+extern const uint8_t ulp_main_bin_end[]   asm("_binary_ulp_main_bin_end");
+
+// Statistics that survive deep sleep
+static RTC_DATA_ATTR uint32_t cpu_wakeups = 0;
+static RTC_DATA_ATTR uint32_t samples_total = 0;
+static RTC_DATA_ATTR uint16_t last_ulp_total = 0;
+static RTC_DATA_ATTR uint64_t awake_us_total = 0;
+static RTC_DATA_ATTR uint32_t max_latency_us = 0;
+
+#if USE_ULP_SAMPLING
+
+// Called once after power-on: load the ULP program and hand ADC1 to it
+static void init_ulp_program(void)
+{
+    ESP_ERROR_CHECK(ulp_load_binary(0, ulp_main_bin_start,
+                                    (ulp_main_bin_end - ulp_main_bin_start) / sizeof(uint32_t)));
+
+    ulp_adc_cfg_t cfg = {
+        .adc_n = ADC_UNIT_1,
+        .channel = ULP_ADC_CHANNEL,
+        .width = ADC_BITWIDTH_DEFAULT,
+        .atten = ADC_ATTEN_DB_12,     // 0–3.3V range, same as Lesson 5
+        .ulp_mode = ADC_ULP_MODE_FSM,
+    };
+    ESP_ERROR_CHECK(ulp_adc_init(&cfg));
+
+    ulp_delta_threshold = DELTA_THRESHOLD;
+    ulp_reference = 0;
+    ulp_sample_count = 0;
+
+    ESP_ERROR_CHECK(ulp_set_wakeup_period(0, ULP_PERIOD_MS * 1000));
+
+    // Less work on every wakeup: no ROM boot messages, no leakage through the strapping pins
+    esp_deep_sleep_disable_rom_logging();
+    rtc_gpio_isolate(GPIO_NUM_12);
+    rtc_gpio_isolate(GPIO_NUM_15);
+}
+
+// Time from the ULP sample that asked for this wakeup until now, from the RTC timer
+static uint32_t wakeup_latency_us(void)
+{
+    uint32_t requested = (ulp_wake_time_hi & UINT16_MAX) << 16 | (ulp_wake_time_lo & UINT16_MAX);
+    uint32_t ticks = (uint32_t)rtc_time_get() - requested;     // Low 32 bits wrap after hours
+    return (uint32_t)rtc_time_slowclk_to_us(ticks, esp_clk_slowclk_cal_get());
+}
+
+// Called after a ULP wakeup: read the buffered samples and set the new reference
+static void process_samples(void)
+{
+    // ULP variables are 32-bit words; only the low 16 bits hold data
+    uint32_t count = ulp_sample_count & UINT16_MAX;
+    uint32_t *buffer = &ulp_samples;
+    uint32_t min = UINT16_MAX, max = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t value = buffer[i] & UINT16_MAX;
+        if (value < min) min = value;
+        if (value > max) max = value;
+    }
+    uint32_t last = ulp_last_result & UINT16_MAX;
+
+    uint16_t ulp_total = ulp_sample_total & UINT16_MAX;
+    samples_total += (uint16_t)(ulp_total - last_ulp_total);
+    last_ulp_total = ulp_total;
+
+    printf("Woken by %s: %lu samples, min %lu, max %lu, last %lu\n",
+           count >= ULP_BUFFER_SIZE ? "full buffer" : "threshold",
+           (unsigned long)count, (unsigned long)min, (unsigned long)max, (unsigned long)last);
+
+    uint32_t latency = wakeup_latency_us();
+    if (latency > max_latency_us) {
+        max_latency_us = latency;
+    }
+    uint64_t elapsed_us = esp_clk_rtc_time();     // Since power-on, keeps running in deep sleep
+
+    // Lesson 5 wakes (and keeps awake) the CPU for every sample; here it wakes once per batch
+    printf("ULP samples: %lu, CPU wakeups: %lu (%.1f per hour, %.1f samples per wakeup), "
+           "wakeup took %lld us\n",
+           (unsigned long)samples_total, (unsigned long)cpu_wakeups,
+           cpu_wakeups * 3600e6 / elapsed_us, (float)samples_total / (float)cpu_wakeups,
+           esp_timer_get_time());
+    printf("Sample-to-CPU latency: %lu us (max %lu us), CPU awake %.3f%% of the time\n",
+           (unsigned long)latency, (unsigned long)max_latency_us,
+           100.0 * awake_us_total / elapsed_us);
+
+    ulp_reference = last;
+    ulp_sample_count = 0;
+    ulp_wake_pending = 0;
+}
+
+void app_main(void)
+{
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_ULP) {
+        printf("Power-on: starting ULP sampling every %d ms\n", ULP_PERIOD_MS);
+        init_ulp_program();
+    } else {
+        cpu_wakeups++;
+        process_samples();
+    }
+
+    ESP_ERROR_CHECK(esp_sleep_enable_ulp_wakeup());
+    ESP_ERROR_CHECK(ulp_run(&ulp_entry - RTC_SLOW_MEM));
+    awake_us_total += esp_timer_get_time();       // esp_timer restarts from 0 on every boot
+    esp_deep_sleep_start();
+}
+
+#else
+
+// Same loop as Lesson 5: the CPU stays awake and samples every LOOP_PERIOD_MS
+void app_main(void)
+{
+    adc_oneshot_unit_handle_t adc;
+    adc_oneshot_unit_init_cfg_t unit_cfg = { .unit_id = ADC_UNIT_1 };
+    ESP_ERROR_CHECK(adc_oneshot_new_unit(&unit_cfg, &adc));
+
+    adc_oneshot_chan_cfg_t chan_cfg = {
+        .bitwidth = ADC_BITWIDTH_12,
+        .atten = ADC_ATTEN_DB_12,
+    };
+    ESP_ERROR_CHECK(adc_oneshot_config_channel(adc, ULP_ADC_CHANNEL, &chan_cfg));
+
+    int64_t last_sample_us = 0;
+    int64_t max_interval_us = 0;
+
+    while (1) {
+        int adc_reading;
+        ESP_ERROR_CHECK(adc_oneshot_read(adc, ULP_ADC_CHANNEL, &adc_reading));
+
+        // A change is seen at the next sample, so the longest interval is the worst latency
+        int64_t now = esp_timer_get_time();
+        if (samples_total > 0 && now - last_sample_us > max_interval_us) {
+            max_interval_us = now - last_sample_us;
+        }
+        last_sample_us = now;
+        samples_total++;
+        printf("ADC Reading: %d (sample %lu, CPU never sleeps)\n",
+               adc_reading, (unsigned long)samples_total);
+
+        // Every sample is one task wakeup, and the CPU never enters sleep in between
+        if (samples_total % LOOP_REPORT_SAMPLES == 0) {
+            printf("Loop samples: %lu, task wakeups: %lu (%.1f per hour, 1 sample per wakeup)\n",
+                   (unsigned long)samples_total, (unsigned long)samples_total,
+                   samples_total * 3600e6 / now);
+            printf("Change-to-sample latency: up to %lld us, CPU awake 100%% of the time\n",
+                   max_interval_us);
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(LOOP_PERIOD_MS));
+    }
+}
+
+#endif
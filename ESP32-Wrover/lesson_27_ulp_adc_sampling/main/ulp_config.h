@@ -0,0 +1,8 @@
+#pragma once
+
+// Shared between main.c and ulp/adc_sampler.S, so only plain #defines here
+
+#define ULP_ADC_CHANNEL 6              // ADC1_CHANNEL_6 = GPIO34
+#define ULP_OVERSAMPLING_LOG 2         // Average 2^2 = 4 conversions per sample
+#define ULP_OVERSAMPLING (1 << ULP_OVERSAMPLING_LOG)
+#define ULP_BUFFER_SIZE 64             // Samples kept in RTC slow memory
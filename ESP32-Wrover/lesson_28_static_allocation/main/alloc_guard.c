@@ -0,0 +1,46 @@
+#include <stdlib.h>
+
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_sys.h"
+
+#include "alloc_guard.h"
+
+static volatile bool armed = false;
+static volatile uint32_t violations = 0;
+static volatile size_t last_size = 0;
+
+void alloc_guard_arm(void)
+{
+    armed = true;
+}
+
+bool alloc_guard_is_armed(void)
+{
+    return armed;
+}
+
+uint32_t alloc_guard_violations(void)
+{
+    return violations;
+}
+
+size_t alloc_guard_last_size(void)
+{
+    return last_size;
+}
+
+// Runs inside the allocator, maybe in an ISR or with the flash cache disabled:
+// IRAM only, no heap, no printf (esp_rom_printf is in ROM)
+IRAM_ATTR void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    if (!armed) {
+        return;
+    }
+    violations++;
+    last_size = size;
+#if ALLOC_GUARD_ABORT
+    esp_rom_printf("alloc_guard: %u-byte heap allocation after init\n", (unsigned)size);
+    abort();    // The backtrace shows which code allocated
+#endif
+}
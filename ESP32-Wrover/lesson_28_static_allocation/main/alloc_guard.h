@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Catches heap allocations after init. With CONFIG_HEAP_USE_HOOKS=y ESP-IDF calls
+// esp_heap_trace_alloc_hook() inside every malloc()/heap_caps_malloc(); this module
+// implements that hook.
+
+#ifndef ALLOC_GUARD_ABORT
+#define ALLOC_GUARD_ABORT 1       // 1 = abort on the first allocation after init, 0 = only count
+#endif
+
+// Call once init is done: from now on every heap allocation is an error
+void alloc_guard_arm(void);
+bool alloc_guard_is_armed(void);
+
+// Allocations seen since alloc_guard_arm(), and the size of the last one
+uint32_t alloc_guard_violations(void);
+size_t alloc_guard_last_size(void);
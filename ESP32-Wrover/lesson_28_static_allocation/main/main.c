@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "driver/uart.h"
+#include "driver/adc.h"
+#include "esp_heap_caps.h"
+
+#include "mem_pool.h"
+#include "alloc_guard.h"
+#include "messages.h"
+
+#define USE_STATIC_ALLOCATION 1   // 0 = heap-allocated tasks and queue, as in Lesson 9
+
+#define BUTTON_PIN GPIO_NUM_0     // Button connected to GPIO 0
+#define LED_PIN GPIO_NUM_2        // LED connected to GPIO 2
+#define TXD_PIN GPIO_NUM_4        // UART TX pin
+#define RXD_PIN GPIO_NUM_5        // UART RX pin
+#define UART_PORT UART_NUM_1      // Using UART1
+#define ADC_PIN ADC1_CHANNEL_6    // GPIO34
+
+#define TASK_STACK_SIZE 2048      // Bytes; every task's stack is sized at compile time
+#define UART_TASK_STACK_SIZE 4096 // The UART task also prints the heap report
+#define QUEUE_LENGTH 8
+#define SAMPLE_PERIOD_MS 500
+
+// Each task sets its bit once its one-time driver setup is done
+#define BUTTON_READY_BIT BIT0
+#define PWM_READY_BIT    BIT1
+#define SENSOR_READY_BIT BIT2
+#define UART_READY_BIT   BIT3
+#define ALL_READY_BITS   (BUTTON_READY_BIT | PWM_READY_BIT | SENSOR_READY_BIT | UART_READY_BIT)
+
+volatile bool led_on = false;     // Shared flag for LED state
+static QueueHandle_t uart_queue;
+static EventGroupHandle_t setup_events;
+
+static TaskHandle_t button_handle, pwm_handle, sensor_handle, uart_handle;
+
+#if USE_STATIC_ALLOCATION
+static StaticQueue_t uart_queue_buffer;
+static StaticEventGroup_t setup_events_buffer;
+static uint8_t uart_queue_storage[QUEUE_LENGTH * sizeof(queue_item_t)];
+
+static StackType_t button_stack[TASK_STACK_SIZE], pwm_stack[TASK_STACK_SIZE];
+static StackType_t sensor_stack[TASK_STACK_SIZE], uart_stack[UART_TASK_STACK_SIZE];
+static StaticTask_t button_tcb, pwm_tcb, sensor_tcb, uart_tcb;
+#endif
+
+// Interrupt handler for button press: take a block from the pool, never from the heap
+static void IRAM_ATTR button_isr_handler(void *arg) {
+    led_on = !led_on;
+
+    BaseType_t woken = pdFALSE;
+    queue_item_t item;
+    if (!messages_new_button_event(&item, xTaskGetTickCountFromISR(), led_on)) {
+        return;
+    }
+    if (xQueueSendFromISR(uart_queue, &item, &woken) != pdTRUE) {
+        messages_drop(&item);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+static void heap_report(const char *when)
+{
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+
+    printf("--- Heap report (%s) ---\n", when);
+    printf("Free: %u bytes, minimum ever free: %u bytes, largest block: %u bytes\n",
+           (unsigned)info.total_free_bytes, (unsigned)info.minimum_free_bytes,
+           (unsigned)info.largest_free_block);
+    printf("Allocated: %u blocks, %u bytes\n",
+           (unsigned)info.allocated_blocks, (unsigned)info.total_allocated_bytes);
+    const mem_pool_t *events = messages_event_pool(), *frames = messages_frame_pool();
+    printf("Event pool: %u/%u free (low %u), frame pool: %u/%u free (low %u), dropped: %lu\n",
+           (unsigned)mem_pool_free_count(events), (unsigned)events->block_count,
+           (unsigned)mem_pool_min_free_count(events),
+           (unsigned)mem_pool_free_count(frames), (unsigned)frames->block_count,
+           (unsigned)mem_pool_min_free_count(frames), (unsigned long)messages_dropped());
+    printf("Stack high water marks (bytes unused): button %u, pwm %u, sensor %u, uart %u\n",
+           (unsigned)uxTaskGetStackHighWaterMark(button_handle),
+           (unsigned)uxTaskGetStackHighWaterMark(pwm_handle),
+           (unsigned)uxTaskGetStackHighWaterMark(sensor_handle),
+           (unsigned)uxTaskGetStackHighWaterMark(uart_handle));
+
+    // The guard aborts on the first allocation after init, so reaching this line proves it
+    if (alloc_guard_is_armed()) {
+        printf("Steady state: %lu heap allocations since init\n",
+               (unsigned long)alloc_guard_violations());
+    }
+}
+
+// Create a task with a compile-time sized stack (static mode) or from the heap (dynamic mode)
+static TaskHandle_t start_task(TaskFunction_t fn, const char *name, uint32_t stack_size,
+                               StackType_t *stack, StaticTask_t *tcb)
+{
+#if USE_STATIC_ALLOCATION
+    return xTaskCreateStatic(fn, name, stack_size, NULL, 10, stack, tcb);
+#else
+    TaskHandle_t handle = NULL;
+    xTaskCreate(fn, name, stack_size, NULL, 10, &handle);
+    return handle;
+#endif
+}
+
+// Task 1: Configure button GPIO and set up interrupt
+void button_task(void *pvParameter) {
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << BUTTON_PIN),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .intr_type = GPIO_INTR_NEGEDGE  // Interrupt on falling edge
+    };
+    gpio_config(&io_conf);
+
+    gpio_install_isr_service(0);  // Default ISR service
+    gpio_isr_handler_add(BUTTON_PIN, button_isr_handler, NULL);  // Add ISR
+    xEventGroupSetBits(setup_events, BUTTON_READY_BIT);
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));  // Nothing else needed here
+    }
+}
+
+// Task 2: PWM control of LED based on button flag
+void pwm_task(void *pvParameter) {
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .timer_num = LEDC_TIMER_0,
+        .duty_resolution = LEDC_TIMER_8_BIT,
+        .freq_hz = 5000,
+        .clk_cfg = LEDC_AUTO_CLK
+    };
+    ledc_timer_config(&ledc_timer);
+
+    ledc_channel_config_t ledc_channel = {
+        .channel = LEDC_CHANNEL_0,
+        .duty = 0,
+        .gpio_num = LED_PIN,
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .hpoint = 0,
+        .timer_sel = LEDC_TIMER_0
+    };
+    ledc_channel_config(&ledc_channel);
+    xEventGroupSetBits(setup_events, PWM_READY_BIT);
+
+    while (1) {
+        if (led_on) {
+            for (int duty = 0; duty < 256; duty += 10) {
+                ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, duty);
+                ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
+                vTaskDelay(pdMS_TO_TICKS(20));
+            }
+        } else {
+            ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 0);
+            ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
+        }
+        vTaskDelay(pdMS_TO_TICKS(500));
+    }
+}
+
+// Task 3: fill sensor frames from the ADC and hand them to the UART task
+void sensor_task(void *pvParameter) {
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    adc1_config_channel_atten(ADC_PIN, ADC_ATTEN_DB_11);
+    xEventGroupSetBits(setup_events, SENSOR_READY_BIT);
+
+    uint32_t seq = 0;
+    while (1) {
+        queue_item_t item;
+        if (!messages_new_sensor_frame(&item, seq++)) {
+            vTaskDelay(pdMS_TO_TICKS(SAMPLE_PERIOD_MS));
+            continue;
+        }
+
+        sensor_frame_t *frame = item.block;
+        for (int i = 0; i < FRAME_SAMPLES; i++) {
+            frame->samples[i] = adc1_get_raw(ADC_PIN);
+            vTaskDelay(pdMS_TO_TICKS(SAMPLE_PERIOD_MS));
+        }
+
+        if (xQueueSend(uart_queue, &item, 0) != pdTRUE) {
+            messages_drop(&item);
+        }
+    }
+}
+
+// Task 4: format queued items into a static buffer and send them over UART.
+// Typing 'h' in the serial terminal prints the heap report.
+void uart_task(void *pvParameter) {
+    static char line[128];
+    queue_item_t item;
+
+    // The UART driver is installed by app_main(), so there is nothing to set up here
+    xEventGroupSetBits(setup_events, UART_READY_BIT);
+
+    while (1) {
+        if (xQueueReceive(uart_queue, &item, pdMS_TO_TICKS(100)) == pdTRUE) {
+            int len = messages_format(&item, line, sizeof(line));
+            uart_write_bytes(UART_PORT, line, len);
+        }
+
+        uint8_t command;
+        if (uart_read_bytes(UART_PORT, &command, 1, 0) == 1 && command == 'h') {
+            heap_report("on demand");
+        }
+    }
+}
+
+// Main application
+void app_main() {
+    messages_init();
+
+    // UART configuration (done once here so no task allocates after init)
+    uart_config_t uart_config = {
+        .baud_rate = 115200,
+        .data_bits = UART_DATA_8_BITS,
+        .parity    = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE
+    };
+    uart_param_config(UART_PORT, &uart_config);
+    uart_set_pin(UART_PORT, TXD_PIN, RXD_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    uart_driver_install(UART_PORT, 1024 * 2, 0, 0, NULL, 0);
+
+#if USE_STATIC_ALLOCATION
+    uart_queue = xQueueCreateStatic(QUEUE_LENGTH, sizeof(queue_item_t),
+                                    uart_queue_storage, &uart_queue_buffer);
+    setup_events = xEventGroupCreateStatic(&setup_events_buffer);
+    button_handle = start_task(button_task, "Button Task", TASK_STACK_SIZE, button_stack, &button_tcb);
+    pwm_handle = start_task(pwm_task, "PWM Task", TASK_STACK_SIZE, pwm_stack, &pwm_tcb);
+    sensor_handle = start_task(sensor_task, "Sensor Task", TASK_STACK_SIZE, sensor_stack, &sensor_tcb);
+    uart_handle = start_task(uart_task, "UART Task", UART_TASK_STACK_SIZE, uart_stack, &uart_tcb);
+#else
+    uart_queue = xQueueCreate(QUEUE_LENGTH, sizeof(queue_item_t));
+    setup_events = xEventGroupCreate();
+    button_handle = start_task(button_task, "Button Task", TASK_STACK_SIZE, NULL, NULL);
+    pwm_handle = start_task(pwm_task, "PWM Task", TASK_STACK_SIZE, NULL, NULL);
+    sensor_handle = start_task(sensor_task, "Sensor Task", TASK_STACK_SIZE, NULL, NULL);
+    uart_handle = start_task(uart_task, "UART Task", UART_TASK_STACK_SIZE, NULL, NULL);
+#endif
+
+    // Wait until every task has finished its one-time driver setup, then forbid any further
+    // allocation. Every malloc() from here on, even a malloc/free pair, aborts with a backtrace.
+    xEventGroupWaitBits(setup_events, ALL_READY_BITS, pdFALSE, pdTRUE, portMAX_DELAY);
+    alloc_guard_arm();
+    heap_report("boot");
+
+    // app_main() stays alive so the heap report keeps the same numbers
+    while (1) {
+        vTaskDelay(portMAX_DELAY);
+    }
+}
@@ -0,0 +1,54 @@
+#include "esp_attr.h"
+
+#include "mem_pool.h"
+
+void mem_pool_init(mem_pool_t *pool)
+{
+    pool->free_list = NULL;
+    for (size_t i = pool->block_count; i > 0; i--) {
+        void **block = (void **)(pool->storage + (i - 1) * pool->block_size);
+        *block = pool->free_list;
+        pool->free_list = block;
+    }
+    pool->free_count = pool->block_count;
+    pool->min_free_count = pool->block_count;
+}
+
+// IRAM_ATTR so the pool can be used from IRAM interrupt handlers
+IRAM_ATTR void *mem_pool_alloc(mem_pool_t *pool)
+{
+    // portENTER_CRITICAL_SAFE works both in tasks and in ISRs
+    portENTER_CRITICAL_SAFE(&pool->lock);
+    void **block = pool->free_list;
+    if (block != NULL) {
+        pool->free_list = *block;
+        pool->free_count--;
+        if (pool->free_count < pool->min_free_count) {
+            pool->min_free_count = pool->free_count;
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&pool->lock);
+    return block;
+}
+
+IRAM_ATTR void mem_pool_free(mem_pool_t *pool, void *block)
+{
+    if (block == NULL) {
+        return;
+    }
+    portENTER_CRITICAL_SAFE(&pool->lock);
+    *(void **)block = pool->free_list;
+    pool->free_list = block;
+    pool->free_count++;
+    portEXIT_CRITICAL_SAFE(&pool->lock);
+}
+
+size_t mem_pool_free_count(const mem_pool_t *pool)
+{
+    return pool->free_count;
+}
+
+size_t mem_pool_min_free_count(const mem_pool_t *pool)
+{
+    return pool->min_free_count;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+// Fixed-block memory pool backed by a static array.
+// Allocation and release are O(1) and safe to call from tasks and ISRs.
+typedef struct {
+    uint8_t *storage;
+    size_t block_size;
+    size_t block_count;
+    void *free_list;          // Each free block stores the pointer to the next one
+    size_t free_count;
+    size_t min_free_count;    // Low watermark, to size the pool from real usage
+    portMUX_TYPE lock;
+} mem_pool_t;
+
+// Define a pool of `count` blocks that can each hold a `type`, with storage in .bss
+#define MEM_POOL_DEFINE(name, type, count)                                        \
+    static union {                                                                \
+        type item;                                                                \
+        void *next;                                                               \
+    } name##_storage[count];                                                      \
+    static mem_pool_t name = {                                                    \
+        .storage = (uint8_t *)name##_storage,                                     \
+        .block_size = sizeof(name##_storage[0]),                                  \
+        .block_count = (count),                                                   \
+        .lock = portMUX_INITIALIZER_UNLOCKED,                                     \
+    }
+
+// Link all blocks into the free list; call once before the first allocation
+void mem_pool_init(mem_pool_t *pool);
+
+// Returns NULL when the pool is exhausted
+void *mem_pool_alloc(mem_pool_t *pool);
+
+void mem_pool_free(mem_pool_t *pool, void *block);
+
+size_t mem_pool_free_count(const mem_pool_t *pool);
+size_t mem_pool_min_free_count(const mem_pool_t *pool);
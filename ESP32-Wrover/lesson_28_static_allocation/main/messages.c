@@ -0,0 +1,86 @@
+#include <stdio.h>
+
+#include "esp_attr.h"
+
+#include "messages.h"
+
+MEM_POOL_DEFINE(event_pool, button_event_t, 8);
+MEM_POOL_DEFINE(frame_pool, sensor_frame_t, 4);
+
+static volatile uint32_t dropped_items = 0;
+
+void messages_init(void)
+{
+    mem_pool_init(&event_pool);
+    mem_pool_init(&frame_pool);
+}
+
+// IRAM_ATTR because the button ISR calls it
+IRAM_ATTR bool messages_new_button_event(queue_item_t *item, TickType_t tick, bool led_on)
+{
+    button_event_t *event = mem_pool_alloc(&event_pool);
+    if (event == NULL) {
+        dropped_items++;
+        return false;
+    }
+    event->tick = tick;
+    event->led_on = led_on;
+    item->kind = ITEM_BUTTON_EVENT;
+    item->block = event;
+    return true;
+}
+
+bool messages_new_sensor_frame(queue_item_t *item, uint32_t seq)
+{
+    sensor_frame_t *frame = mem_pool_alloc(&frame_pool);
+    if (frame == NULL) {
+        dropped_items++;
+        return false;
+    }
+    frame->seq = seq;
+    item->kind = ITEM_SENSOR_FRAME;
+    item->block = frame;
+    return true;
+}
+
+IRAM_ATTR void messages_drop(const queue_item_t *item)
+{
+    mem_pool_free(item->kind == ITEM_BUTTON_EVENT ? &event_pool : &frame_pool, item->block);
+    dropped_items++;
+}
+
+// Integers only: formatting floats can allocate inside newlib
+int messages_format(const queue_item_t *item, char *line, size_t size)
+{
+    int len = 0;
+    if (item->kind == ITEM_BUTTON_EVENT) {
+        button_event_t *event = item->block;
+        len = snprintf(line, size, "[%lu] Button: LED is %s\n",
+                       (unsigned long)event->tick, event->led_on ? "ON" : "BLINKING");
+        mem_pool_free(&event_pool, event);
+    } else {
+        sensor_frame_t *frame = item->block;
+        len = snprintf(line, size, "Frame %lu:", (unsigned long)frame->seq);
+        for (int i = 0; i < FRAME_SAMPLES; i++) {
+            len += snprintf(line + len, size - len, " %d", frame->samples[i]);
+        }
+        len += snprintf(line + len, size - len, "\n");
+        mem_pool_free(&frame_pool, frame);
+    }
+    return len;
+}
+
+uint32_t messages_dropped(void)
+{
+    return dropped_items;
+}
+
+const mem_pool_t *messages_event_pool(void)
+{
+    return &event_pool;
+}
+
+const mem_pool_t *messages_frame_pool(void)
+{
+    return &frame_pool;
+}
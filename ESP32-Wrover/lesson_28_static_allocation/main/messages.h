@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "mem_pool.h"
+
+// The per-message work of the tasks: take a block from a pool, fill it, format it for
+// the UART and return it. Nothing here touches the heap; the host test runs this file
+// with the allocation guard armed.
+
+#define FRAME_SAMPLES 8           // ADC samples per sensor frame
+
+typedef struct {
+    TickType_t tick;
+    bool led_on;
+} button_event_t;
+
+typedef struct {
+    uint32_t seq;
+    int samples[FRAME_SAMPLES];
+} sensor_frame_t;
+
+// Messages travel through the queue as pointers to pool blocks
+typedef enum {
+    ITEM_BUTTON_EVENT,
+    ITEM_SENSOR_FRAME,
+} queue_item_kind_t;
+
+typedef struct {
+    queue_item_kind_t kind;
+    void *block;
+} queue_item_t;
+
+// Link the pools; call once before the tasks start
+void messages_init(void);
+
+// Take a block from the pool and fill in the header. Returns false and counts a drop
+// when the pool is empty. Safe to call from an ISR.
+bool messages_new_button_event(queue_item_t *item, TickType_t tick, bool led_on);
+bool messages_new_sensor_frame(queue_item_t *item, uint32_t seq);
+
+// Return the block of an item that could not be queued and count a drop
+void messages_drop(const queue_item_t *item);
+
+// Format the item into `line` and return its block to the pool; returns the length
+int messages_format(const queue_item_t *item, char *line, size_t size);
+
+uint32_t messages_dropped(void);
+const mem_pool_t *messages_event_pool(void);
+const mem_pool_t *messages_frame_pool(void);
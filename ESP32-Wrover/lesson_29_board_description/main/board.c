@@ -0,0 +1,58 @@
+#include "soc/soc.h"
+#include "soc/gpio_reg.h"
+
+#include "board.h"
+
+esp_err_t board_init(void)
+{
+    // Latch the initial levels first, so no output glitches when it is enabled.
+    // GPIO_OUT_* covers GPIO0-31, GPIO_OUT1_* covers GPIO32-39.
+    REG_WRITE(GPIO_OUT_W1TC_REG, (uint32_t)BOARD_OUTPUT_LOW_MASK);
+    REG_WRITE(GPIO_OUT1_W1TC_REG, (uint32_t)(BOARD_OUTPUT_LOW_MASK >> 32));
+    REG_WRITE(GPIO_OUT_W1TS_REG, (uint32_t)BOARD_OUTPUT_HIGH_MASK);
+    REG_WRITE(GPIO_OUT1_W1TS_REG, (uint32_t)(BOARD_OUTPUT_HIGH_MASK >> 32));
+
+    for (int i = 0; i < BOARD_GPIO_CONFIG_COUNT; i++) {
+        esp_err_t err = gpio_config(&board_gpio_configs[i]);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t board_init_per_pin(void)
+{
+    for (int i = 0; i < BOARD_PIN_COUNT; i++) {
+        const board_pin_t *pin = &board_pins[i];
+        gpio_mode_t mode;
+
+        switch (pin->mode) {
+        case BOARD_PIN_INPUT:
+            mode = GPIO_MODE_INPUT;
+            break;
+        case BOARD_PIN_OUTPUT:
+            mode = GPIO_MODE_OUTPUT;
+            break;
+        case BOARD_PIN_OPEN_DRAIN:
+            mode = GPIO_MODE_INPUT_OUTPUT_OD;
+            break;
+        default:
+            continue;
+        }
+
+        gpio_reset_pin(pin->gpio);
+        gpio_set_direction(pin->gpio, mode);
+        if (pin->pull == BOARD_PULL_UP) {
+            gpio_set_pull_mode(pin->gpio, GPIO_PULLUP_ONLY);
+        } else if (pin->pull == BOARD_PULL_DOWN) {
+            gpio_set_pull_mode(pin->gpio, GPIO_PULLDOWN_ONLY);
+        } else {
+            gpio_set_pull_mode(pin->gpio, GPIO_FLOATING);
+        }
+        if (mode != GPIO_MODE_INPUT) {
+            gpio_set_level(pin->gpio, pin->level);
+        }
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+typedef enum {
+    BOARD_PIN_INPUT,
+    BOARD_PIN_OUTPUT,
+    BOARD_PIN_OPEN_DRAIN,
+    BOARD_PIN_PERIPHERAL,   // Routed by a peripheral driver (UART, LEDC, ...), not by board_init()
+    BOARD_PIN_ANALOG,       // Configured by the ADC driver
+} board_pin_mode_t;
+
+typedef enum {
+    BOARD_PULL_NONE,
+    BOARD_PULL_UP,
+    BOARD_PULL_DOWN,
+} board_pull_t;
+
+typedef struct {
+    const char *name;
+    gpio_num_t gpio;
+    board_pin_mode_t mode;
+    board_pull_t pull;
+    uint8_t level;          // Initial level for outputs
+} board_pin_t;
+
+// Generated at build time from board.json (see tools/gen_board.py)
+#include "board_config.h"
+
+// Configure every GPIO in the board description: initial levels are set first,
+// then one gpio_config() call per distinct mode/pull combination.
+esp_err_t board_init(void);
+
+// The same setup done pin by pin with gpio_reset_pin()/gpio_set_direction()/...,
+// as the earlier lessons do. Only used to compare boot-time cost.
+esp_err_t board_init_per_pin(void);
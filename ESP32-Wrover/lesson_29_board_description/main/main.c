@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include "board.h"
+
+#define INIT_RUNS 100   // Repeat each init style to get a stable average
+
+// Segment patterns for digits 0–9, same as Lesson 2 (a, b, c, d, e, f, g)
+static const uint8_t digit_segments[10] = {
+    0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F
+};
+
+static const char *mode_names[] = { "input", "output", "open-drain", "peripheral", "analog" };
+
+void display_digit(int digit)
+{
+    for (int i = 0; i < BOARD_SEGMENT_COUNT; i++) {
+        gpio_set_level(board_segment_pins[i], (digit_segments[digit] >> i) & 1);
+    }
+}
+
+static void print_board(void)
+{
+    printf("Board: %s, %d pins\n", BOARD_NAME, BOARD_PIN_COUNT);
+    for (int i = 0; i < BOARD_PIN_COUNT; i++) {
+        printf("  %-10s GPIO%-2d %s\n", board_pins[i].name, board_pins[i].gpio,
+               mode_names[board_pins[i].mode]);
+    }
+}
+
+// Compare the generated one-shot init against the pin-by-pin style of the earlier lessons
+static void measure_init_cost(void)
+{
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < INIT_RUNS; i++) {
+        board_init_per_pin();
+    }
+    int64_t per_pin_us = (esp_timer_get_time() - start) / INIT_RUNS;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < INIT_RUNS; i++) {
+        board_init();
+    }
+    int64_t batched_us = (esp_timer_get_time() - start) / INIT_RUNS;
+
+    printf("GPIO init: pin by pin %lld us, batched (%d gpio_config calls) %lld us\n",
+           per_pin_us, BOARD_GPIO_CONFIG_COUNT, batched_us);
+}
+
+void app_main(void)
+{
+    ESP_ERROR_CHECK(board_init());
+
+    print_board();
+    measure_init_cost();
+
+    int digit = 0;
+    while (1) {
+        // LED mirrors the button (pressed = low), the display counts up
+        gpio_set_level(BOARD_PIN_LED, gpio_get_level(BOARD_PIN_BUTTON) == 0);
+        display_digit(digit);
+        digit = (digit + 1) % 10;
+
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+"""Generate board_config.h / board_config.c from board.json.
+
+Usage: gen_board.py <board.json> <output directory>
+
+The build fails (exit code 1) if two functions share a GPIO, a reserved
+pin is used, an input-only pin drives an output, or an ADC channel does not
+match its GPIO.
+"""
+
+import json
+import sys
+from pathlib import Path
+
+# GPIOs that exist on the ESP32
+VALID_GPIOS = set(range(0, 40)) - {20, 24, 28, 29, 30, 31}
+
+MODES = {
+    # mode in board.json: (board_pin_mode_t, gpio_mode_t or None if gpio_config() is skipped)
+    "input":      ("BOARD_PIN_INPUT",      "GPIO_MODE_INPUT"),
+    "output":     ("BOARD_PIN_OUTPUT",     "GPIO_MODE_OUTPUT"),
+    "open_drain": ("BOARD_PIN_OPEN_DRAIN", "GPIO_MODE_INPUT_OUTPUT_OD"),
+    "peripheral": ("BOARD_PIN_PERIPHERAL", None),
+    "analog":     ("BOARD_PIN_ANALOG",     None),
+}
+
+PULLS = {
+    "none": "BOARD_PULL_NONE",
+    "up":   "BOARD_PULL_UP",
+    "down": "BOARD_PULL_DOWN",
+}
+
+OUTPUT_MODES = {"output", "open_drain"}
+
+# Peripheral signals: "input" (UART RX, capture) may use an input-only pin
+DIRECTIONS = {"input", "output", "bidirectional"}
+
+# ESP32 ADC channel of each analog-capable GPIO
+ADC_CHANNELS = {
+    36: "ADC1_CHANNEL_0", 37: "ADC1_CHANNEL_1", 38: "ADC1_CHANNEL_2", 39: "ADC1_CHANNEL_3",
+    32: "ADC1_CHANNEL_4", 33: "ADC1_CHANNEL_5", 34: "ADC1_CHANNEL_6", 35: "ADC1_CHANNEL_7",
+    4:  "ADC2_CHANNEL_0", 0:  "ADC2_CHANNEL_1", 2:  "ADC2_CHANNEL_2", 15: "ADC2_CHANNEL_3",
+    13: "ADC2_CHANNEL_4", 12: "ADC2_CHANNEL_5", 14: "ADC2_CHANNEL_6", 27: "ADC2_CHANNEL_7",
+    25: "ADC2_CHANNEL_8", 26: "ADC2_CHANNEL_9",
+}
+
+
+def validate(board):
+    errors = []
+    warnings = []
+    reserved = {int(gpio): why for gpio, why in board.get("reserved", {}).items()}
+    input_only = set(board.get("input_only", []))
+    strapping = set(board.get("strapping", []))
+    used = {}
+    names = set()
+
+    for pin in board["pins"]:
+        name = pin["name"]
+        gpio = pin["gpio"]
+        mode = pin["mode"]
+        where = f"{name} (GPIO{gpio})"
+
+        if name in names:
+            errors.append(f"{name}: name used twice")
+        names.add(name)
+
+        if mode not in MODES:
+            errors.append(f"{where}: unknown mode '{mode}'")
+        if pin.get("pull", "none") not in PULLS:
+            errors.append(f"{where}: unknown pull '{pin['pull']}'")
+        if gpio not in VALID_GPIOS:
+            errors.append(f"{where}: GPIO{gpio} does not exist on the ESP32")
+        if gpio in reserved:
+            errors.append(f"{where}: GPIO{gpio} is reserved for {reserved[gpio]}")
+        if mode == "peripheral":
+            direction = pin.get("direction", "output")
+            if direction not in DIRECTIONS:
+                errors.append(f"{where}: unknown direction '{direction}'")
+            elif gpio in input_only and direction != "input":
+                errors.append(f"{where}: GPIO{gpio} is input-only, "
+                              "mark input signals (UART RX, capture) with \"direction\": \"input\"")
+        if gpio in input_only and mode in OUTPUT_MODES:
+            errors.append(f"{where}: GPIO{gpio} is input-only")
+        if gpio in input_only and pin.get("pull", "none") != "none":
+            errors.append(f"{where}: GPIO{gpio} has no internal pull resistors")
+        if mode == "analog" or "adc_channel" in pin:
+            expected = ADC_CHANNELS.get(gpio)
+            if expected is None:
+                errors.append(f"{where}: GPIO{gpio} has no ADC channel")
+            elif pin.get("adc_channel", expected) != expected:
+                errors.append(f"{where}: {pin['adc_channel']} is not on GPIO{gpio}, it is {expected}")
+            elif expected.startswith("ADC2"):
+                warnings.append(f"{where}: ADC2 cannot be read while Wi-Fi is running")
+        if gpio in strapping and not pin.get("allow_strapping", False):
+            warnings.append(f"{where}: GPIO{gpio} is a strapping pin, check its boot-time level")
+
+        # Pins of the same peripheral may not share a GPIO either
+        if gpio in used:
+            errors.append(f"{where}: GPIO{gpio} already used by {used[gpio]}")
+        else:
+            used[gpio] = name
+
+    return errors, warnings
+
+
+def mask_literal(mask):
+    return f"0x{mask:010X}ULL"
+
+
+def generate(board, header_path, source_path):
+    pins = board["pins"]
+
+    # One gpio_config_t per distinct (mode, pull) combination
+    config_masks = {}
+    high_mask = 0
+    low_mask = 0
+    for pin in pins:
+        gpio_mode = MODES[pin["mode"]][1]
+        if gpio_mode is None:
+            continue
+        key = (gpio_mode, pin.get("pull", "none"))
+        config_masks[key] = config_masks.get(key, 0) | (1 << pin["gpio"])
+        if pin["mode"] in OUTPUT_MODES:
+            if pin.get("level", 0):
+                high_mask |= 1 << pin["gpio"]
+            else:
+                low_mask |= 1 << pin["gpio"]
+
+    groups = {}
+    for pin in pins:
+        if "group" in pin:
+            groups.setdefault(pin["group"], []).append(pin)
+
+    h = []
+    h.append("// Generated from board.json by tools/gen_board.py. Do not edit.")
+    h.append("// Include board.h instead of this file.")
+    h.append("#pragma once")
+    h.append("")
+    h.append(f"#define BOARD_NAME \"{board['board']}\"")
+    h.append("")
+    h.append("// Pin assignments")
+    for pin in pins:
+        h.append(f"#define BOARD_PIN_{pin['name']} GPIO_NUM_{pin['gpio']}")
+    for pin in pins:
+        if "adc_channel" in pin:
+            h.append(f"#define BOARD_ADC_{pin['name']} {pin['adc_channel']}")
+    h.append("")
+    h.append("// Initial output levels, applied before the outputs are enabled")
+    h.append(f"#define BOARD_OUTPUT_HIGH_MASK {mask_literal(high_mask)}")
+    h.append(f"#define BOARD_OUTPUT_LOW_MASK  {mask_literal(low_mask)}")
+    h.append("")
+    for group, members in groups.items():
+        h.append(f"#define BOARD_{group}_COUNT {len(members)}")
+        h.append(f"extern const gpio_num_t board_{group.lower()}_pins[BOARD_{group}_COUNT];")
+    h.append("")
+    h.append(f"#define BOARD_PIN_COUNT {len(pins)}")
+    h.append("extern const board_pin_t board_pins[BOARD_PIN_COUNT];")
+    h.append("")
+    h.append(f"#define BOARD_GPIO_CONFIG_COUNT {len(config_masks)}")
+    h.append("extern const gpio_config_t board_gpio_configs[BOARD_GPIO_CONFIG_COUNT];")
+    h.append("")
+
+    c = []
+    c.append("// Generated from board.json by tools/gen_board.py. Do not edit.")
+    c.append("#include \"board.h\"")
+    c.append("")
+    for group, members in groups.items():
+        c.append(f"const gpio_num_t board_{group.lower()}_pins[BOARD_{group}_COUNT] = {{")
+        for pin in members:
+            c.append(f"    BOARD_PIN_{pin['name']},")
+        c.append("};")
+        c.append("")
+    c.append("const board_pin_t board_pins[BOARD_PIN_COUNT] = {")
+    for pin in pins:
+        mode = MODES[pin["mode"]][0]
+        pull = PULLS[pin.get("pull", "none")]
+        level = 1 if pin.get("level", 0) else 0
+        c.append(f"    {{ \"{pin['name']}\", GPIO_NUM_{pin['gpio']}, {mode}, {pull}, {level} }},")
+    c.append("};")
+    c.append("")
+    c.append("const gpio_config_t board_gpio_configs[BOARD_GPIO_CONFIG_COUNT] = {")
+    for (gpio_mode, pull), mask in config_masks.items():
+        c.append("    {")
+        c.append(f"        .pin_bit_mask = {mask_literal(mask)},")
+        c.append(f"        .mode = {gpio_mode},")
+        c.append(f"        .pull_up_en = {'GPIO_PULLUP_ENABLE' if pull == 'up' else 'GPIO_PULLUP_DISABLE'},")
+        c.append(f"        .pull_down_en = {'GPIO_PULLDOWN_ENABLE' if pull == 'down' else 'GPIO_PULLDOWN_DISABLE'},")
+        c.append("        .intr_type = GPIO_INTR_DISABLE,")
+        c.append("    },")
+    c.append("};")
+    c.append("")
+
+    header_path.write_text("\n".join(h))
+    source_path.write_text("\n".join(c))
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__, file=sys.stderr)
+        return 1
+
+    board_path = Path(sys.argv[1])
+    out_dir = Path(sys.argv[2])
+    board = json.loads(board_path.read_text())
+
+    errors, warnings = validate(board)
+    for warning in warnings:
+        print(f"{board_path}: warning: {warning}", file=sys.stderr)
+    for error in errors:
+        print(f"{board_path}: error: {error}", file=sys.stderr)
+    if errors:
+        return 1
+
+    out_dir.mkdir(parents=True, exist_ok=True)
+    generate(board, out_dir / "board_config.h", out_dir / "board_config.c")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,77 @@
+#include <math.h>
+
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "dht.h"
+
+#include "drivers.h"
+
+esp_err_t adc_sensor_init(void *ctx)
+{
+    adc_sensor_t *adc = ctx;
+    esp_err_t err = adc1_config_width(ADC_WIDTH_BIT_12);  // 0–4095
+    if (err == ESP_OK) {
+        err = adc1_config_channel_atten(adc->channel, ADC_ATTEN_DB_11);  // 0–3.3V range
+    }
+    return err;
+}
+
+size_t adc_sensor_read(void *ctx, uint8_t first_channel, sample_t *out, size_t max)
+{
+    adc_sensor_t *adc = ctx;
+    int raw = adc1_get_raw(adc->channel);
+
+    out[0].channel = first_channel;
+    out[0].value = raw;
+    out[0].flags = raw < 0 ? SAMPLE_FLAG_ERROR : 0;
+    return 1;
+}
+
+size_t dht_sensor_read(void *ctx, uint8_t first_channel, sample_t *out, size_t max)
+{
+    dht_sensor_t *dht = ctx;
+    float humidity = 0.0f, temperature = 0.0f;
+    if (max < 2) {
+        return 0;
+    }
+
+    esp_err_t result = dht_read_float_data(DHT_TYPE_DHT11, dht->gpio, &humidity, &temperature);
+    uint8_t flags = result == ESP_OK ? 0 : SAMPLE_FLAG_ERROR;
+
+    out[0].channel = first_channel;
+    out[0].value = lroundf(temperature * 1000);
+    out[0].flags = flags;
+    out[1].channel = first_channel + 1;
+    out[1].value = lroundf(humidity * 1000);
+    out[1].flags = flags;
+    return 2;
+}
+
+esp_err_t button_sensor_init(void *ctx)
+{
+    button_sensor_t *button = ctx;
+    gpio_reset_pin(button->gpio);
+    return gpio_set_direction(button->gpio, GPIO_MODE_INPUT);
+}
+
+size_t button_sensor_read(void *ctx, uint8_t first_channel, sample_t *out, size_t max)
+{
+    button_sensor_t *button = ctx;
+
+    out[0].channel = first_channel;
+    out[0].value = gpio_get_level(button->gpio);  // 1 = pressed, as in Lesson 3
+    out[0].flags = 0;
+    return 1;
+}
+
+size_t sim_sensor_read(void *ctx, uint8_t first_channel, sample_t *out, size_t max)
+{
+    sim_sensor_t *sim = ctx;
+    float phase = (float)(esp_timer_get_time() / 1000 % sim->period_ms) / sim->period_ms;
+    int32_t noise = sim->noise ? (int32_t)(esp_random() % (sim->noise + 1)) - sim->noise / 2 : 0;
+
+    out[0].channel = first_channel;
+    out[0].value = sim->offset + lroundf(sim->amplitude * sinf(2 * (float)M_PI * phase)) + noise;
+    out[0].flags = 0;
+    return 1;
+}
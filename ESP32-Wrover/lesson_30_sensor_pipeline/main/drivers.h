@@ -0,0 +1,42 @@
+#pragma once
+
+#include "driver/adc.h"
+#include "driver/gpio.h"
+
+#include "pipeline.h"
+
+// Drivers for the sensors of the earlier lessons. Each one pairs with a
+// context struct that is passed as sensor_driver_t.ctx.
+
+// Lesson 5: raw 12-bit ADC code, one channel
+typedef struct {
+    adc1_channel_t channel;
+} adc_sensor_t;
+
+esp_err_t adc_sensor_init(void *ctx);
+size_t adc_sensor_read(void *ctx, uint8_t first_channel, sample_t *out, size_t max);
+
+// Lesson 10: DHT11, two channels: temperature (m°C) then humidity (m%RH)
+typedef struct {
+    gpio_num_t gpio;
+} dht_sensor_t;
+
+size_t dht_sensor_read(void *ctx, uint8_t first_channel, sample_t *out, size_t max);
+
+// Lesson 3: button level, 1 = pressed
+typedef struct {
+    gpio_num_t gpio;
+} button_sensor_t;
+
+esp_err_t button_sensor_init(void *ctx);
+size_t button_sensor_read(void *ctx, uint8_t first_channel, sample_t *out, size_t max);
+
+// Simulated sensor: a sine wave plus noise, for trying the pipeline without hardware
+typedef struct {
+    int32_t offset;
+    int32_t amplitude;
+    uint32_t period_ms;
+    int32_t noise;        // Peak-to-peak noise added to every sample
+} sim_sensor_t;
+
+size_t sim_sensor_read(void *ctx, uint8_t first_channel, sample_t *out, size_t max);
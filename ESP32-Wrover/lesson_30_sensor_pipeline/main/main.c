@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/uart.h"
+#include "esp_timer.h"
+
+#include "pipeline.h"
+#include "drivers.h"
+#include "stages.h"
+
+#define RUN_BENCHMARK 0         // 1 = measure pipeline throughput with injected samples instead
+
+#define ADC_PIN    ADC1_CHANNEL_6   // GPIO34, as in Lesson 5
+#define DHT_GPIO   GPIO_NUM_4       // As in Lesson 10
+#define BUTTON_PIN GPIO_NUM_0       // As in Lesson 3
+
+#define UART_PORT UART_NUM_1        // Binary frames for a PC or another board
+#define TXD_PIN   GPIO_NUM_22
+#define RXD_PIN   GPIO_NUM_23
+
+#define STATS_PERIOD_MS 10000
+#define BENCH_SAMPLES   100000
+
+// Channel numbers used by the drivers and stages below
+enum {
+    CH_LIGHT,
+    CH_TEMPERATURE,
+    CH_HUMIDITY,
+    CH_BUTTON,
+    CH_SIM,
+    CH_COUNT
+};
+
+static const char *const channel_names[CH_COUNT] = {
+    [CH_LIGHT]       = "light_mV",
+    [CH_TEMPERATURE] = "temp_mC",
+    [CH_HUMIDITY]    = "humidity_m%",
+    [CH_BUTTON]      = "button",
+    [CH_SIM]         = "sim",
+};
+
+// ---- Drivers: what to read, and how often ----
+
+static adc_sensor_t light = { .channel = ADC_PIN };
+static dht_sensor_t dht = { .gpio = DHT_GPIO };
+static button_sensor_t button = { .gpio = BUTTON_PIN };
+static sim_sensor_t sim = { .offset = 1000, .amplitude = 500, .period_ms = 5000, .noise = 40 };
+
+static const sensor_driver_t drivers[] = {
+    { .name = "adc",    .first_channel = CH_LIGHT,       .period_ms = 20,
+      .init = adc_sensor_init,    .read = adc_sensor_read,    .ctx = &light },
+    { .name = "dht11",  .first_channel = CH_TEMPERATURE, .period_ms = 2000,
+      .read = dht_sensor_read,    .ctx = &dht },
+    { .name = "button", .first_channel = CH_BUTTON,      .period_ms = 50,
+      .init = button_sensor_init, .read = button_sensor_read, .ctx = &button },
+    { .name = "sim",    .first_channel = CH_SIM,         .period_ms = 100,
+      .read = sim_sensor_read,    .ctx = &sim },
+};
+
+// ---- Stages: smooth the ADC and the simulated sensor, thin the ADC to 2 Hz,
+//      keep only button changes, convert to mV ----
+
+static ema_filter_t smoothing = {
+    .channel_mask = CHANNEL_BIT(CH_LIGHT) | CHANNEL_BIT(CH_SIM),
+    .shift = 3,
+};
+
+// Per channel: thinning the 20 Hz button as well would lose short presses
+static decimator_t thinning = {
+    .factor = { [CH_LIGHT] = 25 },      // 50 Hz -> 2 Hz
+};
+
+// The button is sampled at its full 20 Hz, but only presses and releases go on
+static change_filter_t button_edges = {
+    .channel_mask = CHANNEL_BIT(CH_BUTTON),
+};
+
+static calibration_t to_units = {
+    .mul = { [CH_LIGHT] = 3300 },
+    .div = { [CH_LIGHT] = 4095 },   // 12-bit code -> mV (approximate, see Lesson 31)
+};
+
+static uart_port_t frame_port = UART_PORT;
+
+static void init_uart(void)
+{
+    uart_config_t uart_config = {
+        .baud_rate = 115200,
+        .data_bits = UART_DATA_8_BITS,
+        .parity    = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE
+    };
+
+    uart_param_config(UART_PORT, &uart_config);
+    uart_set_pin(UART_PORT, TXD_PIN, RXD_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    uart_driver_install(UART_PORT, 1024, 2048, 0, NULL, 0);
+}
+
+static void print_stats(void)
+{
+    pipeline_stats_t stats;
+    pipeline_get_stats(&stats);
+    printf("Pipeline: %lu produced, %lu dropped, %lu delivered in %lu batches, "
+           "latency avg %lu us / max %lu us, queue peak %lu/%d\n",
+           (unsigned long)stats.produced, (unsigned long)stats.dropped,
+           (unsigned long)stats.delivered, (unsigned long)stats.batches,
+           (unsigned long)stats.avg_latency_us, (unsigned long)stats.max_latency_us,
+           (unsigned long)stats.max_queue_depth, PIPELINE_RING_SIZE);
+}
+
+#if RUN_BENCHMARK
+
+// Pushes BENCH_SAMPLES simulated samples through filter + calibration into a
+// sink that only counts them, so the result is the cost of the pipeline itself
+static void run_benchmark(void)
+{
+    static uint32_t counted;
+    static sample_t block[PIPELINE_BATCH_SIZE];
+
+    ESP_ERROR_CHECK(pipeline_add_stage(ema_filter_stage, &smoothing));
+    ESP_ERROR_CHECK(pipeline_add_stage(calibration_stage, &to_units));
+    ESP_ERROR_CHECK(pipeline_add_sink(counting_sink, &counted));
+    ESP_ERROR_CHECK(pipeline_start());
+
+    int64_t start = esp_timer_get_time();
+    uint32_t sent = 0;
+    while (sent < BENCH_SAMPLES) {
+        size_t n = 0;
+        int64_t now = esp_timer_get_time();
+        while (n < PIPELINE_BATCH_SIZE && sent + n < BENCH_SAMPLES) {
+            block[n].timestamp_us = now;
+            sim_sensor_read(&sim, n % 2 ? CH_SIM : CH_LIGHT, &block[n], 1);
+            n++;
+        }
+        size_t pushed = 0;
+        while (pushed < n) {
+            pushed += pipeline_inject(&block[pushed], n - pushed);
+            if (pushed < n) {
+                vTaskDelay(1);  // Queue full: let the processing task catch up
+            }
+        }
+        sent += n;
+    }
+    pipeline_stats_t stats;
+    do {
+        vTaskDelay(1);
+        pipeline_get_stats(&stats);
+    } while (stats.delivered < BENCH_SAMPLES);
+    int64_t elapsed_us = esp_timer_get_time() - start;
+
+    printf("Benchmark: %d samples in %lld ms = %lld samples/s, batch size %d\n",
+           BENCH_SAMPLES, elapsed_us / 1000, (int64_t)BENCH_SAMPLES * 1000000 / elapsed_us,
+           PIPELINE_BATCH_SIZE);
+    print_stats();
+}
+
+#endif
+
+void app_main(void)
+{
+#if RUN_BENCHMARK
+    run_benchmark();
+#else
+    init_uart();
+
+    for (size_t i = 0; i < sizeof(drivers) / sizeof(drivers[0]); i++) {
+        ESP_ERROR_CHECK(pipeline_register_driver(&drivers[i]));
+    }
+    ESP_ERROR_CHECK(pipeline_add_stage(ema_filter_stage, &smoothing));
+    ESP_ERROR_CHECK(pipeline_add_stage(decimator_stage, &thinning));
+    ESP_ERROR_CHECK(pipeline_add_stage(change_filter_stage, &button_edges));
+    ESP_ERROR_CHECK(pipeline_add_stage(calibration_stage, &to_units));
+    ESP_ERROR_CHECK(pipeline_add_sink(console_sink, (void *)channel_names));
+    ESP_ERROR_CHECK(pipeline_add_sink(uart_frame_sink, &frame_port));
+    ESP_ERROR_CHECK(pipeline_start());
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(STATS_PERIOD_MS));
+        print_stats();
+    }
+#endif
+}
@@ -0,0 +1,249 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "pipeline.h"
+#include "sample_ring.h"
+
+#define DRIVER_MAX_SAMPLES 4    // Most a single read() may return
+
+static const char *TAG = "pipeline";
+
+static const sensor_driver_t *drivers[PIPELINE_MAX_DRIVERS];
+static size_t driver_count;
+
+static struct {
+    pipeline_stage_fn fn;
+    void *ctx;
+} stages[PIPELINE_MAX_STAGES];
+static size_t stage_count;
+
+static struct {
+    pipeline_sink_fn fn;
+    void *ctx;
+} sinks[PIPELINE_MAX_SINKS];
+static size_t sink_count;
+
+static sample_ring_t ring;
+static TaskHandle_t process_handle;
+static bool started;
+
+// Producer-side counters are only written by the producer and are 32-bit, so
+// they need no lock
+static volatile uint32_t produced, dropped, max_queue_depth;
+
+// Consumer-side counters, written by the processing task and read or reset by
+// the stats caller. Guarded by stats_lock: the 64-bit sum takes two stores on
+// the Xtensa and could be read half-updated.
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t delivered, batches, max_latency_us;
+static uint64_t latency_sum_us;
+
+esp_err_t pipeline_register_driver(const sensor_driver_t *driver)
+{
+    if (started || driver_count == PIPELINE_MAX_DRIVERS) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (driver->read == NULL || driver->period_ms == 0 || driver->first_channel >= PIPELINE_MAX_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    drivers[driver_count++] = driver;
+    return ESP_OK;
+}
+
+esp_err_t pipeline_add_stage(pipeline_stage_fn fn, void *ctx)
+{
+    if (started || stage_count == PIPELINE_MAX_STAGES) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    stages[stage_count].fn = fn;
+    stages[stage_count].ctx = ctx;
+    stage_count++;
+    return ESP_OK;
+}
+
+esp_err_t pipeline_add_sink(pipeline_sink_fn fn, void *ctx)
+{
+    if (started || sink_count == PIPELINE_MAX_SINKS) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    sinks[sink_count].fn = fn;
+    sinks[sink_count].ctx = ctx;
+    sink_count++;
+    return ESP_OK;
+}
+
+static size_t push_samples(const sample_t *samples, size_t count)
+{
+    size_t pushed = 0;
+    while (pushed < count && sample_ring_push(&ring, &samples[pushed])) {
+        pushed++;
+    }
+    produced += pushed;
+
+    size_t depth = sample_ring_count(&ring);
+    if (depth > max_queue_depth) {
+        max_queue_depth = depth;
+    }
+    // Wake the processing task once a full batch is waiting; partial
+    // batches are picked up by its PIPELINE_MAX_WAIT_MS timeout
+    if (depth >= PIPELINE_BATCH_SIZE) {
+        xTaskNotifyGive(process_handle);
+    }
+    return pushed;
+}
+
+// Runs every stage, then every sink, on one batch
+static void process_batch(sample_t *batch, size_t count)
+{
+    for (size_t i = 0; i < stage_count && count > 0; i++) {
+        count = stages[i].fn(stages[i].ctx, batch, count);
+    }
+    if (count == 0) {
+        return;
+    }
+    for (size_t i = 0; i < sink_count; i++) {
+        sinks[i].fn(sinks[i].ctx, batch, count);
+    }
+
+    int64_t now = esp_timer_get_time();
+    uint64_t sum = 0;
+    uint32_t max = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t latency = now - batch[i].timestamp_us;
+        sum += latency;
+        if (latency > max) {
+            max = latency;
+        }
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    latency_sum_us += sum;
+    if (max > max_latency_us) {
+        max_latency_us = max;
+    }
+    delivered += count;
+    batches++;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+static void process_task(void *arg)
+{
+    static sample_t batch[PIPELINE_BATCH_SIZE];
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PIPELINE_MAX_WAIT_MS));
+
+        size_t count;
+        while ((count = sample_ring_pop(&ring, batch, PIPELINE_BATCH_SIZE)) > 0) {
+            process_batch(batch, count);
+        }
+    }
+}
+
+// One task serves every driver: it reads whichever drivers are due,
+// then sleeps until the next one is
+static void scheduler_task(void *arg)
+{
+    int64_t next_due[PIPELINE_MAX_DRIVERS];
+    sample_t buf[DRIVER_MAX_SAMPLES];
+    const int64_t tick_us = portTICK_PERIOD_MS * 1000;
+
+    int64_t now = esp_timer_get_time();
+    for (size_t i = 0; i < driver_count; i++) {
+        next_due[i] = now;
+    }
+
+    while (1) {
+        int64_t earliest = INT64_MAX;
+        for (size_t i = 0; i < driver_count; i++) {
+            const sensor_driver_t *d = drivers[i];
+            int64_t period_us = (int64_t)d->period_ms * 1000;
+
+            now = esp_timer_get_time();
+            if (now >= next_due[i]) {
+                size_t n = d->read(d->ctx, d->first_channel, buf, DRIVER_MAX_SAMPLES);
+                for (size_t k = 0; k < n; k++) {
+                    buf[k].timestamp_us = now;
+                }
+                dropped += n - push_samples(buf, n);
+
+                next_due[i] += period_us;
+                // After a long stall, skip the missed periods instead of catching up in a burst
+                if (next_due[i] <= now) {
+                    next_due[i] = now + period_us;
+                }
+            }
+            if (next_due[i] < earliest) {
+                earliest = next_due[i];
+            }
+        }
+
+        int64_t wait_us = earliest - esp_timer_get_time();
+        if (wait_us > 0) {
+            vTaskDelay((wait_us + tick_us - 1) / tick_us);
+        }
+    }
+}
+
+esp_err_t pipeline_start(void)
+{
+    if (started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (size_t i = 0; i < driver_count; i++) {
+        const sensor_driver_t *d = drivers[i];
+        if (d->init != NULL) {
+            esp_err_t err = d->init(d->ctx);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Driver %s failed to start: %s", d->name, esp_err_to_name(err));
+                return err;
+            }
+        }
+        ESP_LOGI(TAG, "Driver %s: channel %u, every %lu ms", d->name, d->first_channel,
+                 (unsigned long)d->period_ms);
+    }
+    started = true;
+
+    // The processing task is created first so the scheduler can notify it
+    xTaskCreate(process_task, "pipeline_proc", 4096, NULL, 5, &process_handle);
+    if (driver_count > 0) {
+        xTaskCreate(scheduler_task, "pipeline_sched", 3072, NULL, 6, NULL);
+    }
+    return ESP_OK;
+}
+
+size_t pipeline_inject(const sample_t *samples, size_t count)
+{
+    return push_samples(samples, count);
+}
+
+void pipeline_get_stats(pipeline_stats_t *out)
+{
+    out->produced = produced;
+    out->dropped = dropped;
+    out->max_queue_depth = max_queue_depth;
+
+    portENTER_CRITICAL(&stats_lock);
+    out->delivered = delivered;
+    out->batches = batches;
+    out->avg_latency_us = delivered ? latency_sum_us / delivered : 0;
+    out->max_latency_us = max_latency_us;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void pipeline_reset_stats(void)
+{
+    produced = dropped = max_queue_depth = 0;
+
+    portENTER_CRITICAL(&stats_lock);
+    delivered = batches = max_latency_us = 0;
+    latency_sum_us = 0;
+    portEXIT_CRITICAL(&stats_lock);
+}
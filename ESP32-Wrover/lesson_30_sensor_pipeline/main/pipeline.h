@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define PIPELINE_MAX_DRIVERS   8
+#define PIPELINE_MAX_STAGES    4
+#define PIPELINE_MAX_SINKS     4
+#define PIPELINE_MAX_CHANNELS  16
+#define PIPELINE_BATCH_SIZE    32    // Samples handed to stages and sinks in one call
+#define PIPELINE_RING_SIZE     256   // Must be a power of two
+#define PIPELINE_MAX_WAIT_MS   100   // Flush a partial batch after this long
+
+#define SAMPLE_FLAG_ERROR 0x01       // Driver could not read the sensor; value is meaningless
+
+typedef struct {
+    int64_t timestamp_us;   // When the driver read the sensor (esp_timer_get_time())
+    int32_t value;          // Driver units until a calibration stage converts it
+    uint8_t channel;        // 0 .. PIPELINE_MAX_CHANNELS-1
+    uint8_t flags;
+} sample_t;
+
+// A sensor driver. The scheduler calls read() every period_ms; read() fills
+// up to `max` samples and returns how many it produced. A driver with several
+// outputs (temperature + humidity) uses first_channel, first_channel + 1, ...
+typedef struct {
+    const char *name;
+    uint8_t first_channel;
+    uint32_t period_ms;
+    esp_err_t (*init)(void *ctx);
+    size_t (*read)(void *ctx, uint8_t first_channel, sample_t *out, size_t max);
+    void *ctx;
+} sensor_driver_t;
+
+// A transform stage works in place on a batch and returns the new count,
+// so a stage can drop samples (decimation) but never add them
+typedef size_t (*pipeline_stage_fn)(void *ctx, sample_t *batch, size_t count);
+
+// A sink receives every finished batch, in the order the sinks were added
+typedef void (*pipeline_sink_fn)(void *ctx, const sample_t *batch, size_t count);
+
+typedef struct {
+    uint32_t produced;        // Samples read by drivers (or injected)
+    uint32_t dropped;         // Samples lost because the queue was full
+    uint32_t delivered;       // Samples that reached the sinks after all stages
+    uint32_t batches;
+    uint32_t avg_latency_us;  // From the driver read to the end of the sinks
+    uint32_t max_latency_us;
+    uint32_t max_queue_depth;
+} pipeline_stats_t;
+
+// Registration is only allowed before pipeline_start()
+esp_err_t pipeline_register_driver(const sensor_driver_t *driver);
+esp_err_t pipeline_add_stage(pipeline_stage_fn fn, void *ctx);
+esp_err_t pipeline_add_sink(pipeline_sink_fn fn, void *ctx);
+
+// Initialise every driver and start the scheduler and processing tasks
+esp_err_t pipeline_start(void);
+
+// Push samples as if a driver had read them. Only call this from one task,
+// and not while drivers are registered: the queue has a single producer.
+size_t pipeline_inject(const sample_t *samples, size_t count);
+
+void pipeline_get_stats(pipeline_stats_t *out);
+void pipeline_reset_stats(void);
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pipeline.h"
+
+// Single-producer / single-consumer queue between the scheduler and the
+// processing task. No lock is needed: the producer only writes `head`, the
+// consumer only writes `tail`, and the acquire/release pairs make sure a
+// slot's contents are visible before its index is.
+typedef struct {
+    sample_t items[PIPELINE_RING_SIZE];
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+} sample_ring_t;
+
+_Static_assert((PIPELINE_RING_SIZE & (PIPELINE_RING_SIZE - 1)) == 0,
+               "PIPELINE_RING_SIZE must be a power of two");
+
+static inline size_t sample_ring_count(sample_ring_t *ring)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head - tail;
+}
+
+// Producer side. Returns false when the queue is full.
+static inline bool sample_ring_push(sample_ring_t *ring, const sample_t *sample)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail == PIPELINE_RING_SIZE) {
+        return false;
+    }
+    ring->items[head & (PIPELINE_RING_SIZE - 1)] = *sample;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+// Consumer side. Copies up to `max` samples and frees their slots in one step.
+static inline size_t sample_ring_pop(sample_ring_t *ring, sample_t *out, size_t max)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t count = head - tail;
+    if (count > max) {
+        count = max;
+    }
+    for (size_t i = 0; i < count; i++) {
+        out[i] = ring->items[(tail + i) & (PIPELINE_RING_SIZE - 1)];
+    }
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+    return count;
+}
@@ -0,0 +1,125 @@
+#include <stdio.h>
+
+#include "stages.h"
+
+size_t ema_filter_stage(void *ctx, sample_t *batch, size_t count)
+{
+    ema_filter_t *f = ctx;
+    for (size_t i = 0; i < count; i++) {
+        sample_t *s = &batch[i];
+        if (!(f->channel_mask & CHANNEL_BIT(s->channel)) || (s->flags & SAMPLE_FLAG_ERROR)) {
+            continue;
+        }
+        int32_t x = s->value * 256;
+        if (!f->primed[s->channel]) {
+            // Start from the first reading instead of ramping up from zero
+            f->state[s->channel] = x;
+            f->primed[s->channel] = true;
+        } else {
+            f->state[s->channel] += (x - f->state[s->channel]) >> f->shift;
+        }
+        s->value = (f->state[s->channel] + 128) / 256;
+    }
+    return count;
+}
+
+size_t decimator_stage(void *ctx, sample_t *batch, size_t count)
+{
+    decimator_t *d = ctx;
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t ch = batch[i].channel;
+        if (d->factor[ch] > 1) {
+            uint16_t phase = d->phase[ch];
+            d->phase[ch] = phase + 1 == d->factor[ch] ? 0 : phase + 1;
+            if (phase != 0) {
+                continue;
+            }
+        }
+        // Compact in place; kept <= i, so nothing unread is overwritten
+        batch[kept++] = batch[i];
+    }
+    return kept;
+}
+
+size_t change_filter_stage(void *ctx, sample_t *batch, size_t count)
+{
+    change_filter_t *f = ctx;
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        const sample_t *s = &batch[i];
+        if ((f->channel_mask & CHANNEL_BIT(s->channel)) && !(s->flags & SAMPLE_FLAG_ERROR)) {
+            if (f->seen[s->channel] && f->last[s->channel] == s->value) {
+                continue;
+            }
+            f->last[s->channel] = s->value;
+            f->seen[s->channel] = true;
+        }
+        batch[kept++] = *s;
+    }
+    return kept;
+}
+
+size_t calibration_stage(void *ctx, sample_t *batch, size_t count)
+{
+    calibration_t *c = ctx;
+    for (size_t i = 0; i < count; i++) {
+        sample_t *s = &batch[i];
+        if (c->div[s->channel] != 0) {
+            s->value = (int64_t)s->value * c->mul[s->channel] / c->div[s->channel] + c->offset[s->channel];
+        }
+    }
+    return count;
+}
+
+void console_sink(void *ctx, const sample_t *batch, size_t count)
+{
+    const char *const *names = ctx;
+    for (size_t i = 0; i < count; i++) {
+        const sample_t *s = &batch[i];
+        if (s->flags & SAMPLE_FLAG_ERROR) {
+            printf("%8lld ms  %-12s read error\n", s->timestamp_us / 1000, names[s->channel]);
+        } else {
+            printf("%8lld ms  %-12s %ld\n", s->timestamp_us / 1000, names[s->channel], (long)s->value);
+        }
+    }
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+void uart_frame_sink(void *ctx, const sample_t *batch, size_t count)
+{
+    static uint8_t frame[3 + PIPELINE_BATCH_SIZE * 10 + 1];
+    uart_port_t port = *(const uart_port_t *)ctx;
+
+    size_t len = 0;
+    frame[len++] = 0xA5;
+    frame[len++] = 0x5A;
+    frame[len++] = count;
+    for (size_t i = 0; i < count; i++) {
+        frame[len++] = batch[i].channel;
+        frame[len++] = batch[i].flags;
+        put_le32(&frame[len], batch[i].value);
+        put_le32(&frame[len + 4], batch[i].timestamp_us / 1000);
+        len += 8;
+    }
+    uint8_t checksum = 0;
+    for (size_t i = 2; i < len; i++) {
+        checksum ^= frame[i];
+    }
+    frame[len++] = checksum;
+
+    // One write per batch instead of one per sample
+    uart_write_bytes(port, frame, len);
+}
+
+void counting_sink(void *ctx, const sample_t *batch, size_t count)
+{
+    *(uint32_t *)ctx += count;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "driver/uart.h"
+
+#include "pipeline.h"
+
+#define CHANNEL_BIT(ch) (1u << (ch))
+
+// ---- Transform stages (pipeline_stage_fn) ----
+
+// Exponential moving average on the channels in channel_mask:
+// y += (x - y) / 2^shift. Samples flagged as errors pass through untouched.
+typedef struct {
+    uint32_t channel_mask;
+    uint8_t shift;
+    int32_t state[PIPELINE_MAX_CHANNELS];   // Filter output, scaled by 256
+    bool primed[PIPELINE_MAX_CHANNELS];
+} ema_filter_t;
+
+size_t ema_filter_stage(void *ctx, sample_t *batch, size_t count);
+
+// Keeps one sample out of every factor[ch] on each channel. Channels whose
+// factor is 0 or 1 pass through, so each channel is thinned to its own rate.
+typedef struct {
+    uint16_t factor[PIPELINE_MAX_CHANNELS];
+    uint16_t phase[PIPELINE_MAX_CHANNELS];
+} decimator_t;
+
+size_t decimator_stage(void *ctx, sample_t *batch, size_t count);
+
+// Drops samples on the channels in channel_mask whose value is the same as the
+// last one kept, so on/off channels (a button) only report their changes.
+// Samples flagged as errors are always kept.
+typedef struct {
+    uint32_t channel_mask;
+    int32_t last[PIPELINE_MAX_CHANNELS];
+    bool seen[PIPELINE_MAX_CHANNELS];
+} change_filter_t;
+
+size_t change_filter_stage(void *ctx, sample_t *batch, size_t count);
+
+// Linear conversion to engineering units: value * mul / div + offset.
+// Channels with div == 0 are left as they are.
+typedef struct {
+    int32_t mul[PIPELINE_MAX_CHANNELS];
+    int32_t div[PIPELINE_MAX_CHANNELS];
+    int32_t offset[PIPELINE_MAX_CHANNELS];
+} calibration_t;
+
+size_t calibration_stage(void *ctx, sample_t *batch, size_t count);
+
+// ---- Sinks (pipeline_sink_fn) ----
+
+// One text line per sample on the console; ctx = channel name table
+void console_sink(void *ctx, const sample_t *batch, size_t count);
+
+// One binary frame per batch on a UART; ctx = uart_port_t *
+//   0xA5 0x5A  count  { channel flags value(i32 LE) time_ms(u32 LE) } x count  checksum
+// The checksum is the XOR of every byte between the sync word and itself.
+void uart_frame_sink(void *ctx, const sample_t *batch, size_t count);
+
+// Counts samples and does nothing else; ctx = uint32_t *. Used by the benchmark.
+void counting_sink(void *ctx, const sample_t *batch, size_t count);
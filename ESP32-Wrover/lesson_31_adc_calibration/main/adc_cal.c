@@ -0,0 +1,173 @@
+#include <stdio.h>
+
+#include "esp_log.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "nvs.h"
+
+#include "adc_cal.h"
+
+#define NVS_NAMESPACE "adc_cal"
+#define DEFAULT_VREF_MV 1100
+#define MAX_MV 3900          // Clamp for extrapolated two-point tables
+
+static const char *TAG = "adc_cal";
+
+static void make_key(char *key, size_t size, adc1_channel_t channel, adc_atten_t atten)
+{
+    snprintf(key, size, "c%d_a%d", (int)channel, (int)atten);
+}
+
+static esp_err_t load_two_point(adc1_channel_t channel, adc_atten_t atten, adc_cal_point_t points[2])
+{
+    char key[16];
+    nvs_handle_t nvs;
+    make_key(key, sizeof(key), channel, atten);
+
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    size_t size = 2 * sizeof(adc_cal_point_t);
+    err = nvs_get_blob(nvs, key, points, &size);
+    nvs_close(nvs);
+    if (err == ESP_OK && (size != 2 * sizeof(adc_cal_point_t) ||
+                          points[1].raw <= points[0].raw || points[1].mv <= points[0].mv)) {
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    return err;
+}
+
+// Straight line through the two measured points, extrapolated to both ends
+static void build_from_two_point(adc_cal_t *cal, const adc_cal_point_t points[2])
+{
+    int32_t raw_span = points[1].raw - points[0].raw;
+    int32_t mv_span = points[1].mv - points[0].mv;
+    for (size_t i = 0; i < ADC_CAL_LUT_POINTS; i++) {
+        int32_t step = ((int32_t)(i << ADC_CAL_LUT_SHIFT) - points[0].raw) * mv_span;
+        // Round to nearest, also below the first point where step is negative
+        int32_t mv = points[0].mv + (step + (step < 0 ? -raw_span : raw_span) / 2) / raw_span;
+        cal->lut[i] = mv < 0 ? 0 : mv > MAX_MV ? MAX_MV : mv;
+    }
+    cal->source = ADC_CAL_SOURCE_TWO_POINT;
+}
+
+// Sample the eFuse calibration curve once per table entry. On the ESP32 at
+// 11 dB this curve includes the correction for the non-linear top end.
+static esp_err_t build_from_efuse(adc_cal_t *cal)
+{
+    adc_cali_line_fitting_efuse_val_t efuse;
+    esp_err_t err = adc_cali_scheme_line_fitting_check_efuse(&efuse);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    adc_cali_line_fitting_config_t config = {
+        .unit_id = ADC_UNIT_1,
+        .atten = cal->atten,
+        .bitwidth = ADC_BITWIDTH_12,
+        .default_vref = DEFAULT_VREF_MV,   // Used only when nothing is burnt in eFuse
+    };
+    adc_cali_handle_t handle;
+    err = adc_cali_create_scheme_line_fitting(&config, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    for (size_t i = 0; i < ADC_CAL_LUT_POINTS - 1 && err == ESP_OK; i++) {
+        int mv;
+        err = adc_cali_raw_to_voltage(handle, i << ADC_CAL_LUT_SHIFT, &mv);
+        cal->lut[i] = mv;
+    }
+    // Code 4096 does not exist: continue the last segment through code 4095, so that
+    // interpolating at 4095 gives the curve's value there
+    int top;
+    if (err == ESP_OK) {
+        err = adc_cali_raw_to_voltage(handle, 4095, &top);
+        int32_t last = cal->lut[ADC_CAL_LUT_POINTS - 2];
+        int32_t codes = 4095 - ((ADC_CAL_LUT_POINTS - 2) << ADC_CAL_LUT_SHIFT);
+        cal->lut[ADC_CAL_LUT_POINTS - 1] = last + ((top - last) * (1 << ADC_CAL_LUT_SHIFT) + codes / 2) / codes;
+    }
+    adc_cali_delete_scheme_line_fitting(handle);
+
+    cal->source = efuse == ADC_CALI_LINE_FITTING_EFUSE_VAL_EFUSE_TP   ? ADC_CAL_SOURCE_EFUSE_TP :
+                  efuse == ADC_CALI_LINE_FITTING_EFUSE_VAL_EFUSE_VREF ? ADC_CAL_SOURCE_EFUSE_VREF :
+                                                                        ADC_CAL_SOURCE_DEFAULT_VREF;
+    return err;
+}
+
+esp_err_t adc_cal_init(adc_cal_t *cal, adc1_channel_t channel, adc_atten_t atten)
+{
+    adc_cal_point_t points[2];
+    cal->channel = channel;
+    cal->atten = atten;
+
+    if (load_two_point(channel, atten, points) == ESP_OK) {
+        build_from_two_point(cal, points);
+    } else {
+        esp_err_t err = build_from_efuse(cal);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "No calibration for channel %d: %s", (int)channel, esp_err_to_name(err));
+            return err;
+        }
+    }
+    ESP_LOGI(TAG, "Channel %d, atten %d: %s, %u..%u mV", (int)channel, (int)atten,
+             adc_cal_source_name(cal->source), cal->lut[0], cal->lut[ADC_CAL_LUT_POINTS - 1]);
+    return ESP_OK;
+}
+
+esp_err_t adc_cal_save_two_point(adc1_channel_t channel, adc_atten_t atten, const adc_cal_point_t points[2])
+{
+    if (points[1].raw <= points[0].raw || points[1].mv <= points[0].mv) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    char key[16];
+    nvs_handle_t nvs;
+    make_key(key, sizeof(key), channel, atten);
+
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_set_blob(nvs, key, points, 2 * sizeof(adc_cal_point_t));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return err;
+}
+
+esp_err_t adc_cal_erase_two_point(adc1_channel_t channel, adc_atten_t atten)
+{
+    char key[16];
+    nvs_handle_t nvs;
+    make_key(key, sizeof(key), channel, atten);
+
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_erase_key(nvs, key);
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return err == ESP_ERR_NVS_NOT_FOUND ? ESP_OK : err;
+}
+
+const char *adc_cal_source_name(adc_cal_source_t source)
+{
+    switch (source) {
+    case ADC_CAL_SOURCE_TWO_POINT:    return "two-point (NVS)";
+    case ADC_CAL_SOURCE_EFUSE_TP:     return "eFuse two-point";
+    case ADC_CAL_SOURCE_EFUSE_VREF:   return "eFuse Vref";
+    case ADC_CAL_SOURCE_DEFAULT_VREF: return "default Vref";
+    default:                          return "?";
+    }
+}
+
+void adc_cal_convert_block(const adc_cal_t *cal, const uint16_t *raw, uint16_t *mv, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        mv[i] = adc_cal_raw_to_mv(cal, raw[i] & 0x0FFF);
+    }
+}
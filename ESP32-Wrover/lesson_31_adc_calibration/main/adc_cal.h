@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "driver/adc.h"
+
+#define ADC_CAL_LUT_SHIFT  4                                    // One table entry every 16 codes
+#define ADC_CAL_LUT_POINTS ((4096 >> ADC_CAL_LUT_SHIFT) + 1)    // 257 entries, 514 bytes per table
+
+typedef enum {
+    ADC_CAL_SOURCE_TWO_POINT,     // User calibration from NVS
+    ADC_CAL_SOURCE_EFUSE_TP,      // Factory two-point values in eFuse
+    ADC_CAL_SOURCE_EFUSE_VREF,    // Factory Vref in eFuse
+    ADC_CAL_SOURCE_DEFAULT_VREF,  // Nothing burnt in eFuse: nominal 1100 mV Vref
+} adc_cal_source_t;
+
+// A known input voltage and the raw code measured for it
+typedef struct {
+    uint16_t raw;
+    uint16_t mv;
+} adc_cal_point_t;
+
+// Voltage lookup table for one ADC1 channel at one attenuation
+typedef struct {
+    adc1_channel_t channel;
+    adc_atten_t atten;
+    adc_cal_source_t source;
+    uint16_t lut[ADC_CAL_LUT_POINTS];   // lut[i] = millivolts at code i << ADC_CAL_LUT_SHIFT (the
+                                        // last entry, code 4096, is extrapolated)
+} adc_cal_t;
+
+// Build the table once at boot: from a two-point calibration in NVS if one
+// was saved for this channel and attenuation, otherwise from the eFuse curve.
+// nvs_flash_init() must have been called.
+esp_err_t adc_cal_init(adc_cal_t *cal, adc1_channel_t channel, adc_atten_t atten);
+
+// Store / remove a user two-point calibration; takes effect at the next adc_cal_init()
+esp_err_t adc_cal_save_two_point(adc1_channel_t channel, adc_atten_t atten, const adc_cal_point_t points[2]);
+esp_err_t adc_cal_erase_two_point(adc1_channel_t channel, adc_atten_t atten);
+
+const char *adc_cal_source_name(adc_cal_source_t source);
+
+// Table lookup with linear interpolation between entries, rounded to the nearest millivolt
+static inline uint32_t adc_cal_raw_to_mv(const adc_cal_t *cal, uint32_t raw)
+{
+    uint32_t index = raw >> ADC_CAL_LUT_SHIFT;
+    uint32_t frac = raw & ((1 << ADC_CAL_LUT_SHIFT) - 1);
+    int32_t lo = cal->lut[index];
+    int32_t hi = cal->lut[index + 1];
+    return lo + (((hi - lo) * (int32_t)frac + (1 << (ADC_CAL_LUT_SHIFT - 1))) >> ADC_CAL_LUT_SHIFT);
+}
+
+// Convert a whole block of raw codes (0–4095) to millivolts; raw and mv may be the same array
+void adc_cal_convert_block(const adc_cal_t *cal, const uint16_t *raw, uint16_t *mv, size_t count);
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/adc.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "nvs_flash.h"
+
+#include "adc_cal.h"
+
+#define BOOT_BUTTON GPIO_NUM_0      // Hold at reset to run the two-point calibration
+
+// Reference voltages for the two-point calibration. Build them with a
+// potentiometer or divider, measure with a multimeter, and enter the readings here.
+#define CAL_LOW_MV  300
+#define CAL_HIGH_MV 2800
+
+#define BLOCK_SIZE 64               // Samples read and converted together
+#define BENCH_SAMPLES 4096
+
+typedef struct {
+    const char *name;
+    adc1_channel_t channel;
+    adc_atten_t atten;
+    adc_cal_t cal;
+} input_t;
+
+// ADC_ATTEN_DB_12 is the new name of Lesson 5's ADC_ATTEN_DB_11 (0–3.3V range)
+static input_t inputs[] = {
+    { .name = "GPIO34", .channel = ADC1_CHANNEL_6, .atten = ADC_ATTEN_DB_12 },
+    { .name = "GPIO35", .channel = ADC1_CHANNEL_7, .atten = ADC_ATTEN_DB_6 },   // 0–1.75V range
+};
+#define INPUT_COUNT (sizeof(inputs) / sizeof(inputs[0]))
+
+static uint16_t raw_block[BENCH_SAMPLES];
+static uint16_t mv_block[BENCH_SAMPLES];
+
+static void read_block(const input_t *in, uint16_t *raw, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        raw[i] = adc1_get_raw(in->channel);
+    }
+}
+
+static uint16_t average(const uint16_t *values, size_t count)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    return (sum + count / 2) / count;
+}
+
+static void wait_for_button(void)
+{
+    while (gpio_get_level(BOOT_BUTTON) == 1) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    while (gpio_get_level(BOOT_BUTTON) == 0) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+}
+
+// Measure two known voltages on the first input and store them in NVS
+static void run_two_point_calibration(input_t *in)
+{
+    adc_cal_point_t points[2] = {
+        { .mv = CAL_LOW_MV },
+        { .mv = CAL_HIGH_MV },
+    };
+
+    while (gpio_get_level(BOOT_BUTTON) == 0) {
+        vTaskDelay(pdMS_TO_TICKS(20));   // Wait until the button from reset is released
+    }
+    for (int i = 0; i < 2; i++) {
+        printf("Apply %u mV to %s and press BOOT\n", points[i].mv, in->name);
+        wait_for_button();
+        read_block(in, raw_block, BLOCK_SIZE);
+        points[i].raw = average(raw_block, BLOCK_SIZE);
+        printf("  %u mV -> raw %u\n", points[i].mv, points[i].raw);
+    }
+
+    esp_err_t err = adc_cal_save_two_point(in->channel, in->atten, points);
+    printf("Calibration %s\n", err == ESP_OK ? "saved" : esp_err_to_name(err));
+}
+
+// The per-sample eFuse conversion that the tables replace
+static esp_err_t create_reference(const input_t *in, adc_cali_handle_t *handle)
+{
+    adc_cali_line_fitting_config_t config = {
+        .unit_id = ADC_UNIT_1,
+        .atten = in->atten,
+        .bitwidth = ADC_BITWIDTH_12,
+        .default_vref = 1100,
+    };
+    return adc_cali_create_scheme_line_fitting(&config, handle);
+}
+
+// Compare the table with the eFuse curve at every code
+static void check_accuracy(const input_t *in)
+{
+    adc_cali_handle_t handle;
+    if (create_reference(in, &handle) != ESP_OK) {
+        return;
+    }
+
+    int max_error = 0, worst_raw = 0;
+    for (int raw = 0; raw < 4096; raw++) {
+        int reference;
+        adc_cali_raw_to_voltage(handle, raw, &reference);
+        int error = abs((int)adc_cal_raw_to_mv(&in->cal, raw) - reference);
+        if (error > max_error) {
+            max_error = error;
+            worst_raw = raw;
+        }
+    }
+    adc_cali_delete_scheme_line_fitting(handle);
+
+    printf("%s: table vs eFuse curve, max error %d mV at raw %d%s\n", in->name, max_error, worst_raw,
+           in->cal.source == ADC_CAL_SOURCE_TWO_POINT ? " (two-point calibration in use)" : "");
+}
+
+// Time the eFuse API per sample against the table on a whole block
+static void benchmark(const input_t *in)
+{
+    adc_cali_handle_t handle;
+    if (create_reference(in, &handle) != ESP_OK) {
+        return;
+    }
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        raw_block[i] = (i * 2654435761u) >> 20;   // Spread over the whole 0–4095 range
+    }
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        int mv;
+        adc_cali_raw_to_voltage(handle, raw_block[i], &mv);
+        mv_block[i] = mv;
+    }
+    int64_t api_us = esp_timer_get_time() - start;
+    adc_cali_delete_scheme_line_fitting(handle);
+
+    start = esp_timer_get_time();
+    adc_cal_convert_block(&in->cal, raw_block, mv_block, BENCH_SAMPLES);
+    int64_t lut_us = esp_timer_get_time() - start;
+
+    printf("Conversion cost: adc_cali_raw_to_voltage() %lld ns/sample, lookup table %lld ns/sample\n",
+           api_us * 1000 / BENCH_SAMPLES, lut_us * 1000 / BENCH_SAMPLES);
+}
+
+void app_main(void)
+{
+    ESP_ERROR_CHECK(nvs_flash_init());
+
+    gpio_reset_pin(BOOT_BUTTON);
+    gpio_set_direction(BOOT_BUTTON, GPIO_MODE_INPUT);
+    gpio_set_pull_mode(BOOT_BUTTON, GPIO_PULLUP_ONLY);   // Pressed = 0
+
+    adc1_config_width(ADC_WIDTH_BIT_12);  // 12-bit resolution (0–4095)
+    for (size_t i = 0; i < INPUT_COUNT; i++) {
+        adc1_config_channel_atten(inputs[i].channel, inputs[i].atten);
+    }
+
+    if (gpio_get_level(BOOT_BUTTON) == 0) {
+        run_two_point_calibration(&inputs[0]);
+    }
+
+    // Build every table once; from here on a conversion is a lookup
+    for (size_t i = 0; i < INPUT_COUNT; i++) {
+        ESP_ERROR_CHECK(adc_cal_init(&inputs[i].cal, inputs[i].channel, inputs[i].atten));
+        check_accuracy(&inputs[i]);
+    }
+    benchmark(&inputs[0]);
+
+    while (1) {
+        for (size_t i = 0; i < INPUT_COUNT; i++) {
+            read_block(&inputs[i], raw_block, BLOCK_SIZE);
+            adc_cal_convert_block(&inputs[i].cal, raw_block, mv_block, BLOCK_SIZE);
+            printf("%s: raw %4u  ->  %4u mV\n", inputs[i].name,
+                   average(raw_block, BLOCK_SIZE), average(mv_block, BLOCK_SIZE));
+        }
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
@@ -0,0 +1,113 @@
+#include "fft_q15.h"
+
+// Q15 product with rounding
+static inline int32_t mul_q15(int32_t a, int32_t b)
+{
+    return (a * b + (1 << 14)) >> 15;
+}
+
+static void bit_reverse(int16_t *buf, size_t n)
+{
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j |= bit;
+        if (i < j) {
+            int16_t re = buf[2 * i], im = buf[2 * i + 1];
+            buf[2 * i] = buf[2 * j];
+            buf[2 * i + 1] = buf[2 * j + 1];
+            buf[2 * j] = re;
+            buf[2 * j + 1] = im;
+        }
+    }
+}
+
+void fft_q15_complex(int16_t *buf, size_t n)
+{
+    bit_reverse(buf, n);
+
+    // Radix-2 decimation in time. The twiddle is loaded once per k and
+    // reused for every butterfly of the stage that needs it.
+    for (size_t len = 2; len <= n; len <<= 1) {
+        size_t half = len / 2;
+        size_t step = FFT_MAX_POINTS / len;     // W_len^k = W_max^(k * step)
+        for (size_t k = 0; k < half; k++) {
+            int32_t wr = fft_twiddles_q15[2 * k * step];
+            int32_t wi = fft_twiddles_q15[2 * k * step + 1];
+            for (size_t start = k; start < n; start += len) {
+                int16_t *a = &buf[2 * start];
+                int16_t *b = &buf[2 * (start + half)];
+                int32_t tr = mul_q15(b[0], wr) - mul_q15(b[1], wi);
+                int32_t ti = mul_q15(b[0], wi) + mul_q15(b[1], wr);
+                int32_t ar = a[0], ai = a[1];
+                a[0] = (ar + tr) >> 1;
+                a[1] = (ai + ti) >> 1;
+                b[0] = (ar - tr) >> 1;
+                b[1] = (ai - ti) >> 1;
+            }
+        }
+    }
+}
+
+void fft_q15_real(int16_t *buf, size_t n)
+{
+    size_t m = n / 2;
+    size_t step = FFT_MAX_POINTS / n;           // W_n^k = W_max^(k * step)
+
+    // Even samples become the real parts, odd samples the imaginary parts
+    fft_q15_complex(buf, m);
+
+    // Split the packed result Z into the spectrum X of the real input:
+    //   Fe = (Z[k] + conj(Z[m-k])) / 2,  Fo = -i (Z[k] - conj(Z[m-k])) / 2
+    //   X[k] = Fe + W^k Fo,  X[m-k] = conj(Fe - W^k Fo)
+    int32_t zr = buf[0], zi = buf[1];
+    buf[0] = (zr + zi) >> 1;
+    buf[1] = (zr - zi) >> 1;
+
+    for (size_t k = 1; k <= m / 2; k++) {
+        size_t j = m - k;
+        // a = Z[k], b = conj(Z[m-k])
+        int32_t ar = buf[2 * k], ai = buf[2 * k + 1];
+        int32_t br = buf[2 * j], bi = -buf[2 * j + 1];
+
+        int32_t even_r = (ar + br) >> 1, even_i = (ai + bi) >> 1;
+        int32_t odd_r = (ai - bi) >> 1, odd_i = (br - ar) >> 1;
+
+        int32_t wr = fft_twiddles_q15[2 * k * step];
+        int32_t wi = fft_twiddles_q15[2 * k * step + 1];
+        int32_t tr = mul_q15(odd_r, wr) - mul_q15(odd_i, wi);
+        int32_t ti = mul_q15(odd_r, wi) + mul_q15(odd_i, wr);
+
+        buf[2 * k] = (even_r + tr) >> 1;
+        buf[2 * k + 1] = (even_i + ti) >> 1;
+        if (j != k) {
+            buf[2 * j] = (even_r - tr) >> 1;
+            buf[2 * j + 1] = (ti - even_i) >> 1;
+        }
+    }
+}
+
+void fft_q15_window_hann(int16_t *buf, size_t n)
+{
+    size_t step = FFT_MAX_POINTS / n;
+
+    // w[i] = (1 - cos(2*pi*i/n)) / 2 is symmetric, so each cosine serves i and n-i
+    buf[0] = 0;
+    for (size_t i = 1; i < n / 2; i++) {
+        int32_t w = (32768 - fft_twiddles_q15[2 * i * step]) >> 1;
+        buf[i] = mul_q15(buf[i], w);
+        buf[n - i] = mul_q15(buf[n - i], w);
+    }
+    // w[n/2] = 1: buf[n/2] stays as it is
+}
+
+void fft_q15_power(const int16_t *spectrum, uint32_t *power, size_t n)
+{
+    power[0] = (int32_t)spectrum[0] * spectrum[0];
+    for (size_t k = 1; k < n / 2; k++) {
+        int32_t re = spectrum[2 * k], im = spectrum[2 * k + 1];
+        power[k] = (uint32_t)(re * re) + (uint32_t)(im * im);
+    }
+}
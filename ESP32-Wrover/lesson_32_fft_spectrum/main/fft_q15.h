@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Largest transform; fft_twiddles.c is generated for this size
+#define FFT_MAX_POINTS 1024
+
+// Q15 twiddle factors, (cos, -sin) pairs of 2*pi*k/FFT_MAX_POINTS, in flash
+extern const int16_t fft_twiddles_q15[FFT_MAX_POINTS];
+
+// In-place complex FFT of n points (power of two, 2..FFT_MAX_POINTS).
+// buf holds n interleaved (re, im) pairs. Every stage halves the values,
+// so the result is DFT / n and cannot overflow.
+void fft_q15_complex(int16_t *buf, size_t n);
+
+// In-place real FFT of n samples (power of two, 4..FFT_MAX_POINTS), using an
+// n/2-point complex FFT. Input samples should stay within ±16384.
+//   Out: buf[0] = X[0] (DC), buf[1] = X[n/2] (Nyquist), both real,
+//        buf[2k], buf[2k+1] = re, im of X[k] for 1 <= k < n/2.
+// Scaled by 1/n like fft_q15_complex().
+void fft_q15_real(int16_t *buf, size_t n);
+
+// Multiply n samples by a Hann window, computed from the twiddle table
+void fft_q15_window_hann(int16_t *buf, size_t n);
+
+// |X[k]|^2 for the n/2 bins 0 .. n/2-1 of a fft_q15_real() result
+void fft_q15_power(const int16_t *spectrum, uint32_t *power, size_t n);
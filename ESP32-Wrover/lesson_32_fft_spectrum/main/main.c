@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "fft_q15.h"
+#include "spectrum.h"
+
+#define ADC_CHANNEL ADC_CHANNEL_6   // GPIO34, as in Lesson 5
+#define SAMPLE_RATE_HZ 20000        // Lowest continuous-mode rate on the ESP32; Nyquist = 10 kHz
+#define FFT_POINTS 1024             // 19.5 Hz per bin, one frame every 51 ms
+#define BINS (FFT_POINTS / 2)
+#define REPORT_PERIOD_MS 1000
+#define PEAK_COUNT 3
+
+#define FRAME_BYTES (FFT_POINTS * SOC_ADC_DIGI_RESULT_BYTES)
+
+// Power of a full-scale sine after conversion (±2048 codes << 2), Hann window and 1/n scaling
+#define FULL_SCALE_POWER (2048.0f * 2048.0f)
+
+static const char *TAG = "spectrum";
+
+static const spectrum_band_t bands[] = {
+    { "hum",    40,   140  },   // 50/60 Hz mains and its second harmonic
+    { "low",    140,  500  },
+    { "mid",    500,  2000 },
+    { "high",   2000, 10000 },
+};
+#define BAND_COUNT (sizeof(bands) / sizeof(bands[0]))
+
+static uint8_t frame[FRAME_BYTES];
+static int16_t samples[FFT_POINTS];
+static uint32_t power[BINS];
+static uint64_t power_sum[BINS];
+
+static float to_dbfs(float power)
+{
+    return power > 0 ? 10.0f * log10f(power / FULL_SCALE_POWER) : -120.0f;
+}
+
+// Raw 12-bit codes -> signed Q15 around zero. Removing the DC offset first
+// keeps bin 0 from swamping the window's leakage into the low bins.
+static void prepare_samples(int16_t *x, size_t n)
+{
+    int32_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += x[i];
+    }
+    int32_t mean = sum / (int32_t)n;
+    for (size_t i = 0; i < n; i++) {
+        x[i] = (x[i] - mean) << 2;     // ±4095 at most -> within ±16384
+    }
+    fft_q15_window_hann(x, n);
+}
+
+// Cycles per transform at 256/512/1024 points, on a two-tone test signal
+static void benchmark(void)
+{
+    for (size_t n = 256; n <= FFT_MAX_POINTS; n *= 2) {
+        uint32_t best_fft = UINT32_MAX, best_total = UINT32_MAX;
+        for (int run = 0; run < 10; run++) {
+            for (size_t i = 0; i < n; i++) {
+                float t = (float)i / SAMPLE_RATE_HZ;
+                samples[i] = 2048 + 1200 * sinf(2 * (float)M_PI * 1000 * t)
+                                  + 300 * sinf(2 * (float)M_PI * 3150 * t);
+            }
+            uint32_t start = esp_cpu_get_cycle_count();
+            prepare_samples(samples, n);
+            uint32_t mid = esp_cpu_get_cycle_count();
+            fft_q15_real(samples, n);
+            fft_q15_power(samples, power, n);
+            uint32_t end = esp_cpu_get_cycle_count();
+
+            if (end - mid < best_fft) {
+                best_fft = end - mid;
+            }
+            if (end - start < best_total) {
+                best_total = end - start;
+            }
+        }
+
+        spectrum_peak_t peaks[2];
+        size_t found = spectrum_find_peaks(power, n / 2, SAMPLE_RATE_HZ, 0, peaks, 2);
+        printf("%4u points: FFT + power %6lu cycles, with DC removal + window %6lu cycles (%lu us); peaks:",
+               (unsigned)n, (unsigned long)best_fft, (unsigned long)best_total,
+               (unsigned long)(best_total / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ));
+        for (size_t i = 0; i < found; i++) {
+            printf(" %.0f Hz", peaks[i].freq_hz);
+        }
+        printf(" (expected 1000, 3150)\n");
+    }
+}
+
+static adc_continuous_handle_t start_adc(void)
+{
+    adc_continuous_handle_t handle;
+    adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = 4 * FRAME_BYTES,
+        .conv_frame_size = FRAME_BYTES,
+    };
+    ESP_ERROR_CHECK(adc_continuous_new_handle(&handle_config, &handle));
+
+    adc_digi_pattern_config_t pattern = {
+        .atten = ADC_ATTEN_DB_12,       // 0–3.3V, as ADC_ATTEN_DB_11 in Lesson 5
+        .channel = ADC_CHANNEL,
+        .unit = ADC_UNIT_1,
+        .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+    };
+    adc_continuous_config_t config = {
+        .sample_freq_hz = SAMPLE_RATE_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+    };
+    ESP_ERROR_CHECK(adc_continuous_config(handle, &config));
+    ESP_ERROR_CHECK(adc_continuous_start(handle));
+    return handle;
+}
+
+// Unpack one DMA frame into samples[]; returns how many belong to our channel
+static size_t unpack_frame(const uint8_t *data, uint32_t length)
+{
+    size_t count = 0;
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length && count < FFT_POINTS;
+         i += SOC_ADC_DIGI_RESULT_BYTES) {
+        const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&data[i];
+        if (p->type1.channel == ADC_CHANNEL) {
+            samples[count++] = p->type1.data;
+        }
+    }
+    return count;
+}
+
+static void report(uint32_t frames)
+{
+    for (size_t k = 0; k < BINS; k++) {
+        power[k] = power_sum[k] / frames;
+    }
+    memset(power_sum, 0, sizeof(power_sum));
+
+    spectrum_peak_t peaks[PEAK_COUNT];
+    size_t found = spectrum_find_peaks(power, BINS, SAMPLE_RATE_HZ, 1, peaks, PEAK_COUNT);
+    printf("Peaks:");
+    for (size_t i = 0; i < found; i++) {
+        printf("  %7.1f Hz %6.1f dBFS", peaks[i].freq_hz, to_dbfs(peaks[i].power));
+    }
+
+    uint64_t energy[BAND_COUNT];
+    spectrum_band_energy(power, BINS, SAMPLE_RATE_HZ, bands, BAND_COUNT, energy);
+    printf("\nBands:");
+    for (size_t b = 0; b < BAND_COUNT; b++) {
+        printf("  %s %.1f dB", bands[b].name, to_dbfs(energy[b]));
+    }
+    printf("   (%lu frames)\n", (unsigned long)frames);
+}
+
+void app_main(void)
+{
+    benchmark();
+
+    adc_continuous_handle_t adc = start_adc();
+    ESP_LOGI(TAG, "Sampling at %d Hz, %d-point FFT, %.1f Hz per bin",
+             SAMPLE_RATE_HZ, FFT_POINTS, (float)SAMPLE_RATE_HZ / FFT_POINTS);
+
+    uint32_t frames = 0;
+    TickType_t last_report = xTaskGetTickCount();
+    while (1) {
+        uint32_t length = 0;
+        esp_err_t err = adc_continuous_read(adc, frame, FRAME_BYTES, &length, 1000);
+        if (err != ESP_OK || unpack_frame(frame, length) < FFT_POINTS) {
+            continue;   // Timeout or a short frame: wait for a complete one
+        }
+
+        prepare_samples(samples, FFT_POINTS);
+        fft_q15_real(samples, FFT_POINTS);
+        fft_q15_power(samples, power, FFT_POINTS);
+        for (size_t k = 0; k < BINS; k++) {
+            power_sum[k] += power[k];
+        }
+        frames++;
+
+        if (xTaskGetTickCount() - last_report >= pdMS_TO_TICKS(REPORT_PERIOD_MS)) {
+            report(frames);
+            frames = 0;
+            last_report = xTaskGetTickCount();
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#include "spectrum.h"
+
+void spectrum_band_energy(const uint32_t *power, size_t bins, uint32_t sample_rate,
+                          const spectrum_band_t *bands, size_t band_count, uint64_t *energy)
+{
+    size_t n = 2 * bins;
+    for (size_t b = 0; b < band_count; b++) {
+        // First and last bin of the band, rounded up: bin k is at k * sample_rate / n
+        size_t first = ((uint64_t)bands[b].low_hz * n + sample_rate - 1) / sample_rate;
+        size_t end = ((uint64_t)bands[b].high_hz * n + sample_rate - 1) / sample_rate;
+        if (end > bins) {
+            end = bins;
+        }
+        energy[b] = 0;
+        for (size_t k = first; k < end; k++) {
+            energy[b] += power[k];
+        }
+    }
+}
+
+size_t spectrum_find_peaks(const uint32_t *power, size_t bins, uint32_t sample_rate,
+                           uint32_t min_power, spectrum_peak_t *peaks, size_t max)
+{
+    size_t found = 0;
+    for (size_t k = 2; k + 1 < bins; k++) {
+        uint32_t p = power[k];
+        if (p < min_power || p <= power[k - 1] || p < power[k + 1]) {
+            continue;
+        }
+
+        // Insertion into the short sorted list, dropping the weakest if full
+        size_t pos = found < max ? found : max;
+        while (pos > 0 && peaks[pos - 1].power < p) {
+            if (pos < max) {
+                peaks[pos] = peaks[pos - 1];
+            }
+            pos--;
+        }
+        if (pos >= max) {
+            continue;
+        }
+        // Fit a parabola through the three bins around the peak
+        float left = power[k - 1], centre = p, right = power[k + 1];
+        float denom = left - 2 * centre + right;
+        float offset = denom != 0 ? 0.5f * (left - right) / denom : 0;
+
+        peaks[pos].freq_hz = (k + offset) * sample_rate / (2.0f * bins);
+        peaks[pos].power = p;
+        if (found < max) {
+            found++;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A frequency band to watch, e.g. mains hum or a motor's bearing frequencies
+typedef struct {
+    const char *name;
+    uint32_t low_hz;      // Inclusive
+    uint32_t high_hz;     // Exclusive
+} spectrum_band_t;
+
+typedef struct {
+    float freq_hz;        // Interpolated between bins
+    uint32_t power;
+} spectrum_peak_t;
+
+// Sum of the power of every bin whose centre lies in each band.
+// power has `bins` entries (n/2 for an n-point FFT), bin k is at k * sample_rate / n.
+void spectrum_band_energy(const uint32_t *power, size_t bins, uint32_t sample_rate,
+                          const spectrum_band_t *bands, size_t band_count, uint64_t *energy);
+
+// The `max` strongest local maxima above min_power, strongest first.
+// Bins 0 and 1 (DC and its window leakage) are skipped. Returns the number found.
+size_t spectrum_find_peaks(const uint32_t *power, size_t bins, uint32_t sample_rate,
+                           uint32_t min_power, spectrum_peak_t *peaks, size_t max);
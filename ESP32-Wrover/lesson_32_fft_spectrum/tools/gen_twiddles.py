@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""Generate main/fft_twiddles.c: the Q15 twiddle table used by fft_q15.c.
+
+Usage: gen_twiddles.py <max_points> <output.c>
+
+The table holds W^k = exp(-2*pi*i*k / max_points) for k = 0 .. max_points/2 - 1
+as interleaved (cos, -sin) pairs. Smaller transforms use every (max_points / n)-th entry.
+"""
+
+import math
+import sys
+
+
+def q15(x):
+    return max(-32768, min(32767, round(x * 32768)))
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__, file=sys.stderr)
+        return 1
+    n = int(sys.argv[1])
+    if n < 4 or n & (n - 1):
+        print("max_points must be a power of two", file=sys.stderr)
+        return 1
+
+    values = []
+    for k in range(n // 2):
+        angle = 2 * math.pi * k / n
+        values += [q15(math.cos(angle)), q15(-math.sin(angle))]
+
+    lines = [
+        "// Generated by tools/gen_twiddles.py %d -- do not edit" % n,
+        "",
+        '#include "fft_q15.h"',
+        "",
+        "_Static_assert(FFT_MAX_POINTS == %d, \"Regenerate with tools/gen_twiddles.py\");" % n,
+        "",
+        "// (cos, -sin) of 2*pi*k/FFT_MAX_POINTS in Q15; const, so it stays in flash",
+        "const int16_t fft_twiddles_q15[FFT_MAX_POINTS] = {",
+    ]
+    for i in range(0, len(values), 8):
+        lines.append("    " + " ".join("%6d," % v for v in values[i:i + 8]))
+    lines.append("};")
+
+    with open(sys.argv[2], "w") as f:
+        f.write("\n".join(lines) + "\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,300 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+#include "commands.h"
+#include "console.h"
+#include "trace.h"
+
+#define MAX_TASKS 24
+
+// ---- tasks: CPU usage and stack headroom ----
+
+static TaskStatus_t before[MAX_TASKS], after[MAX_TASKS];
+
+static const char *state_name(eTaskState state)
+{
+    switch (state) {
+    case eRunning:   return "run";
+    case eReady:     return "ready";
+    case eBlocked:   return "block";
+    case eSuspended: return "susp";
+    default:         return "?";
+    }
+}
+
+// CPU% is measured over a window, so busy tasks show up even if they are idle right now
+static int tasks_cmd(int argc, char **argv)
+{
+    long window_ms = 1000;
+    if (argc > 2 || (argc == 2 && !console_parse_int(argv[1], 10, 10000, &window_ms))) {
+        return CONSOLE_ERR_USAGE;
+    }
+
+    configRUN_TIME_COUNTER_TYPE total_before, total_after;
+    UBaseType_t count_before = uxTaskGetSystemState(before, MAX_TASKS, &total_before);
+    vTaskDelay(pdMS_TO_TICKS(window_ms));
+    UBaseType_t count_after = uxTaskGetSystemState(after, MAX_TASKS, &total_after);
+
+    // The run-time counter is time since boot; each core adds its own share
+    uint32_t capacity = (total_after - total_before) * portNUM_PROCESSORS;
+    if (capacity == 0) {
+        capacity = 1;
+    }
+
+    console_printf("%-16s %-6s %4s %7s %10s\n", "Task", "State", "Prio", "CPU%", "Stack free");
+    for (UBaseType_t i = 0; i < count_after; i++) {
+        const TaskStatus_t *t = &after[i];
+        uint32_t runtime = t->ulRunTimeCounter;
+        for (UBaseType_t j = 0; j < count_before; j++) {
+            if (before[j].xHandle == t->xHandle) {
+                runtime -= before[j].ulRunTimeCounter;
+                break;
+            }
+        }
+        uint32_t tenths = (uint64_t)runtime * 1000 / capacity;
+        console_printf("%-16s %-6s %4u %5lu.%lu %10u\n", t->pcTaskName, state_name(t->eCurrentState),
+                       (unsigned)t->uxCurrentPriority, (unsigned long)(tenths / 10),
+                       (unsigned long)(tenths % 10), (unsigned)t->usStackHighWaterMark);
+    }
+    return CONSOLE_OK;
+}
+
+// ---- heap ----
+
+static int heap_cmd(int argc, char **argv)
+{
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+    console_printf("Free: %u bytes, minimum ever free: %u bytes, largest block: %u bytes\n",
+                   (unsigned)info.total_free_bytes, (unsigned)info.minimum_free_bytes,
+                   (unsigned)info.largest_free_block);
+    console_printf("Allocated: %u blocks, %u bytes; internal free %u, DMA-capable free %u\n",
+                   (unsigned)info.allocated_blocks, (unsigned)info.total_allocated_bytes,
+                   (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+                   (unsigned)heap_caps_get_free_size(MALLOC_CAP_DMA));
+    return CONSOLE_OK;
+}
+
+// ---- bench: micro-benchmarks to compare boards, clock settings and builds ----
+
+static uint8_t bench_src[4096], bench_dst[4096];
+static volatile int32_t bench_sink;    // Keeps the compiler from removing the work
+
+static void bench_memcpy(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        memcpy(bench_dst, bench_src, sizeof(bench_dst));
+        __asm__ volatile("" : : "r"(bench_dst) : "memory");    // bench_dst is never read: keep every copy
+    }
+}
+
+static void bench_int(uint32_t iterations)
+{
+    int32_t acc = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        acc += (int32_t)i * 7 + (acc >> 3);
+    }
+    bench_sink = acc;
+}
+
+static void bench_float(uint32_t iterations)
+{
+    float acc = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        acc += sinf(i * 0.001f);
+    }
+    bench_sink = acc;
+}
+
+static void bench_malloc(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++) {
+        void *p = malloc(64);
+        bench_sink += (p != NULL);
+        free(p);
+    }
+}
+
+static void bench_gpio(uint32_t iterations)
+{
+    int32_t acc = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        acc += gpio_get_level(GPIO_NUM_0);
+    }
+    bench_sink = acc;
+}
+
+static const struct {
+    const char *name;
+    void (*fn)(uint32_t iterations);
+    uint32_t iterations;
+    uint32_t bytes;         // Per iteration, for a throughput figure; 0 = none
+} bench_cases[] = {
+    { "memcpy", bench_memcpy, 256,   sizeof(bench_dst) },
+    { "int",    bench_int,    100000, 0 },
+    { "float",  bench_float,  10000,  0 },
+    { "malloc", bench_malloc, 1000,   0 },
+    { "gpio",   bench_gpio,   10000,  0 },
+};
+#define BENCH_CASE_COUNT (sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+static int bench_cmd(int argc, char **argv)
+{
+    if (argc != 2) {
+        console_printf("Cases:");
+        for (size_t i = 0; i < BENCH_CASE_COUNT; i++) {
+            console_printf(" %s", bench_cases[i].name);
+        }
+        console_printf("\n");
+        return CONSOLE_ERR_USAGE;
+    }
+
+    for (size_t i = 0; i < BENCH_CASE_COUNT; i++) {
+        if (strcmp(argv[1], bench_cases[i].name) != 0) {
+            continue;
+        }
+        uint32_t n = bench_cases[i].iterations;
+        int64_t start_us = esp_timer_get_time();
+        uint32_t start = esp_cpu_get_cycle_count();
+        bench_cases[i].fn(n);
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+        console_printf("%s: %lu iterations in %lld us, %lu cycles/iteration",
+                       bench_cases[i].name, (unsigned long)n, elapsed_us, (unsigned long)(cycles / n));
+        if (bench_cases[i].bytes && elapsed_us > 0) {
+            console_printf(", %lu KB/s",
+                           (unsigned long)((uint64_t)n * bench_cases[i].bytes * 1000000 / 1024 / elapsed_us));
+        }
+        console_printf("\n");
+        return CONSOLE_OK;
+    }
+    console_printf("Unknown case '%s'\n", argv[1]);
+    return CONSOLE_ERR_USAGE;
+}
+
+// ---- trace: record events from tasks and ISRs, print them afterwards ----
+
+static int trace_cmd(int argc, char **argv)
+{
+    if (argc != 2) {
+        return CONSOLE_ERR_USAGE;
+    }
+    if (strcmp(argv[1], "start") == 0) {
+        trace_start();
+        console_printf("Tracing, up to %d events\n", TRACE_CAPACITY);
+        return CONSOLE_OK;
+    }
+    if (strcmp(argv[1], "stop") != 0) {
+        return CONSOLE_ERR_USAGE;
+    }
+
+    trace_stop();
+    trace_entry_t entry, previous = { 0 };
+    size_t count = trace_count();
+    for (size_t i = 0; i < count && trace_get(i, &entry); i++) {
+        uint32_t delta = i ? entry.time_us - previous.time_us : 0;
+        console_printf("%10lu us  %+9ld  %-14s %ld\n", (unsigned long)entry.time_us, (long)delta,
+                       entry.event, (long)entry.arg);
+        previous = entry;
+    }
+    console_printf("%u events, %lu overwritten\n", (unsigned)count, (unsigned long)trace_overwritten());
+    return CONSOLE_OK;
+}
+
+// ---- gpio: read or drive one of the project's pins ----
+
+static const commands_gpio_t *gpio_table;
+static size_t gpio_table_count;
+
+void commands_set_gpio_table(const commands_gpio_t *pins, size_t count)
+{
+    gpio_table = pins;
+    gpio_table_count = count;
+}
+
+static const commands_gpio_t *find_gpio(long pin)
+{
+    for (size_t i = 0; i < gpio_table_count; i++) {
+        if (gpio_table[i].pin == pin) {
+            return &gpio_table[i];
+        }
+    }
+    return NULL;
+}
+
+// Pins that belong to the module itself on the ESP32-WROVER
+static const char *module_pin_user(long pin)
+{
+    if (pin >= 6 && pin <= 11) {
+        return "the SPI flash";
+    }
+    if (pin == 16 || pin == 17) {
+        return "the PSRAM";
+    }
+    return NULL;
+}
+
+static int gpio_cmd(int argc, char **argv)
+{
+    long pin, level;
+    if (argc == 1) {
+        for (size_t i = 0; i < gpio_table_count; i++) {
+            console_printf("GPIO%-2d %-4s %s\n", (int)gpio_table[i].pin,
+                           gpio_table[i].writable ? "r/w" : "r", gpio_table[i].name);
+        }
+        return CONSOLE_OK;
+    }
+    if (argc > 3 || !console_parse_int(argv[1], 0, GPIO_NUM_MAX - 1, &pin) || !GPIO_IS_VALID_GPIO(pin)) {
+        return CONSOLE_ERR_USAGE;
+    }
+    const commands_gpio_t *entry = find_gpio(pin);
+    if (entry == NULL) {
+        const char *user = module_pin_user(pin);
+        if (user) {
+            console_printf("GPIO%ld is used by %s\n", pin, user);
+        } else {
+            console_printf("GPIO%ld is not one of this project's pins, see 'gpio'\n", pin);
+        }
+        return CONSOLE_ERR_FAIL;
+    }
+    if (argc == 2) {
+        console_printf("GPIO%ld (%s) = %d\n", pin, entry->name, gpio_get_level(pin));
+        return CONSOLE_OK;
+    }
+    if (!console_parse_int(argv[2], 0, 1, &level)) {
+        return CONSOLE_ERR_USAGE;
+    }
+    if (!entry->writable || !GPIO_IS_VALID_OUTPUT_GPIO(pin)) {
+        console_printf("GPIO%ld (%s) is read only\n", pin, entry->name);
+        return CONSOLE_ERR_FAIL;
+    }
+    // Input stays enabled so the level can be read back
+    gpio_set_direction(pin, GPIO_MODE_INPUT_OUTPUT);
+    gpio_set_level(pin, level);
+    console_printf("GPIO%ld (%s) = %d\n", pin, entry->name, gpio_get_level(pin));
+    return CONSOLE_OK;
+}
+
+static const console_cmd_t system_commands[] = {
+    { "tasks", "[window_ms]",      "CPU usage and free stack per task",  tasks_cmd },
+    { "heap",  "",                 "Heap usage",                          heap_cmd },
+    { "bench", "<case>",           "Run a micro-benchmark",               bench_cmd },
+    { "trace", "start|stop",       "Record events, print them on stop",   trace_cmd },
+    { "gpio",  "[<pin> [0|1]]",    "List pins, read or drive one",       gpio_cmd },
+};
+
+void commands_register_system(void)
+{
+    for (size_t i = 0; i < sizeof(system_commands) / sizeof(system_commands[0]); i++) {
+        console_register(&system_commands[i]);
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "driver/gpio.h"
+
+// A pin the gpio command may use. Pins that are not in the table are refused,
+// so a typo cannot reconfigure the flash, the PSRAM or the console's own UART.
+typedef struct {
+    gpio_num_t pin;
+    const char *name;       // Shown by "gpio" without arguments
+    bool writable;          // false: read only (inputs, pins driven by a peripheral)
+} commands_gpio_t;
+
+// Registers the built-in diagnostics: tasks, heap, bench, trace, gpio
+void commands_register_system(void);
+
+// The project's pins for the gpio command; the table must stay valid (normally
+// a static const). Until this is called, gpio refuses every pin.
+void commands_set_gpio_table(const commands_gpio_t *pins, size_t count);
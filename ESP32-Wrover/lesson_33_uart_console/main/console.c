@@ -0,0 +1,235 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "console.h"
+
+typedef enum {
+    ESC_NONE,
+    ESC_SEEN,       // Got ESC
+    ESC_CSI,        // Got ESC [ ; skip until the final byte
+} esc_state_t;
+
+static console_write_fn write_out;
+static void *write_ctx;
+
+static const console_cmd_t *commands[CONSOLE_MAX_COMMANDS];
+static size_t command_count;
+
+static char line[CONSOLE_LINE_MAX];
+static size_t line_len;
+static esc_state_t esc_state;
+static bool last_was_cr;
+
+static void write_raw(const char *data, size_t len)
+{
+    if (write_out != NULL && len > 0) {
+        write_out(write_ctx, data, len);
+    }
+}
+
+// Terminals on a raw UART need "\r\n" to return to the first column
+static void write_text(const char *text, size_t len)
+{
+    const char *start = text;
+    for (const char *p = text; p < text + len; p++) {
+        if (*p == '\n') {
+            write_raw(start, p - start);
+            write_raw("\r\n", 2);
+            start = p + 1;
+        }
+    }
+    write_raw(start, text + len - start);
+}
+
+void console_printf(const char *fmt, ...)
+{
+    static char out[256];   // Commands run on the console task only
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(out, sizeof(out), fmt, args);
+    va_end(args);
+    if (len > 0) {
+        write_text(out, len < (int)sizeof(out) ? (size_t)len : sizeof(out) - 1);
+    }
+}
+
+bool console_parse_int(const char *text, long min, long max, long *out)
+{
+    char *end;
+    long value = strtol(text, &end, 0);
+    if (end == text || *end != '\0' || value < min || value > max) {
+        return false;
+    }
+    *out = value;
+    return true;
+}
+
+static int help_cmd(int argc, char **argv)
+{
+    for (size_t i = 0; i < command_count; i++) {
+        char left[40];
+        snprintf(left, sizeof(left), "%s %s", commands[i]->name, commands[i]->usage ? commands[i]->usage : "");
+        console_printf("  %-28s %s\n", left, commands[i]->help);
+    }
+    return CONSOLE_OK;
+}
+
+static const console_cmd_t help = {
+    .name = "help",
+    .help = "List commands",
+    .fn = help_cmd,
+};
+
+void console_init(console_write_fn write, void *ctx)
+{
+    write_out = write;
+    write_ctx = ctx;
+    line_len = 0;
+    esc_state = ESC_NONE;
+    command_count = 0;
+    console_register(&help);
+}
+
+esp_err_t console_register(const console_cmd_t *cmd)
+{
+    if (command_count == CONSOLE_MAX_COMMANDS) {
+        return ESP_ERR_NO_MEM;
+    }
+    commands[command_count++] = cmd;
+    return ESP_OK;
+}
+
+// Split the line in place: separators become '\0', argv points into the line
+static int tokenize(char *text, char **argv)
+{
+    int argc = 0;
+    char *p = text;
+    while (*p) {
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        if (argc == CONSOLE_MAX_ARGS) {
+            return -1;
+        }
+        if (*p == '"') {
+            argv[argc++] = ++p;
+            while (*p && *p != '"') {
+                p++;
+            }
+        } else {
+            argv[argc++] = p;
+            while (*p && *p != ' ' && *p != '\t') {
+                p++;
+            }
+        }
+        if (*p) {
+            *p++ = '\0';
+        }
+    }
+    return argc;
+}
+
+int console_execute(char *text)
+{
+    char *argv[CONSOLE_MAX_ARGS];
+    int argc = tokenize(text, argv);
+    if (argc < 0) {
+        console_printf("Too many arguments (max %d)\n", CONSOLE_MAX_ARGS);
+        return CONSOLE_ERR_USAGE;
+    }
+    if (argc == 0) {
+        return CONSOLE_OK;
+    }
+
+    for (size_t i = 0; i < command_count; i++) {
+        const console_cmd_t *cmd = commands[i];
+        if (strcmp(cmd->name, argv[0]) != 0) {
+            continue;
+        }
+        int result = cmd->fn(argc, argv);
+        if (result == CONSOLE_ERR_USAGE) {
+            console_printf("Usage: %s %s\n", cmd->name, cmd->usage ? cmd->usage : "");
+        } else if (result != CONSOLE_OK) {
+            console_printf("%s failed (%d)\n", cmd->name, result);
+        }
+        return result;
+    }
+    console_printf("Unknown command '%s', try 'help'\n", argv[0]);
+    return CONSOLE_ERR_USAGE;
+}
+
+static void prompt(void)
+{
+    write_raw(CONSOLE_PROMPT, strlen(CONSOLE_PROMPT));
+}
+
+void console_feed(const char *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        char c = data[i];
+        bool after_cr = last_was_cr;
+        last_was_cr = (c == '\r');
+
+        if (esc_state == ESC_SEEN) {
+            esc_state = (c == '[') ? ESC_CSI : ESC_NONE;
+            continue;
+        }
+        if (esc_state == ESC_CSI) {
+            if (c >= 0x40 && c <= 0x7E) {
+                esc_state = ESC_NONE;   // Final byte of the sequence
+            }
+            continue;
+        }
+
+        switch (c) {
+        case 0x1B:
+            esc_state = ESC_SEEN;
+            break;
+        case '\n':
+            if (after_cr) {
+                break;      // Second half of CRLF
+            }
+            // fall through
+        case '\r':
+            write_raw("\r\n", 2);
+            line[line_len] = '\0';
+            line_len = 0;
+            console_execute(line);
+            prompt();
+            break;
+        case 0x08:          // Backspace
+        case 0x7F:          // DEL, sent by most terminals for backspace
+            if (line_len > 0) {
+                line_len--;
+                write_raw("\b \b", 3);
+            }
+            break;
+        case 0x03:          // Ctrl-C: drop the line
+            write_raw("^C\r\n", 4);
+            line_len = 0;
+            prompt();
+            break;
+        case 0x15:          // Ctrl-U: erase the line
+            while (line_len > 0) {
+                line_len--;
+                write_raw("\b \b", 3);
+            }
+            break;
+        default:
+            if (c >= 0x20 && c < 0x7F) {
+                if (line_len < CONSOLE_LINE_MAX - 1) {
+                    line[line_len++] = c;
+                    write_raw(&c, 1);   // Echo
+                } else {
+                    write_raw("\a", 1); // Line full: ring the bell
+                }
+            }
+            break;
+        }
+    }
+}
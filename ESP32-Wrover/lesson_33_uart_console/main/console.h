@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+
+#define CONSOLE_LINE_MAX     128    // Longest command line, including the terminator
+#define CONSOLE_MAX_ARGS     8
+#define CONSOLE_MAX_COMMANDS 24
+#define CONSOLE_PROMPT       "> "
+
+// Return values of a command handler
+#define CONSOLE_OK         0
+#define CONSOLE_ERR_USAGE  (-1)     // The console prints the command's usage line
+#define CONSOLE_ERR_FAIL   (-2)
+
+// argv[0] is the command name; the strings live in the line buffer and are
+// only valid until the handler returns
+typedef int (*console_cmd_fn)(int argc, char **argv);
+
+typedef struct {
+    const char *name;
+    const char *usage;      // Arguments, e.g. "<pin> [0|1]"
+    const char *help;       // One line for "help"
+    console_cmd_fn fn;
+} console_cmd_t;
+
+// Where console output goes (e.g. uart_write_bytes on the console UART)
+typedef void (*console_write_fn)(void *ctx, const char *data, size_t len);
+
+// The console never allocates: the line buffer, argument vector and command
+// table are static, and commands are registered by pointer.
+void console_init(console_write_fn write, void *ctx);
+
+// cmd must stay valid (normally a static const); "help" is built in
+esp_err_t console_register(const console_cmd_t *cmd);
+
+// Feed received bytes. Returns immediately: complete lines are executed,
+// partial lines wait for more bytes. Handles backspace, Ctrl-C, Ctrl-U,
+// CR/LF/CRLF line endings, and ignores escape sequences (arrow keys).
+void console_feed(const char *data, size_t len);
+
+// Tokenise and run one line in place (quotes group words: "a b")
+int console_execute(char *line);
+
+// Formatted output with "\n" sent as "\r\n"
+void console_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// Parse a decimal or 0x-prefixed integer within [min, max]
+bool console_parse_int(const char *text, long min, long max, long *out);
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "driver/uart.h"
+
+#include "console.h"
+#include "commands.h"
+#include "trace.h"
+
+#define BUTTON_PIN GPIO_NUM_0     // Button connected to GPIO 0
+#define LED_PIN GPIO_NUM_2        // LED connected to GPIO 2
+#define TXD_PIN GPIO_NUM_4        // UART TX pin
+#define RXD_PIN GPIO_NUM_5        // UART RX pin
+#define UART_PORT UART_NUM_1      // Console on UART1, as the status messages in Lesson 9
+#define SPARE_PIN GPIO_NUM_13     // Free pin for trying "gpio 13 1"
+
+volatile bool led_on = false;     // Shared flag for LED state
+static volatile int manual_duty = -1;   // Set by "pwm set"; -1 = button controls the LED
+
+// Interrupt handler for button press
+static void IRAM_ATTR button_isr_handler(void *arg) {
+    led_on = !led_on; // Toggle LED state
+    trace_record("button", led_on);
+}
+
+// Task 1: Configure button GPIO and set up interrupt
+void button_task(void *pvParameter) {
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << BUTTON_PIN),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .intr_type = GPIO_INTR_NEGEDGE  // Interrupt on falling edge
+    };
+    gpio_config(&io_conf);
+
+    gpio_install_isr_service(0);  // Default ISR service
+    gpio_isr_handler_add(BUTTON_PIN, button_isr_handler, NULL);  // Add ISR
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));  // Nothing else needed here
+    }
+}
+
+static void set_duty(int duty) {
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, duty);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
+    trace_record("pwm_duty", duty);
+}
+
+// Task 2: PWM control of LED based on button flag, unless "pwm set" took over
+void pwm_task(void *pvParameter) {
+    // Configure LEDC timer
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .timer_num = LEDC_TIMER_0,
+        .duty_resolution = LEDC_TIMER_8_BIT,
+        .freq_hz = 5000,
+        .clk_cfg = LEDC_AUTO_CLK
+    };
+    ledc_timer_config(&ledc_timer);
+
+    // Configure LEDC channel
+    ledc_channel_config_t ledc_channel = {
+        .channel = LEDC_CHANNEL_0,
+        .duty = 0,
+        .gpio_num = LED_PIN,
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .hpoint = 0,
+        .timer_sel = LEDC_TIMER_0
+    };
+    ledc_channel_config(&ledc_channel);
+
+    while (1) {
+        if (manual_duty >= 0) {
+            set_duty(manual_duty);
+        } else if (led_on) {
+            for (int duty = 0; duty < 256 && manual_duty < 0; duty += 10) {
+                set_duty(duty);
+                vTaskDelay(pdMS_TO_TICKS(20));
+            }
+        } else {
+            set_duty(0);
+        }
+        vTaskDelay(pdMS_TO_TICKS(500));
+    }
+}
+
+// ---- Application commands ----
+
+static int pwm_cmd(int argc, char **argv) {
+    long duty;
+    if (argc == 3 && strcmp(argv[1], "set") == 0 && console_parse_int(argv[2], 0, 255, &duty)) {
+        manual_duty = duty;
+        console_printf("LED duty fixed at %ld/255\n", duty);
+        return CONSOLE_OK;
+    }
+    if (argc == 2 && strcmp(argv[1], "auto") == 0) {
+        manual_duty = -1;
+        console_printf("LED back under button control\n");
+        return CONSOLE_OK;
+    }
+    if (argc == 1) {
+        console_printf("Duty %lu/255, %s\n", (unsigned long)ledc_get_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0),
+                       manual_duty >= 0 ? "manual" : led_on ? "button: ON" : "button: BLINKING");
+        return CONSOLE_OK;
+    }
+    return CONSOLE_ERR_USAGE;
+}
+
+static const console_cmd_t pwm_command = {
+    .name = "pwm",
+    .usage = "[set <0-255> | auto]",
+    .help = "Show or set the LED PWM duty",
+    .fn = pwm_cmd,
+};
+
+// Pins the gpio command may touch. The LED belongs to LEDC (use "pwm set"), and
+// driving the console's own UART pins would cut the connection.
+static const commands_gpio_t gpio_pins[] = {
+    { BUTTON_PIN, "button",          false },
+    { LED_PIN,    "LED (pwm)",       false },
+    { TXD_PIN,    "console UART TX", false },
+    { RXD_PIN,    "console UART RX", false },
+    { SPARE_PIN,  "spare",           true },
+};
+
+// ---- Console on UART1 ----
+
+static void uart_write(void *ctx, const char *data, size_t len) {
+    uart_write_bytes(UART_PORT, data, len);
+}
+
+// Task 3: the console replaces Lesson 9's periodic "LED is ON" message
+void console_task(void *pvParameter) {
+    // UART configuration
+    uart_config_t uart_config = {
+        .baud_rate = 115200,
+        .data_bits = UART_DATA_8_BITS,
+        .parity    = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE
+    };
+    uart_param_config(UART_PORT, &uart_config);
+    uart_set_pin(UART_PORT, TXD_PIN, RXD_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    uart_driver_install(UART_PORT, 1024 * 2, 1024 * 2, 0, NULL, 0);
+
+    console_init(uart_write, NULL);
+    commands_register_system();
+    commands_set_gpio_table(gpio_pins, sizeof(gpio_pins) / sizeof(gpio_pins[0]));
+    console_register(&pwm_command);
+
+    console_printf("\nESP32 console ready, type 'help'\n" CONSOLE_PROMPT);
+
+    char data[64];
+    while (1) {
+        // Whatever has arrived after 20 ms is handed over; the parser never waits for a full line
+        int len = uart_read_bytes(UART_PORT, data, sizeof(data), pdMS_TO_TICKS(20));
+        if (len > 0) {
+            console_feed(data, len);
+        }
+    }
+}
+
+// Main application
+void app_main() {
+    xTaskCreate(button_task, "Button Task", 2048, NULL, 10, NULL);
+    xTaskCreate(pwm_task, "PWM Task", 2048, NULL, 10, NULL);
+    xTaskCreate(console_task, "Console Task", 4096, NULL, 5, NULL);
+}
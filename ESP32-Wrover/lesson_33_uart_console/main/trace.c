@@ -0,0 +1,75 @@
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+
+#include "trace.h"
+
+static trace_entry_t entries[TRACE_CAPACITY];
+static size_t head;             // Next slot to write
+static size_t count;
+static uint32_t overwritten;
+static volatile bool running;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+void trace_start(void)
+{
+    portENTER_CRITICAL(&lock);
+    head = 0;
+    count = 0;
+    overwritten = 0;
+    running = true;
+    portEXIT_CRITICAL(&lock);
+}
+
+void trace_stop(void)
+{
+    running = false;
+}
+
+bool trace_is_running(void)
+{
+    return running;
+}
+
+// IRAM_ATTR so the GPIO ISR can record events
+IRAM_ATTR void trace_record(const char *event, int32_t arg)
+{
+    if (!running) {
+        return;
+    }
+    uint32_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL_SAFE(&lock);
+    entries[head].time_us = now;
+    entries[head].event = event;
+    entries[head].arg = arg;
+    head = (head + 1) % TRACE_CAPACITY;
+    if (count < TRACE_CAPACITY) {
+        count++;
+    } else {
+        overwritten++;
+    }
+    portEXIT_CRITICAL_SAFE(&lock);
+}
+
+size_t trace_count(void)
+{
+    return count;
+}
+
+uint32_t trace_overwritten(void)
+{
+    return overwritten;
+}
+
+bool trace_get(size_t index, trace_entry_t *out)
+{
+    bool found = false;
+    portENTER_CRITICAL(&lock);
+    if (index < count) {
+        *out = entries[(head + TRACE_CAPACITY - count + index) % TRACE_CAPACITY];
+        found = true;
+    }
+    portEXIT_CRITICAL(&lock);
+    return found;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRACE_CAPACITY 128      // Oldest events are overwritten when full
+
+typedef struct {
+    uint32_t time_us;           // Low 32 bits of esp_timer_get_time()
+    const char *event;          // Must be a string literal
+    int32_t arg;
+} trace_entry_t;
+
+// Recording is off until trace_start(); trace_record() is then a few
+// instructions in a critical section and may be called from ISRs
+void trace_start(void);
+void trace_stop(void);
+bool trace_is_running(void);
+void trace_record(const char *event, int32_t arg);
+
+// Number of events kept, and how many were overwritten
+size_t trace_count(void);
+uint32_t trace_overwritten(void);
+
+// index 0 is the oldest kept event
+bool trace_get(size_t index, trace_entry_t *out);
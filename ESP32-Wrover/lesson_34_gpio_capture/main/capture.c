@@ -0,0 +1,194 @@
+#include <stdatomic.h>
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "hal/gpio_ll.h"
+#include "soc/gpio_periph.h"
+
+#include "capture.h"
+
+typedef struct {
+    gpio_num_t pin;
+
+    // Written by the ISR (head) and the reader (tail); see sample_ring.h in Lesson 30
+    capture_edge_t ring[CAPTURE_RING_SIZE];
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+
+    // ISR side
+    uint8_t last_level;
+    bool gap;                       // Edges lost since the last one pushed
+    volatile uint32_t edges;
+    volatile uint32_t missed;
+    volatile uint32_t overflows;
+
+    // Reader side
+    bool have_rise, have_fall;
+    uint32_t last_rise, last_fall;
+    capture_measurement_t measurement;
+} capture_channel_t;
+
+static capture_channel_t channels[CAPTURE_MAX_PINS];
+static int channel_count;
+
+// Runs on every edge of every captured pin: take the timestamp first, then
+// do as little as possible. Everything here is in IRAM or inlined.
+static void IRAM_ATTR capture_isr(void *arg)
+{
+    uint32_t now = esp_cpu_get_cycle_count();
+    capture_channel_t *ch = arg;
+    uint8_t level = gpio_ll_get_level(&GPIO, ch->pin);
+
+    ch->edges++;
+    if (level == ch->last_level) {
+        ch->missed++;
+        ch->gap = true;
+    }
+    ch->last_level = level;
+
+    uint32_t head = atomic_load_explicit(&ch->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ch->tail, memory_order_acquire);
+    if (head - tail == CAPTURE_RING_SIZE) {
+        ch->overflows++;
+        ch->gap = true;
+        return;
+    }
+    ch->ring[head & (CAPTURE_RING_SIZE - 1)] = (capture_edge_t){ .cycles = now, .level = level, .gap = ch->gap };
+    ch->gap = false;
+    atomic_store_explicit(&ch->head, head + 1, memory_order_release);
+}
+
+esp_err_t capture_init(void)
+{
+    return gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+}
+
+esp_err_t capture_add_pin(gpio_num_t pin, gpio_pull_mode_t pull, int *channel)
+{
+    if (channel_count == CAPTURE_MAX_PINS) {
+        return ESP_ERR_NO_MEM;
+    }
+    capture_channel_t *ch = &channels[channel_count];
+    memset(ch, 0, sizeof(*ch));
+    ch->pin = pin;
+
+    // Only the input side is touched, unlike gpio_config() which would disable the output
+    PIN_INPUT_ENABLE(GPIO_PIN_MUX_REG[pin]);
+    esp_err_t err = gpio_set_pull_mode(pin, pull);
+    if (err == ESP_OK) {
+        err = gpio_set_intr_type(pin, GPIO_INTR_ANYEDGE);
+    }
+    ch->last_level = gpio_get_level(pin);
+    if (err == ESP_OK) {
+        err = gpio_isr_handler_add(pin, capture_isr, ch);
+    }
+    if (err == ESP_OK) {
+        err = gpio_intr_enable(pin);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    *channel = channel_count++;
+    return ESP_OK;
+}
+
+static bool pop_edge(capture_channel_t *ch, capture_edge_t *edge)
+{
+    uint32_t tail = atomic_load_explicit(&ch->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ch->head, memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+    *edge = ch->ring[tail & (CAPTURE_RING_SIZE - 1)];
+    atomic_store_explicit(&ch->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+size_t capture_read(int channel, capture_edge_t *out, size_t max)
+{
+    size_t count = 0;
+    while (count < max && pop_edge(&channels[channel], &out[count])) {
+        count++;
+    }
+    return count;
+}
+
+uint32_t capture_cycles_to_ns(uint32_t cycles)
+{
+    return (uint64_t)cycles * 1000 / esp_rom_get_cpu_ticks_per_us();
+}
+
+bool capture_measure(int channel, capture_measurement_t *out)
+{
+    capture_channel_t *ch = &channels[channel];
+    capture_measurement_t *m = &ch->measurement;
+    bool complete = false;
+    uint32_t rises = 0, first_rise = 0, last_rise = 0;
+
+    capture_edge_t edge;
+    while (pop_edge(ch, &edge)) {
+        if (edge.gap) {
+            // The edges before this one are gone, so it may be labelled with the wrong
+            // direction and any interval across it is wrong. Start over after it.
+            ch->have_rise = ch->have_fall = false;
+            rises = 0;
+            continue;
+        }
+        if (edge.level) {
+            if (ch->have_fall) {
+                m->low_ns = capture_cycles_to_ns(edge.cycles - ch->last_fall);
+            }
+            if (ch->have_rise) {
+                m->period_ns = capture_cycles_to_ns(edge.cycles - ch->last_rise);
+                complete = true;
+            }
+            if (rises++ == 0) {
+                first_rise = edge.cycles;
+            }
+            last_rise = edge.cycles;
+            ch->last_rise = edge.cycles;
+            ch->have_rise = true;
+        } else {
+            if (ch->have_rise) {
+                m->high_ns = capture_cycles_to_ns(edge.cycles - ch->last_rise);
+            }
+            ch->last_fall = edge.cycles;
+            ch->have_fall = true;
+        }
+    }
+
+    // Averaging over many periods gives a much finer frequency than one period
+    if (rises >= 2 && last_rise != first_rise) {
+        m->frequency_hz = (rises - 1) * (esp_rom_get_cpu_ticks_per_us() * 1e6f) / (last_rise - first_rise);
+    } else if (complete && m->period_ns) {
+        m->frequency_hz = 1e9f / m->period_ns;
+    }
+    m->duty = m->period_ns ? (float)m->high_ns / m->period_ns : 0;
+
+    *out = *m;
+    return complete;
+}
+
+void capture_get_counters(int channel, capture_counters_t *out)
+{
+    capture_channel_t *ch = &channels[channel];
+    out->edges = ch->edges;
+    out->missed = ch->missed;
+    out->overflows = ch->overflows;
+}
+
+void capture_reset(int channel)
+{
+    capture_channel_t *ch = &channels[channel];
+    gpio_intr_disable(ch->pin);
+    atomic_store(&ch->head, 0);
+    atomic_store(&ch->tail, 0);
+    ch->edges = ch->missed = ch->overflows = 0;
+    ch->last_level = gpio_get_level(ch->pin);
+    ch->gap = false;
+    ch->have_rise = ch->have_fall = false;
+    memset(&ch->measurement, 0, sizeof(ch->measurement));
+    gpio_intr_enable(ch->pin);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+#define CAPTURE_MAX_PINS  4
+#define CAPTURE_RING_SIZE 128       // Edges buffered per pin, power of two
+
+// One edge. Timestamps are CPU cycles from the core that runs the GPIO ISR
+// (240 per microsecond at 240 MHz); they wrap every ~17.9 s, so intervals
+// are computed with unsigned subtraction and must be shorter than that.
+typedef struct {
+    uint32_t cycles;
+    uint8_t level;                  // Pin level after the edge: 1 = rising, 0 = falling
+    uint8_t gap;                    // 1 = edges were lost just before this one (missed or
+                                    // ring full): its level and time may not match one edge
+} capture_edge_t;
+
+typedef struct {
+    uint32_t high_ns;               // Last complete high pulse
+    uint32_t low_ns;                // Last complete low pulse
+    uint32_t period_ns;             // Last rising-to-rising interval
+    float frequency_hz;             // Average over the edges consumed by this call
+    float duty;                     // high_ns / period_ns, 0..1
+} capture_measurement_t;
+
+typedef struct {
+    uint32_t edges;                 // Interrupts taken
+    uint32_t missed;                // Same level twice in a row: an edge was too fast to see
+    uint32_t overflows;             // Ring full: the reader did not keep up
+} capture_counters_t;
+
+// Installs the GPIO ISR service; call once
+esp_err_t capture_init(void);
+
+// Start capturing both edges on a pin. The pin's output configuration is
+// left alone, so a pin driven by LEDC or RMT can capture its own signal.
+esp_err_t capture_add_pin(gpio_num_t pin, gpio_pull_mode_t pull, int *channel);
+
+// Raw access: pop up to `max` edges, oldest first
+size_t capture_read(int channel, capture_edge_t *out, size_t max);
+
+// Consume all buffered edges and update the pulse measurements.
+// Returns false if no new complete period was seen since the last call.
+bool capture_measure(int channel, capture_measurement_t *out);
+
+void capture_get_counters(int channel, capture_counters_t *out);
+
+// Drop buffered edges and clear counters and measurements
+void capture_reset(int channel);
+
+uint32_t capture_cycles_to_ns(uint32_t cycles);
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "esp_timer.h"
+
+#include "capture.h"
+
+#define SIGNAL_PIN GPIO_NUM_18      // LEDC output, captured by the same pin (no wiring needed)
+#define BUTTON_PIN GPIO_NUM_0       // BOOT button, as in Lesson 9
+#define SWEEP_WINDOW_MS 100
+#define REPORT_PERIOD_MS 1000
+
+// Test signal frequencies; every period has two edges
+static const uint32_t sweep_hz[] = { 1000, 2000, 5000, 10000, 20000, 50000, 100000 };
+#define SWEEP_COUNT (sizeof(sweep_hz) / sizeof(sweep_hz[0]))
+
+static void signal_init(void)
+{
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .timer_num = LEDC_TIMER_0,
+        .duty_resolution = LEDC_TIMER_8_BIT,
+        .freq_hz = sweep_hz[0],
+        .clk_cfg = LEDC_AUTO_CLK
+    };
+    ledc_timer_config(&ledc_timer);
+
+    ledc_channel_config_t ledc_channel = {
+        .channel = LEDC_CHANNEL_0,
+        .duty = 128,                // 50%
+        .gpio_num = SIGNAL_PIN,
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .hpoint = 0,
+        .timer_sel = LEDC_TIMER_0
+    };
+    ledc_channel_config(&ledc_channel);
+}
+
+// Feed the capture pin faster and faster until edges get lost. "missed" means
+// two edges arrived before the ISR could read the pin; "overflow" means the
+// reader below fell behind. Both are counted, so nothing is lost silently.
+static void run_sweep(int channel)
+{
+    uint32_t best_edge_rate = 0;
+
+    printf("Signal Hz   Edges/s    Edges  Expected  Missed  Overflow  Measured Hz\n");
+    for (size_t i = 0; i < SWEEP_COUNT; i++) {
+        ledc_set_freq(LEDC_LOW_SPEED_MODE, LEDC_TIMER_0, sweep_hz[i]);
+        vTaskDelay(pdMS_TO_TICKS(10));
+        capture_reset(channel);
+
+        capture_measurement_t m = { 0 };
+        int64_t start = esp_timer_get_time();
+        while (esp_timer_get_time() - start < SWEEP_WINDOW_MS * 1000) {
+            capture_measure(channel, &m);   // Drains the ring as fast as possible
+        }
+        capture_counters_t c;
+        capture_get_counters(channel, &c);
+        int64_t elapsed_us = esp_timer_get_time() - start;
+
+        uint32_t edge_rate = 2 * sweep_hz[i];
+        uint32_t expected = (uint64_t)edge_rate * elapsed_us / 1000000;
+        bool lossless = c.missed == 0 && c.overflows == 0 && (uint64_t)c.edges * 100 >= (uint64_t)expected * 99;
+
+        printf("%9lu %9lu %8lu %9lu %7lu %9lu %12.1f %s\n", (unsigned long)sweep_hz[i],
+               (unsigned long)edge_rate, (unsigned long)c.edges, (unsigned long)expected,
+               (unsigned long)c.missed, (unsigned long)c.overflows, m.frequency_hz, lossless ? "ok" : "LOSS");
+        if (!lossless) {
+            break;
+        }
+        best_edge_rate = edge_rate;
+    }
+    printf("Max edge rate without loss: %lu edges/s\n\n", (unsigned long)best_edge_rate);
+}
+
+// Raw edges: report how long each press lasted, bounces included
+static void report_button(int channel)
+{
+    static uint32_t press_start;
+    static bool pressed;
+
+    capture_edge_t edges[16];
+    size_t n;
+    while ((n = capture_read(channel, edges, 16)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (edges[i].gap) {
+                pressed = false;    // Edges were lost: this press cannot be timed
+            } else if (edges[i].level == 0) {
+                press_start = edges[i].cycles;
+                pressed = true;
+            } else if (pressed) {
+                printf("BOOT pressed for %lu us\n",
+                       (unsigned long)(capture_cycles_to_ns(edges[i].cycles - press_start) / 1000));
+                pressed = false;
+            }
+        }
+    }
+}
+
+// Main application
+void app_main()
+{
+    int signal, button;
+
+    signal_init();
+    ESP_ERROR_CHECK(capture_init());
+    ESP_ERROR_CHECK(capture_add_pin(SIGNAL_PIN, GPIO_FLOATING, &signal));
+    ESP_ERROR_CHECK(capture_add_pin(BUTTON_PIN, GPIO_PULLUP_ONLY, &button));
+
+    run_sweep(signal);
+
+    // Demo signal: 1 kHz at 25% duty, like a tachometer or flow meter output
+    ledc_set_freq(LEDC_LOW_SPEED_MODE, LEDC_TIMER_0, 1000);
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, 64);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
+    capture_reset(signal);
+
+    while (1) {
+        // 2000 edges per second would overflow the 128-edge ring between reports,
+        // so the signal is drained every 10 ms and printed once per second
+        capture_measurement_t m;
+        bool fresh = false;
+        for (int i = 0; i < REPORT_PERIOD_MS / 10; i++) {
+            fresh |= capture_measure(signal, &m);
+            report_button(button);
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+
+        capture_counters_t c;
+        capture_get_counters(signal, &c);
+        if (fresh) {
+            printf("GPIO%d: %.1f Hz, high %lu ns, low %lu ns, duty %.1f%%, edges %lu, missed %lu, overflows %lu\n",
+                   SIGNAL_PIN, m.frequency_hz, (unsigned long)m.high_ns, (unsigned long)m.low_ns,
+                   m.duty * 100, (unsigned long)c.edges, (unsigned long)c.missed, (unsigned long)c.overflows);
+        } else {
+            printf("GPIO%d: no signal\n", SIGNAL_PIN);
+        }
+    }
+}
@@ -0,0 +1,271 @@
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "driver/gptimer.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "hal/gpio_ll.h"
+
+#include "display.h"
+
+#define TIMER_RESOLUTION_HZ 1000000         // gptimer ticks in microseconds
+#define LEDC_RESOLUTION LEDC_TIMER_10_BIT
+#define LEDC_PERIOD_TICKS 1024              // One full scan of all digits
+#define LEDC_DIVIDER_UNIT_HZ 20000000       // 80 MHz APB * 256 (fractional divider) / 1024 ticks
+#define BLANK_FRACTION 16                   // Each slot starts and ends dark for 1/16 of its length
+
+static display_config_t cfg;
+static gptimer_handle_t refresh_timer;
+static uint32_t slot_ticks, blank_ticks;    // LEDC ticks
+static uint32_t blank_us;                   // The dark gap in gptimer ticks, rounded down
+
+static uint8_t frame[DISPLAY_MAX_DIGITS];   // What the tasks asked for
+static uint8_t shown[DISPLAY_MAX_DIGITS];   // What the ISR is scanning out, latched once per scan
+static portMUX_TYPE frame_lock = portMUX_INITIALIZER_UNLOCKED;
+static int current_digit;
+
+// Guarded by frame_lock
+static uint32_t refreshes, max_cycles, max_latency_us, late;
+static uint64_t total_cycles;
+
+// The digit pins are driven by LEDC, not by this ISR: each digit's channel is
+// shifted into its own slot with hpoint, so the hardware switches the digits
+// and the ISR only has to put the next digit's pattern on the segment pins
+// while every digit is dark.
+static bool IRAM_ATTR refresh_isr(gptimer_handle_t timer, const gptimer_alarm_event_data_t *event, void *ctx)
+{
+    uint32_t start = esp_cpu_get_cycle_count();
+
+    int digit = current_digit + 1;
+    if (digit == cfg.digit_count) {
+        digit = 0;
+    }
+    current_digit = digit;
+
+    portENTER_CRITICAL_ISR(&frame_lock);
+    if (digit == 0) {
+        // A whole scan shows one frame, so a half-written update never appears
+        for (int i = 0; i < cfg.digit_count; i++) {
+            shown[i] = frame[i];
+        }
+    }
+    portEXIT_CRITICAL_ISR(&frame_lock);
+
+    uint8_t segments = shown[digit];
+    for (int i = 0; i < DISPLAY_SEGMENT_COUNT; i++) {
+        gpio_ll_set_level(&GPIO, cfg.segment_pins[i], (segments >> i) & 1);
+    }
+
+    // The alarm reloaded the count to 0, so it now holds the time since the slot began,
+    // interrupt entry included. Past the dark gap, the digit showed the previous pattern.
+    uint64_t latency_us = 0;
+    gptimer_get_raw_count(timer, &latency_us);
+
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+    portENTER_CRITICAL_ISR(&frame_lock);
+    refreshes++;
+    total_cycles += cycles;
+    if (cycles > max_cycles) {
+        max_cycles = cycles;
+    }
+    if (latency_us > max_latency_us) {
+        max_latency_us = latency_us;
+    }
+    if (latency_us >= blank_us) {
+        late++;
+    }
+    portEXIT_CRITICAL_ISR(&frame_lock);
+    return false;
+}
+
+static void apply_brightness(int digit, uint8_t level)
+{
+    uint32_t duty = (uint32_t)level * (slot_ticks - 2 * blank_ticks) / 255;
+    uint32_t hpoint = digit * LEDC_PERIOD_TICKS / cfg.digit_count + blank_ticks;
+    ledc_set_duty_with_hpoint(LEDC_LOW_SPEED_MODE, cfg.ledc_channel + digit, duty, hpoint);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, cfg.ledc_channel + digit);
+}
+
+esp_err_t display_init(const display_config_t *config)
+{
+    if (config->digit_count < 1 || config->digit_count > DISPLAY_MAX_DIGITS || config->refresh_hz == 0 ||
+        TIMER_RESOLUTION_HZ % config->refresh_hz != 0 || config->refresh_hz % config->digit_count != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // The gptimer and LEDC both count the 80 MHz APB clock. With an exact LEDC
+    // divider they never drift apart, so the slots stay aligned forever.
+    uint32_t scan_hz = config->refresh_hz / config->digit_count;
+    if (LEDC_DIVIDER_UNIT_HZ % scan_hz != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cfg = *config;
+    slot_ticks = LEDC_PERIOD_TICKS / cfg.digit_count;
+    blank_ticks = slot_ticks / BLANK_FRACTION;
+    blank_us = (uint64_t)blank_ticks * TIMER_RESOLUTION_HZ / ((uint64_t)scan_hz * LEDC_PERIOD_TICKS);
+
+    uint64_t segment_mask = 0;
+    for (int i = 0; i < DISPLAY_SEGMENT_COUNT; i++) {
+        segment_mask |= 1ULL << cfg.segment_pins[i];
+    }
+    gpio_config_t io_conf = {
+        .pin_bit_mask = segment_mask,
+        .mode = GPIO_MODE_OUTPUT,
+    };
+    esp_err_t err = gpio_config(&io_conf);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .timer_num = cfg.ledc_timer,
+        .duty_resolution = LEDC_RESOLUTION,
+        .freq_hz = scan_hz,
+        .clk_cfg = LEDC_USE_APB_CLK
+    };
+    err = ledc_timer_config(&ledc_timer);
+    for (int i = 0; i < cfg.digit_count && err == ESP_OK; i++) {
+        ledc_channel_config_t ledc_channel = {
+            .channel = cfg.ledc_channel + i,
+            .duty = 0,
+            .gpio_num = cfg.digit_pins[i],
+            .speed_mode = LEDC_LOW_SPEED_MODE,
+            .hpoint = 0,
+            .timer_sel = cfg.ledc_timer
+        };
+        err = ledc_channel_config(&ledc_channel);
+        if (err == ESP_OK) {
+            apply_brightness(i, 255);
+        }
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = TIMER_RESOLUTION_HZ,
+    };
+    err = gptimer_new_timer(&timer_config, &refresh_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    gptimer_event_callbacks_t callbacks = {
+        .on_alarm = refresh_isr,
+    };
+    gptimer_alarm_config_t alarm = {
+        .alarm_count = TIMER_RESOLUTION_HZ / cfg.refresh_hz,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    err = gptimer_register_event_callbacks(refresh_timer, &callbacks, NULL);
+    if (err == ESP_OK) {
+        err = gptimer_set_alarm_action(refresh_timer, &alarm);
+    }
+    if (err == ESP_OK) {
+        err = gptimer_enable(refresh_timer);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Start both counters together: slot 0 of the LEDC scan begins now, and the
+    // first alarm marks the start of slot 1. A few microseconds of offset
+    // between the two fall inside the dark gap at the edge of every slot.
+    current_digit = 0;
+    portDISABLE_INTERRUPTS();
+    err = ledc_timer_rst(LEDC_LOW_SPEED_MODE, cfg.ledc_timer);
+    if (err == ESP_OK) {
+        err = gptimer_start(refresh_timer);
+    }
+    portENABLE_INTERRUPTS();
+    return err;
+}
+
+static uint8_t glyph(char c)
+{
+    static const uint8_t digits[10] = {
+        0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F
+    };
+    // Letters that can be read on 7 segments; K, M, V, W, X and Z stay blank
+    static const uint8_t letters[26] = {
+        0x77, 0x7C, 0x39, 0x5E, 0x79, 0x71, 0x3D, 0x76, 0x30, 0x1E, 0x00, 0x38, 0x00,   // A-M
+        0x54, 0x5C, 0x73, 0x67, 0x50, 0x6D, 0x78, 0x3E, 0x00, 0x00, 0x00, 0x6E, 0x00,   // N-Z
+    };
+
+    if (c >= '0' && c <= '9') {
+        return digits[c - '0'];
+    }
+    if (isalpha((unsigned char)c)) {
+        return letters[toupper((unsigned char)c) - 'A'];
+    }
+    switch (c) {
+    case '-': return 0x40;
+    case '_': return 0x08;
+    case '.': return DISPLAY_SEG_DP;
+    default:  return 0x00;
+    }
+}
+
+void display_set_segments(const uint8_t *segments, int count)
+{
+    if (count > cfg.digit_count) {
+        count = cfg.digit_count;
+    }
+    portENTER_CRITICAL(&frame_lock);
+    memcpy(frame, segments, count);
+    memset(frame + count, 0, cfg.digit_count - count);
+    portEXIT_CRITICAL(&frame_lock);
+}
+
+void display_print(const char *text)
+{
+    uint8_t rendered[DISPLAY_MAX_DIGITS] = { 0 };
+    int count = 0;
+
+    for (; *text; text++) {
+        // A point joins the character before it instead of taking a digit
+        if (*text == '.' && count > 0 && !(rendered[count - 1] & DISPLAY_SEG_DP)) {
+            rendered[count - 1] |= DISPLAY_SEG_DP;
+            continue;
+        }
+        if (count == cfg.digit_count) {
+            break;
+        }
+        rendered[count++] = glyph(*text);
+    }
+    display_set_segments(rendered, cfg.digit_count);
+}
+
+void display_printf(const char *format, ...)
+{
+    char text[DISPLAY_MAX_DIGITS * 2 + 1];     // Room for a point after every digit
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    display_print(text);
+}
+
+void display_set_brightness(int digit, uint8_t level)
+{
+    if (digit >= 0 && digit < cfg.digit_count) {
+        apply_brightness(digit, level);
+    }
+}
+
+void display_get_stats(display_stats_t *out)
+{
+    portENTER_CRITICAL(&frame_lock);
+    out->refreshes = refreshes;
+    out->avg_cycles = refreshes ? total_cycles / refreshes : 0;
+    out->max_cycles = max_cycles;
+    out->max_latency_us = max_latency_us;
+    out->blank_us = blank_us;
+    out->late = late;
+    portEXIT_CRITICAL(&frame_lock);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "esp_err.h"
+
+#define DISPLAY_MAX_DIGITS 8        // One LEDC channel per digit
+#define DISPLAY_SEGMENT_COUNT 8     // a, b, c, d, e, f, g, dp
+
+// Segment bits of a packed frame byte: bit 0 = a ... bit 6 = g, bit 7 = dp
+#define DISPLAY_SEG_DP 0x80
+
+typedef struct {
+    gpio_num_t segment_pins[DISPLAY_SEGMENT_COUNT];     // a..g, dp; high = segment on
+    gpio_num_t digit_pins[DISPLAY_MAX_DIGITS];          // Leftmost first; high = digit on
+    int digit_count;
+    uint32_t refresh_hz;            // Digit slots per second; each digit is lit refresh_hz / digit_count times a second
+    ledc_timer_t ledc_timer;
+    ledc_channel_t ledc_channel;    // First of digit_count consecutive channels
+} display_config_t;
+
+typedef struct {
+    uint32_t refreshes;             // Timer interrupts handled
+    uint32_t avg_cycles;            // CPU cycles per refresh inside the ISR
+    uint32_t max_cycles;
+    uint32_t max_latency_us;        // Worst time from the timer alarm to the last segment write
+    uint32_t blank_us;              // Dark gap at the start of every slot: the budget for that
+    uint32_t late;                  // Refreshes that wrote the segments after the digit lit up
+} display_stats_t;
+
+esp_err_t display_init(const display_config_t *config);
+
+// Show text, left-aligned and padded with blanks. Digits, '-', '_', ' ' and
+// the letters of a 7-segment font are supported; '.' lights the decimal point
+// of the previous character. Never blocks, safe to call from any task.
+void display_print(const char *text);
+void display_printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+// Write raw segment bytes, one per digit
+void display_set_segments(const uint8_t *segments, int count);
+
+// 0 = off, 255 = full brightness. Takes effect at the next LEDC period.
+void display_set_brightness(int digit, uint8_t level);
+
+void display_get_stats(display_stats_t *out);
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+
+#include "display.h"
+
+#define REFRESH_HZ 2000             // 4 digits -> every digit lit 500 times a second
+#define REPORT_PERIOD_MS 5000
+
+static const display_config_t display_config = {
+    // a-g as in Lesson 29, decimal point on GPIO 23
+    .segment_pins = { GPIO_NUM_13, GPIO_NUM_14, GPIO_NUM_25, GPIO_NUM_26,
+                      GPIO_NUM_27, GPIO_NUM_32, GPIO_NUM_33, GPIO_NUM_23 },
+    .digit_pins = { GPIO_NUM_18, GPIO_NUM_19, GPIO_NUM_21, GPIO_NUM_22 },
+    .digit_count = 4,
+    .refresh_hz = REFRESH_HZ,
+    .ledc_timer = LEDC_TIMER_0,
+    .ledc_channel = LEDC_CHANNEL_0,
+};
+
+// Brightness patterns cycled by the main loop, one level per digit
+static const uint8_t brightness_patterns[][4] = {
+    { 255, 255, 255, 255 },
+    { 32, 96, 160, 255 },
+    { 16, 16, 16, 16 },
+};
+#define PATTERN_COUNT (sizeof(brightness_patterns) / sizeof(brightness_patterns[0]))
+
+// Task 1: a stopwatch in tenths of a second. display_printf() only renders
+// the text and copies 4 bytes, so the task never waits for the display.
+void stopwatch_task(void *pvParameter)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t tenths = 0;
+
+    while (1) {
+        display_printf("%3lu.%lu", (unsigned long)(tenths / 10 % 1000), (unsigned long)(tenths % 10));
+        tenths++;
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(100));
+    }
+}
+
+static void report_cost(void)
+{
+    static display_stats_t previous;
+    display_stats_t stats;
+    display_get_stats(&stats);
+
+    uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+    uint32_t per_second = (stats.refreshes - previous.refreshes) * 1000 / REPORT_PERIOD_MS;
+    // Share of one core spent in the refresh ISR, in hundredths of a percent
+    uint32_t load = (uint64_t)stats.avg_cycles * per_second * 10000 / (ticks_per_us * 1000000);
+
+    printf("Refresh: %lu/s, %lu cycles avg (%lu ns), %lu max, CPU %lu.%02lu%%\n",
+           (unsigned long)per_second, (unsigned long)stats.avg_cycles,
+           (unsigned long)(stats.avg_cycles * 1000 / ticks_per_us), (unsigned long)stats.max_cycles,
+           (unsigned long)(load / 100), (unsigned long)(load % 100));
+    // Segments written after the dark gap show on the wrong digit for a moment
+    printf("Latency: %lu us max, %lu us allowed, %lu late%s\n", (unsigned long)stats.max_latency_us,
+           (unsigned long)stats.blank_us, (unsigned long)stats.late,
+           stats.late > previous.late ? " - digits ghost: lower REFRESH_HZ for a longer gap" : "");
+    previous = stats;
+}
+
+// Main application
+void app_main(void)
+{
+    ESP_ERROR_CHECK(display_init(&display_config));
+
+    // Cost of one update from a task, for comparison with the ISR
+    uint32_t start = esp_cpu_get_cycle_count();
+    display_print("8.8.8.8.");
+    printf("display_print(): %lu cycles\n", (unsigned long)(esp_cpu_get_cycle_count() - start));
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    xTaskCreate(stopwatch_task, "Stopwatch Task", 2048, NULL, 5, NULL);
+
+    for (size_t pattern = 0; ; pattern = (pattern + 1) % PATTERN_COUNT) {
+        for (int i = 0; i < display_config.digit_count; i++) {
+            display_set_brightness(i, brightness_patterns[pattern][i]);
+        }
+        vTaskDelay(pdMS_TO_TICKS(REPORT_PERIOD_MS));
+        report_cost();
+    }
+}
@@ -0,0 +1,456 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#include "config.h"
+
+#define NVS_NAMESPACE "config"
+#define SECRET_MASK "********"
+
+static const char *TAG = "config";
+
+typedef struct {
+    const char *name;           // Also the NVS key: at most 15 characters
+    config_type_t type;
+    int32_t min, max;           // Range for integers, length range for strings
+    int32_t default_int;
+    const char *default_str;
+    bool secret;                // Never shown by config_format()
+    const char *help;
+} config_def_t;
+
+static const config_def_t defs[CONFIG_KEY_COUNT] = {
+    //                     name           type                min   max      int     string                        secret
+    [CONFIG_WIFI_SSID]   = { "wifi_ssid",   CONFIG_TYPE_STRING, 1,    32,      0,      "Your SSID",                  false,
+                             "Wi-Fi network name" },
+    [CONFIG_WIFI_PASS]   = { "wifi_pass",   CONFIG_TYPE_STRING, 0,    63,      0,      "Your Password",              true,
+                             "Wi-Fi password" },
+    [CONFIG_TIMEZONE]    = { "timezone",    CONFIG_TYPE_STRING, 1,    63,      0,      "EST5EDT,M3.2.0/2,M11.1.0/2", false,
+                             "POSIX TZ string" },
+    [CONFIG_NTP_SERVER]  = { "ntp_server",  CONFIG_TYPE_STRING, 1,    63,      0,      "pool.ntp.org",               false,
+                             "NTP server name" },
+    [CONFIG_UART_BAUD]   = { "uart_baud",   CONFIG_TYPE_INT,    9600, 921600,  115200, NULL,                         false,
+                             "Console baud rate" },
+    [CONFIG_TIME_LOG_MS] = { "time_log_ms", CONFIG_TYPE_INT,    1000, 3600000, 5000,   NULL,                         false,
+                             "Interval between time logs (ms)" },
+};
+
+// The RAM copy. Integers are read without a lock (32-bit loads are atomic);
+// strings, the dirty mask and the counters are guarded by cache_lock.
+static int32_t int_values[CONFIG_KEY_COUNT];
+static char str_values[CONFIG_KEY_COUNT][CONFIG_STR_MAX + 1];
+static uint32_t dirty;                  // Bit per key: changed since the last commit
+static int64_t first_dirty_us;
+static config_stats_t stats;
+static portMUX_TYPE cache_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static int64_t retry_delay_us;          // 0, or the backoff after the last failed commit
+static int64_t retry_at_us;             // No commit before this while commits are failing
+static volatile bool quiet;
+
+static SemaphoreHandle_t commit_lock;   // One commit at a time
+static esp_timer_handle_t commit_timer;
+static TaskHandle_t commit_task_handle;
+
+static struct {
+    config_key_t key;
+    config_callback_t callback;
+    void *ctx;
+} subscribers[CONFIG_MAX_SUBSCRIBERS];
+static int subscriber_count;
+
+static void notify(config_key_t key)
+{
+    if (quiet) {
+        return;
+    }
+    for (int i = 0; i < subscriber_count; i++) {
+        if (subscribers[i].key == key || subscribers[i].key == CONFIG_KEY_COUNT) {
+            subscribers[i].callback(key, subscribers[i].ctx);
+        }
+    }
+}
+
+// Flash writes take milliseconds, too long for the esp_timer task,
+// so the timer only wakes this task up
+static void commit_timer_cb(void *arg)
+{
+    xTaskNotifyGive(commit_task_handle);
+}
+
+static void commit_task(void *pvParameter)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        config_commit();
+    }
+}
+
+// Called with cache_lock held. Every change restarts the quiet period, but
+// the first pending change is never kept waiting longer than CONFIG_COMMIT_MAX_MS.
+// After a failed commit, changes do not bring the retry forward.
+static int64_t mark_dirty(config_key_t key)
+{
+    int64_t now = esp_timer_get_time();
+    if (dirty == 0) {
+        first_dirty_us = now;
+    }
+    dirty |= 1u << key;
+    stats.sets++;
+
+    int64_t deadline = now + CONFIG_COMMIT_DELAY_MS * 1000LL;
+    int64_t latest = first_dirty_us + CONFIG_COMMIT_MAX_MS * 1000LL;
+    int64_t due = deadline < latest ? deadline : latest;
+    return (due > retry_at_us ? due : retry_at_us) - now;
+}
+
+static void schedule_commit(int64_t delay_us)
+{
+    esp_timer_stop(commit_timer);
+    esp_timer_start_once(commit_timer, delay_us > 0 ? delay_us : 0);
+}
+
+static bool valid_int(config_key_t key, int32_t value)
+{
+    return value >= defs[key].min && value <= defs[key].max;
+}
+
+static bool valid_str(config_key_t key, const char *value)
+{
+    size_t len = strlen(value);
+    return len >= (size_t)defs[key].min && len <= (size_t)defs[key].max;
+}
+
+static void load_stored(nvs_handle_t nvs, config_key_t key)
+{
+    const config_def_t *def = &defs[key];
+    if (def->type == CONFIG_TYPE_INT) {
+        int32_t value;
+        if (nvs_get_i32(nvs, def->name, &value) == ESP_OK) {
+            if (valid_int(key, value)) {
+                int_values[key] = value;
+            } else {
+                ESP_LOGW(TAG, "Stored %s out of range, using default", def->name);
+            }
+        }
+    } else {
+        char value[CONFIG_STR_MAX + 1];
+        size_t size = sizeof(value);
+        if (nvs_get_str(nvs, def->name, value, &size) == ESP_OK) {
+            if (valid_str(key, value)) {
+                strcpy(str_values[key], value);
+            } else {
+                ESP_LOGW(TAG, "Stored %s invalid, using default", def->name);
+            }
+        }
+    }
+}
+
+static void load_defaults(void)
+{
+    for (int key = 0; key < CONFIG_KEY_COUNT; key++) {
+        if (defs[key].type == CONFIG_TYPE_INT) {
+            int_values[key] = defs[key].default_int;
+        } else {
+            strcpy(str_values[key], defs[key].default_str);
+        }
+    }
+}
+
+esp_err_t config_init(void)
+{
+    commit_lock = xSemaphoreCreateMutex();
+    if (commit_lock == NULL ||
+        xTaskCreate(commit_task, "Config Commit", 3072, NULL, 3, &commit_task_handle) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_timer_create_args_t timer_args = {
+        .callback = commit_timer_cb,
+        .name = "config_commit",
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &commit_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    load_defaults();
+
+    nvs_handle_t nvs;
+    err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGI(TAG, "Nothing stored yet, using defaults");
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    for (int key = 0; key < CONFIG_KEY_COUNT; key++) {
+        load_stored(nvs, key);
+    }
+    nvs_close(nvs);
+    return ESP_OK;
+}
+
+int32_t config_get_int(config_key_t key)
+{
+    return int_values[key];
+}
+
+void config_get_str(config_key_t key, char *out, size_t size)
+{
+    if (size == 0) {
+        return;
+    }
+    portENTER_CRITICAL(&cache_lock);
+    strncpy(out, str_values[key], size - 1);
+    portEXIT_CRITICAL(&cache_lock);
+    out[size - 1] = '\0';
+}
+
+esp_err_t config_set_int(config_key_t key, int32_t value)
+{
+    if (key >= CONFIG_KEY_COUNT || defs[key].type != CONFIG_TYPE_INT || !valid_int(key, value)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t delay_us = 0;
+    portENTER_CRITICAL(&cache_lock);
+    bool changed = int_values[key] != value;
+    if (changed) {
+        int_values[key] = value;
+        delay_us = mark_dirty(key);
+    }
+    portEXIT_CRITICAL(&cache_lock);
+
+    if (changed) {
+        schedule_commit(delay_us);
+        notify(key);
+    }
+    return ESP_OK;
+}
+
+esp_err_t config_set_str(config_key_t key, const char *value)
+{
+    if (key >= CONFIG_KEY_COUNT || defs[key].type != CONFIG_TYPE_STRING) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!valid_str(key, value)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    int64_t delay_us = 0;
+    portENTER_CRITICAL(&cache_lock);
+    bool changed = strcmp(str_values[key], value) != 0;
+    if (changed) {
+        strcpy(str_values[key], value);
+        delay_us = mark_dirty(key);
+    }
+    portEXIT_CRITICAL(&cache_lock);
+
+    if (changed) {
+        schedule_commit(delay_us);
+        notify(key);
+    }
+    return ESP_OK;
+}
+
+bool config_find(const char *name, config_key_t *key)
+{
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        if (strcmp(defs[i].name, name) == 0) {
+            *key = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *config_name(config_key_t key)
+{
+    return defs[key].name;
+}
+
+const char *config_help(config_key_t key)
+{
+    return defs[key].help;
+}
+
+esp_err_t config_set_from_text(config_key_t key, const char *text)
+{
+    if (defs[key].type == CONFIG_TYPE_STRING) {
+        return config_set_str(key, text);
+    }
+    char *end;
+    long value = strtol(text, &end, 0);
+    if (end == text || *end != '\0') {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return config_set_int(key, value);
+}
+
+void config_format(config_key_t key, char *out, size_t size)
+{
+    if (defs[key].secret) {
+        strncpy(out, SECRET_MASK, size);
+        out[size - 1] = '\0';
+    } else if (defs[key].type == CONFIG_TYPE_INT) {
+        snprintf(out, size, "%ld", (long)config_get_int(key));
+    } else {
+        config_get_str(key, out, size);
+    }
+}
+
+bool config_is_secret(config_key_t key)
+{
+    return defs[key].secret;
+}
+
+bool config_is_dirty(config_key_t key)
+{
+    portENTER_CRITICAL(&cache_lock);
+    bool pending = dirty & (1u << key);
+    portEXIT_CRITICAL(&cache_lock);
+    return pending;
+}
+
+esp_err_t config_subscribe(config_key_t key, config_callback_t callback, void *ctx)
+{
+    if (subscriber_count == CONFIG_MAX_SUBSCRIBERS) {
+        return ESP_ERR_NO_MEM;
+    }
+    subscribers[subscriber_count].key = key;
+    subscribers[subscriber_count].callback = callback;
+    subscribers[subscriber_count].ctx = ctx;
+    subscriber_count++;
+    return ESP_OK;
+}
+
+esp_err_t config_commit(void)
+{
+    // Only used under commit_lock; static to keep ~400 bytes off the caller's stack
+    static int32_t ints[CONFIG_KEY_COUNT];
+    static char strs[CONFIG_KEY_COUNT][CONFIG_STR_MAX + 1];
+
+    xSemaphoreTake(commit_lock, portMAX_DELAY);
+
+    // Take a snapshot, then write flash without holding up readers and setters
+    portENTER_CRITICAL(&cache_lock);
+    uint32_t pending = dirty;
+    dirty = 0;
+    for (int key = 0; key < CONFIG_KEY_COUNT; key++) {
+        if (pending & (1u << key)) {
+            ints[key] = int_values[key];
+            memcpy(strs[key], str_values[key], sizeof(strs[key]));
+        }
+    }
+    portEXIT_CRITICAL(&cache_lock);
+
+    if (pending == 0) {
+        xSemaphoreGive(commit_lock);
+        return ESP_OK;
+    }
+
+    uint32_t written = 0;
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK) {
+        for (int key = 0; key < CONFIG_KEY_COUNT && err == ESP_OK; key++) {
+            if (!(pending & (1u << key))) {
+                continue;
+            }
+            if (defs[key].type == CONFIG_TYPE_INT) {
+                err = nvs_set_i32(nvs, defs[key].name, ints[key]);
+            } else {
+                err = nvs_set_str(nvs, defs[key].name, strs[key]);
+            }
+            written++;
+        }
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+
+    // A failed commit keeps its keys dirty and tries again later, waiting twice as
+    // long each time: a full or worn NVS partition is not hammered with writes.
+    int64_t retry_us = 0;
+    portENTER_CRITICAL(&cache_lock);
+    if (err == ESP_OK) {
+        stats.commits++;
+        stats.keys_written += written;
+        retry_delay_us = 0;
+        retry_at_us = 0;
+    } else {
+        dirty |= pending;
+        stats.failed_commits++;
+        retry_delay_us = retry_delay_us == 0 ? CONFIG_COMMIT_DELAY_MS * 1000LL : retry_delay_us * 2;
+        if (retry_delay_us > CONFIG_RETRY_MAX_MS * 1000LL) {
+            retry_delay_us = CONFIG_RETRY_MAX_MS * 1000LL;
+        }
+        retry_us = retry_delay_us;
+        retry_at_us = esp_timer_get_time() + retry_us;
+    }
+    portEXIT_CRITICAL(&cache_lock);
+    if (retry_us > 0) {
+        schedule_commit(retry_us);
+    }
+    xSemaphoreGive(commit_lock);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Commit failed: %s, retrying in %lld s", esp_err_to_name(err), retry_us / 1000000);
+    } else if (!quiet) {
+        ESP_LOGI(TAG, "Committed %lu setting(s)", (unsigned long)written);
+    }
+    return err;
+}
+
+void config_set_quiet(bool on)
+{
+    quiet = on;
+}
+
+esp_err_t config_reset(void)
+{
+    xSemaphoreTake(commit_lock, portMAX_DELAY);
+    esp_timer_stop(commit_timer);
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK) {
+        err = nvs_erase_all(nvs);
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (err == ESP_OK) {
+        portENTER_CRITICAL(&cache_lock);
+        load_defaults();
+        dirty = 0;
+        retry_delay_us = 0;
+        retry_at_us = 0;
+        portEXIT_CRITICAL(&cache_lock);
+    }
+    xSemaphoreGive(commit_lock);
+
+    if (err == ESP_OK) {
+        for (int key = 0; key < CONFIG_KEY_COUNT; key++) {
+            notify(key);
+        }
+    }
+    return err;
+}
+
+void config_get_stats(config_stats_t *out)
+{
+    portENTER_CRITICAL(&cache_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&cache_lock);
+}
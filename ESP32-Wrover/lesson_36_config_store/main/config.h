@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define CONFIG_STR_MAX         64       // Longest string value, without the terminator
+#define CONFIG_MAX_SUBSCRIBERS 8
+#define CONFIG_COMMIT_DELAY_MS 2000     // Quiet time after the last change before writing flash
+#define CONFIG_COMMIT_MAX_MS   10000    // Upper bound while values keep changing
+#define CONFIG_RETRY_MAX_MS    60000    // A failed commit is retried after 2, 4, 8 .. at most 60 s
+
+// Every setting has a fixed index, so a read is one array access.
+// To add one: append a key here and a row to the table in config.c.
+typedef enum {
+    CONFIG_WIFI_SSID,
+    CONFIG_WIFI_PASS,
+    CONFIG_TIMEZONE,
+    CONFIG_NTP_SERVER,
+    CONFIG_UART_BAUD,
+    CONFIG_TIME_LOG_MS,
+    CONFIG_KEY_COUNT
+} config_key_t;
+
+typedef enum {
+    CONFIG_TYPE_INT,
+    CONFIG_TYPE_STRING,
+} config_type_t;
+
+typedef struct {
+    uint32_t sets;                  // Values changed in RAM
+    uint32_t commits;               // nvs_commit() calls
+    uint32_t keys_written;          // Values written to NVS
+    uint32_t failed_commits;        // Commits that failed and were rescheduled
+} config_stats_t;
+
+// Called after a value has changed, in the task that changed it. The callback
+// may read any setting but must not block for long.
+typedef void (*config_callback_t)(config_key_t key, void *ctx);
+
+// Load every setting from NVS, falling back to its default.
+// nvs_flash_init() must have been called.
+esp_err_t config_init(void);
+
+// Hot-path reads: no lock, no flash access
+int32_t config_get_int(config_key_t key);
+
+// Copies the string (truncated to size - 1 characters)
+void config_get_str(config_key_t key, char *out, size_t size);
+
+// Update the RAM copy, notify subscribers and schedule a commit.
+// Setting the current value again does nothing.
+esp_err_t config_set_int(config_key_t key, int32_t value);      // ESP_ERR_INVALID_ARG if out of range
+esp_err_t config_set_str(config_key_t key, const char *value);  // ESP_ERR_INVALID_SIZE if the length is out of range
+
+// Text interface for the console and the web page
+bool config_find(const char *name, config_key_t *key);
+const char *config_name(config_key_t key);
+const char *config_help(config_key_t key);
+esp_err_t config_set_from_text(config_key_t key, const char *text);
+void config_format(config_key_t key, char *out, size_t size);  // Secrets are shown as "********"
+bool config_is_secret(config_key_t key);
+bool config_is_dirty(config_key_t key);                         // Changed but not yet in flash
+
+// key == CONFIG_KEY_COUNT subscribes to every setting
+esp_err_t config_subscribe(config_key_t key, config_callback_t callback, void *ctx);
+
+// Write pending changes now instead of waiting for the debounce timer
+esp_err_t config_commit(void);
+
+// While quiet, subscribers are not called and successful commits are not logged.
+// For benchmarks, so the callbacks and the UART are not part of the measurement.
+void config_set_quiet(bool quiet);
+
+// Erase the stored settings and go back to the defaults
+esp_err_t config_reset(void);
+
+void config_get_stats(config_stats_t *out);
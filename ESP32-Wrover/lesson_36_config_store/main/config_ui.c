@@ -0,0 +1,322 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_cpu.h"
+#include "esp_timer.h"
+
+#include "config.h"
+#include "config_ui.h"
+#include "console.h"
+
+#define BENCH_READS 10000
+#define BENCH_CHANGES 10
+
+// ---- Console ----
+
+static void print_all(void)
+{
+    char value[CONFIG_STR_MAX + 1];
+    config_stats_t stats;
+
+    for (int key = 0; key < CONFIG_KEY_COUNT; key++) {
+        config_format(key, value, sizeof(value));
+        console_printf("%-12s %c %-28s %s\n", config_name(key), config_is_dirty(key) ? '*' : ' ',
+                       value, config_help(key));
+    }
+    config_get_stats(&stats);
+    console_printf("%lu changes, %lu commits, %lu values written, %lu failed commits (* = not in flash yet)\n",
+                   (unsigned long)stats.sets, (unsigned long)stats.commits,
+                   (unsigned long)stats.keys_written, (unsigned long)stats.failed_commits);
+}
+
+static volatile int32_t bench_sink;    // Keeps the compiler from removing the reads
+
+// What the cache buys: reads that never touch flash, and many changes per flash write.
+// Uses time_log_ms as the test value and puts it back afterwards. The store is quiet
+// meanwhile: the subscribers and the commit log line would be timed as well.
+static void run_bench(void)
+{
+    char text[CONFIG_STR_MAX + 1];
+    config_stats_t before, after;
+
+    config_set_quiet(true);
+    int32_t sum = 0;
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_READS; i++) {
+        sum += config_get_int(CONFIG_TIME_LOG_MS);
+    }
+    uint32_t int_cycles = (esp_cpu_get_cycle_count() - start) / BENCH_READS;
+    bench_sink = sum;
+
+    start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_READS; i++) {
+        config_get_str(CONFIG_TIMEZONE, text, sizeof(text));
+    }
+    uint32_t str_cycles = (esp_cpu_get_cycle_count() - start) / BENCH_READS;
+    console_printf("Read from cache: %lu cycles (int), %lu cycles (string)\n",
+                   (unsigned long)int_cycles, (unsigned long)str_cycles);
+
+    int32_t original = config_get_int(CONFIG_TIME_LOG_MS);
+    config_commit();
+
+    // Write-through: what saving every change immediately would cost
+    config_get_stats(&before);
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_CHANGES; i++) {
+        config_set_int(CONFIG_TIME_LOG_MS, 1000 + i);
+        config_commit();
+    }
+    int64_t through_us = esp_timer_get_time() - t0;
+    config_get_stats(&after);
+    console_printf("%d changes, commit after each: %lld us, %lu flash writes\n", BENCH_CHANGES,
+                   through_us, (unsigned long)(after.keys_written - before.keys_written));
+
+    // Batched: the changes only touch RAM, one commit at the end
+    config_get_stats(&before);
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < BENCH_CHANGES; i++) {
+        config_set_int(CONFIG_TIME_LOG_MS, 2000 + i);
+    }
+    int64_t set_us = esp_timer_get_time() - t0;
+    config_commit();
+    int64_t batched_us = esp_timer_get_time() - t0;
+    config_get_stats(&after);
+    console_printf("%d changes, one commit:        %lld us, %lu flash writes (%lld us per change in RAM)\n",
+                   BENCH_CHANGES, batched_us, (unsigned long)(after.keys_written - before.keys_written),
+                   set_us / BENCH_CHANGES);
+
+    config_set_int(CONFIG_TIME_LOG_MS, original);
+    config_commit();
+    config_set_quiet(false);
+}
+
+static int config_cmd(int argc, char **argv)
+{
+    char value[CONFIG_STR_MAX + 1];
+    config_key_t key;
+
+    if (argc == 1) {
+        print_all();
+        return CONSOLE_OK;
+    }
+    if (argc == 3 && strcmp(argv[1], "get") == 0) {
+        if (!config_find(argv[2], &key)) {
+            console_printf("Unknown setting '%s'\n", argv[2]);
+            return CONSOLE_ERR_FAIL;
+        }
+        config_format(key, value, sizeof(value));
+        console_printf("%s = %s\n", config_name(key), value);
+        return CONSOLE_OK;
+    }
+    if (argc == 4 && strcmp(argv[1], "set") == 0) {
+        if (!config_find(argv[2], &key)) {
+            console_printf("Unknown setting '%s'\n", argv[2]);
+            return CONSOLE_ERR_FAIL;
+        }
+        esp_err_t err = config_set_from_text(key, argv[3]);
+        if (err != ESP_OK) {
+            console_printf("Invalid value for %s (%s)\n", config_name(key), esp_err_to_name(err));
+            return CONSOLE_ERR_FAIL;
+        }
+        config_format(key, value, sizeof(value));
+        console_printf("%s = %s, saved in %d s\n", config_name(key), value, CONFIG_COMMIT_DELAY_MS / 1000);
+        return CONSOLE_OK;
+    }
+    if (argc == 2 && strcmp(argv[1], "commit") == 0) {
+        return config_commit() == ESP_OK ? CONSOLE_OK : CONSOLE_ERR_FAIL;
+    }
+    if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+        if (config_reset() != ESP_OK) {
+            return CONSOLE_ERR_FAIL;
+        }
+        console_printf("Back to defaults\n");
+        return CONSOLE_OK;
+    }
+    if (argc == 2 && strcmp(argv[1], "bench") == 0) {
+        run_bench();
+        return CONSOLE_OK;
+    }
+    return CONSOLE_ERR_USAGE;
+}
+
+static const console_cmd_t config_command = {
+    .name = "config",
+    .usage = "[get <name> | set <name> <value> | commit | reset | bench]",
+    .help = "Show or change settings",
+    .fn = config_cmd,
+};
+
+void config_ui_register_console(void)
+{
+    console_register(&config_command);
+}
+
+// ---- HTTP ----
+
+// Form fields arrive URL-encoded: '+' is a space, %XX is a byte
+static void url_decode(const char *in, char *out, size_t size)
+{
+    size_t n = 0;
+    while (*in && n < size - 1) {
+        if (*in == '+') {
+            out[n++] = ' ';
+            in++;
+        } else if (*in == '%' && isxdigit((unsigned char)in[1]) && isxdigit((unsigned char)in[2])) {
+            char hex[3] = { in[1], in[2], '\0' };
+            out[n++] = (char)strtol(hex, NULL, 16);
+            in += 3;
+        } else {
+            out[n++] = *in++;
+        }
+    }
+    out[n] = '\0';
+}
+
+// Values are user input, so they are escaped before going into the page
+static void html_escape(const char *in, char *out, size_t size)
+{
+    size_t n = 0;
+    for (; *in; in++) {
+        const char *rep;
+        switch (*in) {
+        case '&':  rep = "&amp;";  break;
+        case '<':  rep = "&lt;";   break;
+        case '>':  rep = "&gt;";   break;
+        case '\'': rep = "&#39;";  break;
+        case '"':  rep = "&quot;"; break;
+        default:   rep = NULL;     break;
+        }
+        size_t len = rep ? strlen(rep) : 1;
+        if (n + len >= size) {
+            break;
+        }
+        memcpy(out + n, rep ? rep : in, len);
+        n += len;
+    }
+    out[n] = '\0';
+}
+
+// HTTP handler: one form per setting
+static esp_err_t page_handler(httpd_req_t *req)
+{
+    char value[CONFIG_STR_MAX + 1];
+    char escaped[CONFIG_STR_MAX * 6 + 1];
+    char row[800];
+
+    httpd_resp_set_type(req, "text/html");
+    httpd_resp_sendstr_chunk(req,
+        "<!DOCTYPE html><html><head><title>ESP32 Settings</title></head><body>"
+        "<h2>ESP32 Settings</h2>");
+
+    for (int key = 0; key < CONFIG_KEY_COUNT; key++) {
+        bool secret = config_is_secret(key);
+        if (secret) {
+            escaped[0] = '\0';      // Never send the password back
+        } else {
+            config_format(key, value, sizeof(value));
+            html_escape(value, escaped, sizeof(escaped));
+        }
+        snprintf(row, sizeof(row),
+            "<form method='post' action='/config'>"
+            "<input type='hidden' name='key' value='%s'>"
+            "<label>%s <input type='%s' name='value' value='%s'%s></label> "
+            "<input type='submit' value='Save'> <small>%s</small>"
+            "</form>",
+            config_name(key), config_name(key), secret ? "password" : "text", escaped,
+            secret ? " placeholder='unchanged'" : "", config_help(key));
+        httpd_resp_sendstr_chunk(req, row);
+    }
+
+    httpd_resp_sendstr_chunk(req, "</body></html>");
+    return httpd_resp_sendstr_chunk(req, NULL);
+}
+
+// HTTP handler: plain "name=value" lines, for scripts
+static esp_err_t list_handler(httpd_req_t *req)
+{
+    char value[CONFIG_STR_MAX + 1];
+    char line[96];
+
+    httpd_resp_set_type(req, "text/plain");
+    for (int key = 0; key < CONFIG_KEY_COUNT; key++) {
+        config_format(key, value, sizeof(value));
+        snprintf(line, sizeof(line), "%s=%s\n", config_name(key), value);
+        httpd_resp_sendstr_chunk(req, line);
+    }
+    return httpd_resp_sendstr_chunk(req, NULL);
+}
+
+// HTTP handler: change one setting, body "key=<name>&value=<value>"
+static esp_err_t set_handler(httpd_req_t *req)
+{
+    char body[256];
+    char name[32], raw[CONFIG_STR_MAX * 3 + 1], value[CONFIG_STR_MAX + 1];
+    config_key_t key;
+
+    if (req->content_len >= sizeof(body)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Request too long");
+        return ESP_FAIL;
+    }
+    size_t received = 0;
+    while (received < req->content_len) {
+        int len = httpd_req_recv(req, body + received, req->content_len - received);
+        if (len == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (len <= 0) {
+            return ESP_FAIL;
+        }
+        received += len;
+    }
+    body[received] = '\0';
+
+    if (httpd_query_key_value(body, "key", name, sizeof(name)) != ESP_OK ||
+        httpd_query_key_value(body, "value", raw, sizeof(raw)) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Expected key=<name>&value=<value>");
+        return ESP_FAIL;
+    }
+    url_decode(raw, value, sizeof(value));
+    if (!config_find(name, &key)) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Unknown setting");
+        return ESP_FAIL;
+    }
+    // An empty password field means "keep the current one"
+    if (!(config_is_secret(key) && value[0] == '\0') && config_set_from_text(key, value) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid value");
+        return ESP_FAIL;
+    }
+
+    // Back to the settings page
+    httpd_resp_set_status(req, "303 See Other");
+    httpd_resp_set_hdr(req, "Location", "/");
+    return httpd_resp_sendstr(req, "Saved");
+}
+
+esp_err_t config_ui_register_http(httpd_handle_t server)
+{
+    static const httpd_uri_t page = {
+        .uri      = "/",
+        .method   = HTTP_GET,
+        .handler  = page_handler
+    };
+    static const httpd_uri_t list = {
+        .uri      = "/config",
+        .method   = HTTP_GET,
+        .handler  = list_handler
+    };
+    static const httpd_uri_t set = {
+        .uri      = "/config",
+        .method   = HTTP_POST,
+        .handler  = set_handler
+    };
+    esp_err_t err = httpd_register_uri_handler(server, &page);
+    if (err == ESP_OK) {
+        err = httpd_register_uri_handler(server, &list);
+    }
+    if (err == ESP_OK) {
+        err = httpd_register_uri_handler(server, &set);
+    }
+    return err;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+// "config" console command: list, get, set, commit, reset, bench
+void config_ui_register_console(void);
+
+// GET / (settings page), GET /config (name=value lines), POST /config (key=..&value=..)
+esp_err_t config_ui_register_http(httpd_handle_t server);
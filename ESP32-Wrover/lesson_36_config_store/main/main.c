@@ -0,0 +1,261 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_wifi.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_log.h"
+#include "nvs_flash.h"
+
+#include "esp_http_server.h"
+#include "esp_sntp.h"
+#include "driver/gpio.h"
+#include "driver/uart.h"
+
+#include "config.h"
+#include "config_ui.h"
+#include "console.h"
+#include "commands.h"
+
+#define TXD_PIN GPIO_NUM_4        // UART TX pin
+#define RXD_PIN GPIO_NUM_5        // UART RX pin
+#define UART_PORT UART_NUM_1      // Console on UART1, as in Lesson 33
+#define BOOT_PIN GPIO_NUM_0       // BOOT button on the board
+#define SPARE_PIN GPIO_NUM_13     // Free pin for trying "gpio 13 1"
+
+static const char *TAG = "wifi";
+// Set by wifi_reconnect(), cleared by the STA_DISCONNECTED event that its disconnect causes
+static volatile bool wifi_reconfiguring = false;
+static TaskHandle_t main_task;
+
+// SNTP keeps a pointer to the server name, so it must outlive the call
+static char ntp_server[CONFIG_STR_MAX + 1];
+
+static void load_wifi_config(wifi_config_t *wifi_config)
+{
+    char ssid[CONFIG_STR_MAX + 1], pass[CONFIG_STR_MAX + 1];
+    config_get_str(CONFIG_WIFI_SSID, ssid, sizeof(ssid));
+    config_get_str(CONFIG_WIFI_PASS, pass, sizeof(pass));
+
+    // The config ranges (32 and 63 characters) match the wifi_config_t fields
+    memset(wifi_config, 0, sizeof(*wifi_config));
+    memcpy(wifi_config->sta.ssid, ssid, strlen(ssid));
+    memcpy(wifi_config->sta.password, pass, strlen(pass));
+}
+
+// Callback: Wi-Fi and IP events
+static void on_wifi_event(void* arg, esp_event_base_t event_base,
+                          int32_t event_id, void* event_data)
+{
+    if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
+        ESP_LOGI(TAG, "Connected! IP Address: " IPSTR, IP2STR(&event->ip_info.ip));
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        if (wifi_reconfiguring) {
+            // Our own disconnect: the driver is idle now, so the new credentials can go in
+            wifi_config_t wifi_config;
+            load_wifi_config(&wifi_config);
+            esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+            wifi_reconfiguring = false;
+            ESP_LOGI(TAG, "Connecting to %s...", (char *)wifi_config.sta.ssid);
+        } else {
+            // Keep trying, so wrong credentials can be fixed over the console
+            ESP_LOGW(TAG, "Disconnected, retrying");
+        }
+        esp_wifi_connect();
+    }
+}
+
+// Function to initialize Wi-Fi and attempt connection
+void wifi_connect()
+{
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    esp_netif_create_default_wifi_sta();
+
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    vTaskDelay(pdMS_TO_TICKS(500));
+    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+
+    wifi_config_t wifi_config;
+    load_wifi_config(&wifi_config);
+
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &on_wifi_event, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &on_wifi_event, NULL));
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    ESP_ERROR_CHECK(esp_wifi_start());
+    ESP_ERROR_CHECK(esp_wifi_connect());
+
+    ESP_LOGI(TAG, "Connecting to %s...", (char *)wifi_config.sta.ssid);
+}
+
+// New credentials: drop the current connection. The disconnect event arrives later in
+// the event task, which then loads the new credentials and connects (on_wifi_event).
+static void wifi_reconnect(void)
+{
+    wifi_reconfiguring = true;
+    if (esp_wifi_disconnect() != ESP_OK) {
+        // No event will come: reconfigure and connect here
+        wifi_config_t wifi_config;
+        load_wifi_config(&wifi_config);
+        wifi_reconfiguring = false;
+        esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+        esp_wifi_connect();
+        ESP_LOGI(TAG, "Connecting to %s...", (char *)wifi_config.sta.ssid);
+    }
+}
+
+// ---- Reactions to setting changes (run in the task that made the change) ----
+
+static void apply_timezone(config_key_t key, void *ctx)
+{
+    char tz[CONFIG_STR_MAX + 1];
+    config_get_str(CONFIG_TIMEZONE, tz, sizeof(tz));
+    setenv("TZ", tz, 1);  // Update TZ environment variable
+    tzset();              // Apply the new timezone
+    ESP_LOGI("ntp", "Timezone set to: %s", tz);
+}
+
+static void apply_ntp_server(config_key_t key, void *ctx)
+{
+    esp_sntp_stop();
+    config_get_str(CONFIG_NTP_SERVER, ntp_server, sizeof(ntp_server));
+    esp_sntp_setservername(0, ntp_server);
+    esp_sntp_init();
+}
+
+static void apply_baud(config_key_t key, void *ctx)
+{
+    uart_set_baudrate(UART_PORT, config_get_int(CONFIG_UART_BAUD));
+}
+
+// SSID and password usually change together, so the reconnect waits in app_main()
+static void wifi_changed(config_key_t key, void *ctx)
+{
+    xTaskNotifyGive(main_task);
+}
+
+static void log_change(config_key_t key, void *ctx)
+{
+    char value[CONFIG_STR_MAX + 1];
+    config_format(key, value, sizeof(value));
+    ESP_LOGI("config", "%s changed to %s", config_name(key), value);
+}
+
+// Task: log the local time, as in Lesson 14
+void time_task(void *pvParameters)
+{
+    time_t now = 0;
+    struct tm timeinfo = {0};
+
+    while (1) {
+        time(&now);                            // Get current time
+        localtime_r(&now, &timeinfo);          // Convert to local time
+
+        if (timeinfo.tm_year < (2020 - 1900)) {
+            ESP_LOGI("ntp", "Waiting for NTP time sync...");
+        } else {
+            char buffer[64];
+            strftime(buffer, sizeof(buffer), "%A, %B %d %Y %H:%M:%S %Z (%z)", &timeinfo);
+            ESP_LOGI("ntp", "Current time: %s", buffer);
+        }
+
+        // Read on every pass: a new interval takes effect without a restart
+        vTaskDelay(pdMS_TO_TICKS(config_get_int(CONFIG_TIME_LOG_MS)));
+    }
+}
+
+// Pins the gpio command may touch
+static const commands_gpio_t gpio_pins[] = {
+    { BOOT_PIN,  "BOOT button",     false },
+    { TXD_PIN,   "console UART TX", false },
+    { RXD_PIN,   "console UART RX", false },
+    { SPARE_PIN, "spare",           true },
+};
+
+// ---- Console on UART1 ----
+
+static void uart_write(void *ctx, const char *data, size_t len) {
+    uart_write_bytes(UART_PORT, data, len);
+}
+
+void console_task(void *pvParameter) {
+    // UART configuration, baud rate from the settings
+    uart_config_t uart_config = {
+        .baud_rate = config_get_int(CONFIG_UART_BAUD),
+        .data_bits = UART_DATA_8_BITS,
+        .parity    = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE
+    };
+    uart_param_config(UART_PORT, &uart_config);
+    uart_set_pin(UART_PORT, TXD_PIN, RXD_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    uart_driver_install(UART_PORT, 1024 * 2, 1024 * 2, 0, NULL, 0);
+
+    console_init(uart_write, NULL);
+    commands_register_system();
+    commands_set_gpio_table(gpio_pins, sizeof(gpio_pins) / sizeof(gpio_pins[0]));
+    config_ui_register_console();
+
+    console_printf("\nESP32 console ready, type 'help'\n" CONSOLE_PROMPT);
+
+    char data[64];
+    while (1) {
+        int len = uart_read_bytes(UART_PORT, data, sizeof(data), pdMS_TO_TICKS(20));
+        if (len > 0) {
+            console_feed(data, len);
+        }
+    }
+}
+
+// Starts HTTP server with the settings page
+httpd_handle_t start_webserver(void)
+{
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    httpd_handle_t server = NULL;
+    if (httpd_start(&server, &config) == ESP_OK) {
+        config_ui_register_http(server);
+    }
+    return server;
+}
+
+void app_main(void)
+{
+    ESP_ERROR_CHECK(nvs_flash_init());
+    ESP_ERROR_CHECK(config_init());
+
+    main_task = xTaskGetCurrentTaskHandle();
+    config_subscribe(CONFIG_TIMEZONE, apply_timezone, NULL);
+    config_subscribe(CONFIG_NTP_SERVER, apply_ntp_server, NULL);
+    config_subscribe(CONFIG_UART_BAUD, apply_baud, NULL);
+    config_subscribe(CONFIG_WIFI_SSID, wifi_changed, NULL);
+    config_subscribe(CONFIG_WIFI_PASS, wifi_changed, NULL);
+    config_subscribe(CONFIG_KEY_COUNT, log_change, NULL);
+
+    apply_timezone(CONFIG_TIMEZONE, NULL);
+    xTaskCreate(console_task, "Console Task", 4096, NULL, 5, NULL);
+
+    wifi_connect();
+    start_webserver();
+
+    // SNTP starts now and syncs as soon as Wi-Fi is up
+    config_get_str(CONFIG_NTP_SERVER, ntp_server, sizeof(ntp_server));
+    esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
+    esp_sntp_setservername(0, ntp_server);
+    esp_sntp_init();
+    xTaskCreate(time_task, "Time Task", 4096, NULL, 5, NULL);
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(1000));    // Let the HTTP reply go out and collect the second change
+        ulTaskNotifyTake(pdTRUE, 0);
+        wifi_reconnect();
+    }
+}